@@ -0,0 +1,150 @@
+// Sweeps alltoall and alltoallv algorithms over message sizes, and
+// prints the fastest for each size in tuning table format (see
+// collective/tuning.h).  Redirect rank 0 output to a file and pass
+// it to MPIX_Alltoall/MPIX_Alltoallv through MPIX_TUNING_FILE.
+#include "mpi_advance.h"
+#include <mpi.h>
+#include <math.h>
+#include <stdlib.h>
+#include <iostream>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    // Threaded methods need MPI_THREAD_MULTIPLE (else they fall back)
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+
+    int rank, num_procs;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+
+    int max_i = 15;
+    int max_s = pow(2, max_i);
+    int n_iter = 20;
+    double t0, tfinal;
+    srand(time(NULL));
+    std::vector<char> local_data(max_s*num_procs);
+    std::vector<char> recv_data(max_s*num_procs);
+    std::vector<int> counts(num_procs);
+    std::vector<int> displs(num_procs);
+
+    MPIX_Comm* locality_comm;
+    MPIX_Comm_init(&locality_comm, MPI_COMM_WORLD);
+    MPIX_Comm_topo_init(locality_comm);
+
+    int ppn = locality_comm->ppn;
+    MPI_Allreduce(MPI_IN_PLACE, &ppn, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    int num_nodes = ((num_procs - 1) / ppn) + 1;
+
+    alltoall_ftn alltoall_methods[ALLTOALL_NUM_METHODS] = {
+        alltoall_pairwise,
+        alltoall_nonblocking,
+        alltoall_bruck,
+        alltoall_pairwise_loc,
+        alltoall_nonblocking_loc,
+        alltoall_bruck_loc,
+        alltoall_pipelined_loc,
+        alltoall_nonblocking_window,
+        alltoall_threaded
+    };
+    // ALLTOALLV_PAIRWISE_LOC, ALLTOALLV_HYBRID_LOC, ALLTOALLV_BRUCK_LOC
+    // and ALLTOALLV_THREADED take the MPIX_Comm
+    // (see run_alltoallv)
+    alltoallv_ftn alltoallv_methods[ALLTOALLV_PAIRWISE_LOC] = {
+        alltoallv_pairwise,
+        alltoallv_nonblocking,
+        alltoallv_pairwise_nonblocking,
+        alltoallv_waitany,
+        alltoallv_pairwise_log2,
+        alltoallv_pairwise_nonblocking_log2,
+        alltoallv_sparse,
+        alltoallv_bruck
+    };
+
+    for (int j = 0; j < max_s*num_procs; j++)
+        local_data[j] = rand();
+
+    if (rank == 0) printf("# collective ppn num_nodes max_bytes algorithm\n");
+
+    for (int i = 0; i < max_i; i++)
+    {
+        int s = pow(2, i);
+
+        int best = 0;
+        double best_time = 0;
+        for (int m = 0; m < ALLTOALL_NUM_METHODS; m++)
+        {
+            alltoall_methods[m](local_data.data(), s, MPI_CHAR,
+                    recv_data.data(), s, MPI_CHAR, locality_comm);
+            MPI_Barrier(MPI_COMM_WORLD);
+            t0 = MPI_Wtime();
+            for (int k = 0; k < n_iter; k++)
+                alltoall_methods[m](local_data.data(), s, MPI_CHAR,
+                        recv_data.data(), s, MPI_CHAR, locality_comm);
+            tfinal = (MPI_Wtime() - t0) / n_iter;
+            MPI_Allreduce(MPI_IN_PLACE, &tfinal, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+            if (m == 0 || tfinal < best_time)
+            {
+                best = m;
+                best_time = tfinal;
+            }
+        }
+        if (rank == 0) printf("alltoall %d %d %d %s\n", ppn, num_nodes, s,
+                alltoall_method_names[best]);
+    }
+
+    auto run_alltoallv = [&](int m)
+    {
+        if (m == ALLTOALLV_PAIRWISE_LOC)
+            alltoallv_pairwise_loc(local_data.data(), counts.data(), displs.data(), MPI_CHAR,
+                    recv_data.data(), counts.data(), displs.data(), MPI_CHAR, locality_comm);
+        else if (m == ALLTOALLV_HYBRID_LOC)
+            alltoallv_hybrid_loc(local_data.data(), counts.data(), displs.data(), MPI_CHAR,
+                    recv_data.data(), counts.data(), displs.data(), MPI_CHAR, locality_comm);
+        else if (m == ALLTOALLV_BRUCK_LOC)
+            alltoallv_bruck_loc(local_data.data(), counts.data(), displs.data(), MPI_CHAR,
+                    recv_data.data(), counts.data(), displs.data(), MPI_CHAR, locality_comm);
+        else if (m == ALLTOALLV_THREADED)
+            alltoallv_threaded(local_data.data(), counts.data(), displs.data(), MPI_CHAR,
+                    recv_data.data(), counts.data(), displs.data(), MPI_CHAR, locality_comm);
+        else
+            alltoallv_methods[m](local_data.data(), counts.data(), displs.data(), MPI_CHAR,
+                    recv_data.data(), counts.data(), displs.data(), MPI_CHAR, MPI_COMM_WORLD);
+    };
+
+    for (int i = 0; i < max_i; i++)
+    {
+        int s = pow(2, i);
+        for (int j = 0; j < num_procs; j++)
+        {
+            counts[j] = s;
+            displs[j] = j*s;
+        }
+
+        int best = 0;
+        double best_time = 0;
+        for (int m = 0; m < ALLTOALLV_NUM_METHODS; m++)
+        {
+            run_alltoallv(m);
+            MPI_Barrier(MPI_COMM_WORLD);
+            t0 = MPI_Wtime();
+            for (int k = 0; k < n_iter; k++)
+                run_alltoallv(m);
+            tfinal = (MPI_Wtime() - t0) / n_iter;
+            MPI_Allreduce(MPI_IN_PLACE, &tfinal, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+            if (m == 0 || tfinal < best_time)
+            {
+                best = m;
+                best_time = tfinal;
+            }
+        }
+        if (rank == 0) printf("alltoallv %d %d %d %s\n", ppn, num_nodes, s,
+                alltoallv_method_names[best]);
+    }
+
+    MPIX_Comm_free(&locality_comm);
+
+    MPI_Finalize();
+    return 0;
+}
@@ -1,6 +1,8 @@
 #include "alltoall.h"
+#include "tuning.h"
 #include <string.h>
 #include <math.h>
+#include <limits.h>
 
 #ifdef GPU
 #include "heterogeneous/gpu_alltoall.h"
@@ -19,6 +21,8 @@
  *  - Finally, redistribute received data
  *      on-node so that each process holds
  *      the correct final data
+ *  - Algorithm may be overridden by a tuning 
+ *      table (see tuning.h)
  *************************************************/
 int MPIX_Alltoall(const void* sendbuf,
         const int sendcount,
@@ -55,7 +59,33 @@ int MPIX_Alltoall(const void* sendbuf,
                 mpi_comm);
     }
 #endif
-    return alltoall_pairwise(sendbuf,
+    int bytes;
+    if (sendbuf == MPI_IN_PLACE)
+    {
+        MPI_Type_size(recvtype, &bytes);
+        bytes *= recvcount;
+    }
+    else
+    {
+        MPI_Type_size(sendtype, &bytes);
+        bytes *= sendcount;
+    }
+
+    // Indexed by AlltoallMethod (tuning.h)
+    alltoall_ftn methods[ALLTOALL_NUM_METHODS] = {
+        alltoall_pairwise,
+        alltoall_nonblocking,
+        alltoall_bruck,
+        alltoall_pairwise_loc,
+        alltoall_nonblocking_loc,
+        alltoall_bruck_loc,
+        alltoall_pipelined_loc,
+        alltoall_nonblocking_window,
+        alltoall_threaded
+    };
+    int method = select_alltoall_method(mpi_comm, bytes);
+
+    return methods[method](sendbuf,
         sendcount,
         sendtype,
         recvbuf,
@@ -64,6 +94,95 @@ int MPIX_Alltoall(const void* sendbuf,
         mpi_comm);
 }
 
+// Aggregating algorithms treat blocks as contiguous bytes
+static int contiguous_types(const void* sendbuf, MPI_Datatype sendtype,
+        MPI_Datatype recvtype)
+{
+    return (sendbuf == MPI_IN_PLACE || MPIX_Type_is_contiguous(sendtype))
+            && MPIX_Type_is_contiguous(recvtype);
+}
+
+/**************************************************
+ * Packed Alltoall
+ *  - For datatypes with holes or a nonzero lower 
+ *      bound : packs send data into contiguous 
+ *      bytes (datatype engine), runs alltoall 'f'
+ *      in place on MPI_BYTE blocks, and unpacks
+ *      the result into recvbuf
+ *************************************************/
+int alltoall_packed(alltoall_ftn f,
+        const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm)
+{
+    int num_procs;
+    MPI_Comm_size(comm->global_comm, &num_procs);
+
+    int recv_size;
+    MPI_Type_size(recvtype, &recv_size);
+    int bytes = recvcount * recv_size;
+
+    char* packed_buf = (char*)malloc((size_t)num_procs*bytes*sizeof(char));
+    if (sendbuf == MPI_IN_PLACE)
+        MPIX_Type_pack(recvbuf, num_procs * recvcount, recvtype, packed_buf);
+    else
+        MPIX_Type_pack(sendbuf, num_procs * sendcount, sendtype, packed_buf);
+
+    int ierr = f(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+            packed_buf, bytes, MPI_BYTE, comm);
+
+    MPIX_Type_unpack(packed_buf, recvbuf, num_procs * recvcount, recvtype);
+    free(packed_buf);
+
+    return ierr;
+}
+
+/**************************************************
+ * Big-Count Alltoall
+ *  - Counts that fit in int use MPIX_Alltoall
+ *      (offsets are computed in MPI_Aint, so 
+ *      buffers may exceed 2 GiB)
+ *  - Larger blocks go through MPIX_Alltoallv_c
+ *************************************************/
+int MPIX_Alltoall_c(const void* sendbuf,
+        const MPI_Count sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const MPI_Count recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* mpi_comm)
+{
+    if (sendcount <= INT_MAX && recvcount <= INT_MAX)
+        return MPIX_Alltoall(sendbuf, sendcount, sendtype,
+                recvbuf, recvcount, recvtype, mpi_comm);
+
+    int num_procs;
+    MPI_Comm_size(mpi_comm->global_comm, &num_procs);
+
+    MPI_Count* counts = (MPI_Count*)malloc(2*num_procs*sizeof(MPI_Count));
+    MPI_Aint* displs = (MPI_Aint*)malloc(2*num_procs*sizeof(MPI_Aint));
+    for (int i = 0; i < num_procs; i++)
+    {
+        counts[i] = sendcount;
+        displs[i] = i * sendcount;
+        counts[num_procs + i] = recvcount;
+        displs[num_procs + i] = i * recvcount;
+    }
+
+    int ierr = MPIX_Alltoallv_c(sendbuf, counts, displs, sendtype,
+            recvbuf, counts + num_procs, displs + num_procs, recvtype, 
+            mpi_comm);
+
+    free(counts);
+    free(displs);
+
+    return ierr;
+}
+
 int alltoall_pairwise(const void* sendbuf,
         const int sendcount,
         MPI_Datatype sendtype,
@@ -72,21 +191,28 @@ int alltoall_pairwise(const void* sendbuf,
         MPI_Datatype recvtype,
         MPIX_Comm* comm)
 {
+    if (sendbuf == MPI_IN_PLACE)
+        return alltoall_pairwise_inplace(recvbuf, recvcount, recvtype, comm);
+
     int rank, num_procs;
     MPI_Comm_rank(comm->global_comm, &rank);
     MPI_Comm_size(comm->global_comm, &num_procs);
 
     int tag = 102944;
     int send_proc, recv_proc;
-    int send_pos, recv_pos;
+    MPI_Aint send_pos, recv_pos;
     MPI_Status status;
 
     char* recv_buffer = (char*)recvbuf;
     char* send_buffer = (char*)sendbuf;
 
-    int send_size, recv_size;
-    MPI_Type_size(sendtype, &send_size);
-    MPI_Type_size(recvtype, &recv_size);
+    // Element i of a buffer starts at i * extent (datatype engine)
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
+
+    const int* send_procs;
+    const int* recv_procs;
+    MPIX_Comm_peer_schedule(comm, &send_procs, &recv_procs);
 
 #ifdef GPU
     gpuMemoryType send_type, recv_type;
@@ -97,31 +223,29 @@ int alltoall_pairwise(const void* sendbuf,
             recv_type == gpuMemoryTypeDevice)
     {
         get_memcpy_kind(send_type, recv_type, &memcpy_kind);
-        int ierr = gpuMemcpy(recv_buffer + (rank * recvcount * recv_size),
-                send_buffer + (rank * sendcount * send_size),
-                sendcount * send_size,
+        int ierr = gpuMemcpy(recv_buffer + ((MPI_Aint)rank * recvcount * recv_extent),
+                send_buffer + ((MPI_Aint)rank * sendcount * send_extent),
+                sendcount * send_extent,
                 memcpy_kind);
         gpu_check(ierr);
     }
     else
 #endif
-    memcpy(recv_buffer + (rank * recvcount * recv_size),
-        send_buffer + (rank * sendcount * send_size),
-        sendcount * send_size);
+    MPIX_Type_copy(send_buffer + ((MPI_Aint)rank * sendcount * send_extent),
+        sendcount, sendtype,
+        recv_buffer + ((MPI_Aint)rank * recvcount * recv_extent),
+        recvcount, recvtype);
 
 
-    // Send to rank + i
-    // Recv from rank - i
+    // Send to send_procs[i]
+    // Recv from recv_procs[i]
+    // (rank + i / rank - i unless comm->peer_schedule is set)
     for (int i = 1; i < num_procs; i++)
     {
-        send_proc = rank + i;
-        if (send_proc >= num_procs)
-            send_proc -= num_procs;
-        recv_proc = rank - i;
-        if (recv_proc < 0)
-            recv_proc += num_procs;
-        send_pos = send_proc * sendcount * send_size;
-        recv_pos = recv_proc * recvcount * recv_size;
+        send_proc = send_procs[i];
+        recv_proc = recv_procs[i];
+        send_pos = (MPI_Aint)send_proc * sendcount * send_extent;
+        recv_pos = (MPI_Aint)recv_proc * recvcount * recv_extent;
 
         MPI_Sendrecv(send_buffer + send_pos, 
                 sendcount, 
@@ -139,6 +263,72 @@ int alltoall_pairwise(const void* sendbuf,
     return MPI_SUCCESS;
 }
 
+/**************************************************
+ * In-Place Pairwise Alltoall (MPI_IN_PLACE)
+ *  - At round r, exchanges with (r - rank) mod p :
+ *      pairing is symmetric, so both processes
+ *      swap their blocks at once
+ *  - Outgoing block is copied to a single block of
+ *      scratch, then replaced by incoming block
+ *************************************************/
+int alltoall_pairwise_inplace(void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(comm->global_comm, &rank);
+    MPI_Comm_size(comm->global_comm, &num_procs);
+
+    int tag = 102944;
+    int proc;
+    MPI_Aint pos;
+    MPI_Status status;
+
+    char* recv_buffer = (char*)recvbuf;
+
+    // Scratch spans one block (only bytes in the type map are copied)
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
+    MPI_Aint block_extent = recvcount * recv_extent;
+    MPI_Aint true_lb, true_extent;
+    MPI_Type_get_true_extent(recvtype, &true_lb, &true_extent);
+    MPI_Aint span = 0;
+    if (recvcount)
+        span = block_extent - recv_extent + true_extent;
+
+    char* scratch = (char*)malloc(span*sizeof(char));
+    char* scratch_block = scratch - true_lb;
+
+    for (int r = 0; r < num_procs; r++)
+    {
+        proc = r - rank;
+        if (proc < 0)
+            proc += num_procs;
+        if (proc == rank)
+            continue;
+        pos = proc * block_extent;
+
+        MPIX_Type_copy(recv_buffer + pos, recvcount, recvtype,
+                scratch_block, recvcount, recvtype);
+        MPI_Sendrecv(scratch_block, 
+                recvcount, 
+                recvtype, 
+                proc, 
+                tag,
+                recv_buffer + pos, 
+                recvcount, 
+                recvtype, 
+                proc, 
+                tag,
+                comm->global_comm, 
+                &status);
+    }
+
+    free(scratch);
+
+    return MPI_SUCCESS;
+}
+
 int alltoall_nonblocking(const void* sendbuf,
         const int sendcount,
         MPI_Datatype sendtype,
@@ -147,22 +337,31 @@ int alltoall_nonblocking(const void* sendbuf,
         MPI_Datatype recvtype,
         MPIX_Comm* comm)
 {
+    if (sendbuf == MPI_IN_PLACE)
+        return alltoall_pairwise_inplace(recvbuf, recvcount, recvtype, comm);
+
     int rank, num_procs;
     MPI_Comm_rank(comm->global_comm, &rank);
     MPI_Comm_size(comm->global_comm, &num_procs);
 
     int tag = 102944;
     int send_proc, recv_proc;
-    int send_pos, recv_pos;
+    MPI_Aint send_pos, recv_pos;
 
     char* recv_buffer = (char*)recvbuf;
     char* send_buffer = (char*)sendbuf;
 
-    int send_size, recv_size;
-    MPI_Type_size(sendtype, &send_size);
-    MPI_Type_size(recvtype, &recv_size);
+    // Element i of a buffer starts at i * extent (datatype engine)
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
+
+    const int* send_procs;
+    const int* recv_procs;
+    MPIX_Comm_peer_schedule(comm, &send_procs, &recv_procs);
 
-    MPI_Request* requests = (MPI_Request*)malloc(2*(num_procs-1)*sizeof(MPI_Request));
+    if (2*(num_procs-1) > comm->n_requests)
+        MPIX_Comm_req_resize(comm, 2*(num_procs-1));
+    MPI_Request* requests = comm->requests;
 
 #ifdef GPU
     gpuMemoryType send_type, recv_type;
@@ -173,30 +372,28 @@ int alltoall_nonblocking(const void* sendbuf,
             recv_type == gpuMemoryTypeDevice)
     {
         get_memcpy_kind(send_type, recv_type, &memcpy_kind);
-        int ierr = gpuMemcpy(recv_buffer + (rank * recvcount * recv_size),
-                send_buffer + (rank * sendcount * send_size),
-                sendcount * send_size,
+        int ierr = gpuMemcpy(recv_buffer + ((MPI_Aint)rank * recvcount * recv_extent),
+                send_buffer + ((MPI_Aint)rank * sendcount * send_extent),
+                sendcount * send_extent,
                 memcpy_kind);
         gpu_check(ierr);
     }
     else
 #endif
-    memcpy(recv_buffer + (rank * recvcount * recv_size),
-        send_buffer + (rank * sendcount * send_size),
-        sendcount * send_size);
+    MPIX_Type_copy(send_buffer + ((MPI_Aint)rank * sendcount * send_extent),
+        sendcount, sendtype,
+        recv_buffer + ((MPI_Aint)rank * recvcount * recv_extent),
+        recvcount, recvtype);
 
-    // Send to rank + i
-    // Recv from rank - i
+    // Send to send_procs[i]
+    // Recv from recv_procs[i]
+    // (rank + i / rank - i unless comm->peer_schedule is set)
     for (int i = 1; i < num_procs; i++)
     {
-        send_proc = rank + i;
-        if (send_proc >= num_procs)
-            send_proc -= num_procs;
-        recv_proc = rank - i;
-        if (recv_proc < 0)
-            recv_proc += num_procs;
-        send_pos = send_proc * sendcount * send_size;
-        recv_pos = recv_proc * recvcount * recv_size;
+        send_proc = send_procs[i];
+        recv_proc = recv_procs[i];
+        send_pos = (MPI_Aint)send_proc * sendcount * send_extent;
+        recv_pos = (MPI_Aint)recv_proc * recvcount * recv_extent;
 
         MPI_Isend(send_buffer + send_pos,
                 sendcount, 
@@ -216,7 +413,1020 @@ int alltoall_nonblocking(const void* sendbuf,
 
     MPI_Waitall(2*(num_procs-1), requests, MPI_STATUSES_IGNORE);
 
-    free(requests);
     return 0;
 }
 
+/**************************************************
+ * Bounded-Window Nonblocking Alltoall
+ *  - Keeps at most comm->window_size sends and
+ *      window_size receives in flight (set with
+ *      MPIX_Comm_info_init)
+ *  - As each send (or receive) completes, its slot
+ *      is refilled with the next send (or receive)
+ *      of the peer schedule
+ *  - Requests come from comm->requests
+ *************************************************/
+int alltoall_nonblocking_window(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm)
+{
+    if (sendbuf == MPI_IN_PLACE)
+        return alltoall_pairwise_inplace(recvbuf, recvcount, recvtype, comm);
+
+    int rank, num_procs;
+    MPI_Comm_rank(comm->global_comm, &rank);
+    MPI_Comm_size(comm->global_comm, &num_procs);
+
+    int tag = 102944;
+    int send_proc, recv_proc;
+    MPI_Aint send_pos, recv_pos;
+
+    char* recv_buffer = (char*)recvbuf;
+    char* send_buffer = (char*)sendbuf;
+
+    // Element i of a buffer starts at i * extent (datatype engine)
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
+
+    const int* send_procs;
+    const int* recv_procs;
+    MPIX_Comm_peer_schedule(comm, &send_procs, &recv_procs);
+
+    int window = comm->window_size;
+    if (window <= 0 || window > num_procs - 1)
+        window = num_procs - 1;
+
+    // Slots [0, window) : sends, [window, 2*window) : receives
+    if (2*window > comm->n_requests)
+        MPIX_Comm_req_resize(comm, 2*window);
+    MPI_Request* requests = comm->requests;
+
+#ifdef GPU
+    gpuMemoryType send_type, recv_type;
+    gpuMemcpyKind memcpy_kind;
+    get_mem_types(sendbuf, recvbuf, &send_type, &recv_type);
+
+    if (send_type == gpuMemoryTypeDevice ||
+            recv_type == gpuMemoryTypeDevice)
+    {
+        get_memcpy_kind(send_type, recv_type, &memcpy_kind);
+        int ierr = gpuMemcpy(recv_buffer + ((MPI_Aint)rank * recvcount * recv_extent),
+                send_buffer + ((MPI_Aint)rank * sendcount * send_extent),
+                sendcount * send_extent,
+                memcpy_kind);
+        gpu_check(ierr);
+    }
+    else
+#endif
+    MPIX_Type_copy(send_buffer + ((MPI_Aint)rank * sendcount * send_extent),
+        sendcount, sendtype,
+        recv_buffer + ((MPI_Aint)rank * recvcount * recv_extent),
+        recvcount, recvtype);
+
+    if (num_procs == 1)
+        return 0;
+
+    // Fill window with first steps
+    // Send to send_procs[i]
+    // Recv from recv_procs[i]
+    // (rank + i / rank - i unless comm->peer_schedule is set)
+    for (int i = 1; i <= window; i++)
+    {
+        send_proc = send_procs[i];
+        recv_proc = recv_procs[i];
+        send_pos = (MPI_Aint)send_proc * sendcount * send_extent;
+        recv_pos = (MPI_Aint)recv_proc * recvcount * recv_extent;
+
+        MPI_Isend(send_buffer + send_pos,
+                sendcount, 
+                sendtype, 
+                send_proc,
+                tag, 
+                comm->global_comm,
+                &(requests[i-1]));
+        MPI_Irecv(recv_buffer + recv_pos,
+                recvcount,
+                recvtype,
+                recv_proc,
+                tag,
+                comm->global_comm,
+                &(requests[window + i - 1]));
+    }
+
+    // Refill slots as they complete
+    int send_idx = window + 1;
+    int recv_idx = window + 1;
+    int idx;
+    while (1)
+    {
+        MPI_Waitany(2*window, requests, &idx, MPI_STATUS_IGNORE);
+
+        if (idx == MPI_UNDEFINED)
+            break;
+
+        if (idx < window && send_idx < num_procs)
+        {
+            send_proc = send_procs[send_idx];
+            send_pos = (MPI_Aint)send_proc * sendcount * send_extent;
+            MPI_Isend(send_buffer + send_pos,
+                    sendcount,
+                    sendtype,
+                    send_proc,
+                    tag,
+                    comm->global_comm,
+                    &(requests[idx]));
+            send_idx++;
+        }
+        else if (idx >= window && recv_idx < num_procs)
+        {
+            recv_proc = recv_procs[recv_idx];
+            recv_pos = (MPI_Aint)recv_proc * recvcount * recv_extent;
+            MPI_Irecv(recv_buffer + recv_pos,
+                    recvcount,
+                    recvtype,
+                    recv_proc,
+                    tag,
+                    comm->global_comm,
+                    &(requests[idx]));
+            recv_idx++;
+        }
+    }
+
+    return 0;
+}
+
+
+int alltoall_pairwise_loc(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm)
+{
+    if (!contiguous_types(sendbuf, sendtype, recvtype))
+        return alltoall_packed(alltoall_pairwise_loc, sendbuf, sendcount, sendtype,
+                recvbuf, recvcount, recvtype, comm);
+
+    return alltoall_loc(alltoallv_pairwise,
+        node_exchange_pairwise,
+        sendbuf,
+        sendcount,
+        sendtype,
+        recvbuf,
+        recvcount,
+        recvtype,
+        comm);
+}
+
+int alltoall_nonblocking_loc(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm)
+{
+    if (!contiguous_types(sendbuf, sendtype, recvtype))
+        return alltoall_packed(alltoall_nonblocking_loc, sendbuf, sendcount, sendtype,
+                recvbuf, recvcount, recvtype, comm);
+
+    return alltoall_loc(alltoallv_nonblocking,
+        node_exchange_nonblocking,
+        sendbuf,
+        sendcount,
+        sendtype,
+        recvbuf,
+        recvcount,
+        recvtype,
+        comm);
+}
+
+/**************************************************
+ * Multithreaded Alltoall
+ *  - OpenMP threads split the steps of the peer 
+ *      schedule, each with its own slice of 
+ *      comm->requests and its own packing (see
+ *      alltoallv_threaded)
+ *  - Falls back to alltoall_nonblocking without
+ *      OpenMP, MPI_THREAD_MULTIPLE, or more than
+ *      one thread
+ *************************************************/
+int alltoall_threaded(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(comm->global_comm, &rank);
+    MPI_Comm_size(comm->global_comm, &num_procs);
+
+    int num_threads = threaded_num_threads(comm->global_comm);
+    if (sendbuf == MPI_IN_PLACE || num_threads < 2)
+        return alltoall_nonblocking(sendbuf, sendcount, sendtype,
+                recvbuf, recvcount, recvtype, comm);
+
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
+
+    const char* send_buffer = (const char*)sendbuf;
+    char* recv_buffer = (char*)recvbuf;
+
+    MPIX_Type_copy(send_buffer + ((MPI_Aint)rank * sendcount * send_extent),
+        sendcount, sendtype,
+        recv_buffer + ((MPI_Aint)rank * recvcount * recv_extent),
+        recvcount, recvtype);
+
+    int* sendcounts = (int*)malloc(num_procs*sizeof(int));
+    int* recvcounts = (int*)malloc(num_procs*sizeof(int));
+    MPI_Aint* send_pos = (MPI_Aint*)malloc(num_procs*sizeof(MPI_Aint));
+    MPI_Aint* recv_pos = (MPI_Aint*)malloc(num_procs*sizeof(MPI_Aint));
+    for (int i = 0; i < num_procs; i++)
+    {
+        sendcounts[i] = sendcount;
+        recvcounts[i] = recvcount;
+        send_pos[i] = (MPI_Aint)i * sendcount * send_extent;
+        recv_pos[i] = (MPI_Aint)i * recvcount * recv_extent;
+    }
+
+    const int* send_procs;
+    const int* recv_procs;
+    MPIX_Comm_peer_schedule(comm, &send_procs, &recv_procs);
+
+    if (2*(num_procs-1) > comm->n_requests)
+        MPIX_Comm_req_resize(comm, 2*(num_procs-1));
+
+    threaded_exchange(send_buffer, sendcounts, send_pos, sendtype,
+            recv_buffer, recvcounts, recv_pos, recvtype,
+            send_procs, recv_procs, num_threads, comm->requests,
+            comm->global_comm);
+
+    free(sendcounts);
+    free(recvcounts);
+    free(send_pos);
+    free(recv_pos);
+
+    return MPI_SUCCESS;
+}
+
+/**************************************************
+ * Bruck Alltoall
+ *  - log2(p) steps, each sending about half of 
+ *      the data
+ *  - Best for small messages, where latency
+ *      dominates the cost of the alltoall
+ *************************************************/
+int alltoall_bruck(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm)
+{
+    if (!contiguous_types(sendbuf, sendtype, recvtype))
+        return alltoall_packed(alltoall_bruck, sendbuf, sendcount, sendtype,
+                recvbuf, recvcount, recvtype, comm);
+
+    int num_procs;
+    MPI_Comm_size(comm->global_comm, &num_procs);
+
+    // MPI_IN_PLACE : sendbuf is fully copied into temporary 
+    // buffers before recvbuf is written
+    const char* send_buffer = (const char*)sendbuf;
+    int bytes;
+    if (sendbuf == MPI_IN_PLACE)
+    {
+        send_buffer = (const char*)recvbuf;
+        MPI_Type_size(recvtype, &bytes);
+        bytes *= recvcount;
+    }
+    else
+    {
+        MPI_Type_size(sendtype, &bytes);
+        bytes *= sendcount;
+    }
+
+    // Rotated buffers are exchanged as MPI_BYTE counts
+    if ((long)num_procs * bytes > INT_MAX)
+        return alltoall_pairwise(sendbuf, sendcount, sendtype,
+                recvbuf, recvcount, recvtype, comm);
+
+    return bruck_helper(send_buffer,
+            (char*)recvbuf,
+            bytes,
+            comm->global_comm);
+}
+
+int bruck_helper(const char* sendbuf,
+        char* recvbuf,
+        const int bytes,
+        MPI_Comm comm)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &num_procs);
+
+    int tag = 102946;
+    int send_proc, recv_proc;
+    int ctr;
+    MPI_Status status;
+
+    char* tmpbuf = (char*)malloc(num_procs*bytes*sizeof(char));
+    char* contig_buf = (char*)malloc(num_procs*bytes*sizeof(char));
+
+    // 1. Rotate so that block i is sent to rank + i
+    memcpy(tmpbuf, sendbuf, num_procs*bytes);
+    rotate(tmpbuf, rank*bytes, num_procs*bytes);
+
+    // 2. At step k, send each block with bit k set to rank + k
+    //      (recvbuf holds incoming blocks until unpacked)
+    for (int k = 1; k < num_procs; k <<= 1)
+    {
+        send_proc = rank + k;
+        if (send_proc >= num_procs)
+            send_proc -= num_procs;
+        recv_proc = rank - k;
+        if (recv_proc < 0)
+            recv_proc += num_procs;
+
+        ctr = 0;
+        for (int i = k; i < num_procs; i++)
+        {
+            if (i & k)
+            {
+                memcpy(contig_buf + ctr, tmpbuf + i*bytes, bytes);
+                ctr += bytes;
+            }
+        }
+
+        MPI_Sendrecv(contig_buf,
+                ctr,
+                MPI_BYTE,
+                send_proc,
+                tag,
+                recvbuf,
+                ctr,
+                MPI_BYTE,
+                recv_proc,
+                tag,
+                comm,
+                &status);
+
+        ctr = 0;
+        for (int i = k; i < num_procs; i++)
+        {
+            if (i & k)
+            {
+                memcpy(tmpbuf + i*bytes, recvbuf + ctr, bytes);
+                ctr += bytes;
+            }
+        }
+    }
+
+    // 3. Block i now holds data from rank - i
+    //      Reverse and rotate so block j holds data from j
+    reverse(tmpbuf, num_procs*bytes, bytes);
+    rotate(tmpbuf, (num_procs - rank - 1)*bytes, num_procs*bytes);
+    memcpy(recvbuf, tmpbuf, num_procs*bytes);
+
+    free(tmpbuf);
+    free(contig_buf);
+
+    return MPI_SUCCESS;
+}
+
+/**************************************************
+ * Locality-Aware Bruck Alltoall (two-level)
+ *  - Gathers all data on-node to a single leader
+ *      (local rank 0)
+ *  - Leaders perform Bruck alltoall over group_comm
+ *      with one block per node pair
+ *  - Leaders scatter received data on-node
+ *  - If leader_comm is initialized, each leader 
+ *      aggregates its leader_comm rather than the node
+ *  - Assumes SMP ordering and equal PPN, otherwise 
+ *      falls back to alltoall_bruck
+ *************************************************/
+int alltoall_bruck_loc(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm)
+{
+    if (!contiguous_types(sendbuf, sendtype, recvtype))
+        return alltoall_packed(alltoall_bruck_loc, sendbuf, sendcount, sendtype,
+                recvbuf, recvcount, recvtype, comm);
+
+    int rank, num_procs;
+    MPI_Comm_rank(comm->global_comm, &rank);
+    MPI_Comm_size(comm->global_comm, &num_procs);
+
+    if (comm->local_comm == MPI_COMM_NULL)
+        MPIX_Comm_topo_init(comm);
+
+    // With multiple leaders per node, each leader's group acts as a node
+    MPI_Comm local_comm, group_comm;
+    get_aggregation_comms(comm, &local_comm, &group_comm);
+
+    int local_rank, ppn, num_nodes;
+    MPI_Comm_rank(local_comm, &local_rank);
+    MPI_Comm_size(local_comm, &ppn);
+    MPI_Comm_size(group_comm, &num_nodes);
+
+    // Nodes split evenly in SMP order (checked once per comm)
+    if (!MPIX_Comm_uniform(comm) || ppn == 1 || num_nodes == 1)
+        return alltoall_bruck(sendbuf, sendcount, sendtype,
+                recvbuf, recvcount, recvtype, comm);
+
+    // MPI_IN_PLACE : recvbuf is gathered to the leader
+    // before it is written by the scatter
+    const void* send_buffer = sendbuf;
+    int bytes;
+    if (sendbuf == MPI_IN_PLACE)
+    {
+        send_buffer = recvbuf;
+        MPI_Type_size(recvtype, &bytes);
+        bytes *= recvcount;
+    }
+    else
+    {
+        MPI_Type_size(sendtype, &bytes);
+        bytes *= sendcount;
+    }
+
+    // Leader buffers are exchanged as MPI_BYTE counts
+    if ((long)ppn * num_procs * bytes > INT_MAX)
+        return alltoall_pairwise(sendbuf, sendcount, sendtype,
+                recvbuf, recvcount, recvtype, comm);
+    int proc_bytes = num_procs * bytes;
+
+    char* tmpbuf = NULL;
+    char* contig_buf = NULL;
+    if (local_rank == 0)
+    {
+        tmpbuf = (char*)malloc(ppn*proc_bytes*sizeof(char));
+        contig_buf = (char*)malloc(ppn*proc_bytes*sizeof(char));
+    }
+
+    // 1. Gather all data on-node to leader
+    //      tmpbuf : [local_src][node][local_dest]
+    MPI_Gather(send_buffer, proc_bytes, MPI_BYTE, 
+            tmpbuf, proc_bytes, MPI_BYTE,
+            0, local_comm);
+
+    if (local_rank == 0)
+    {
+        // 2. Bruck among leaders, one block per node
+        //      contig_buf : [node][local_src][local_dest]
+        repack(ppn, num_nodes, ppn*bytes, tmpbuf, contig_buf);
+        bruck_helper(contig_buf, tmpbuf, ppn*ppn*bytes, group_comm);
+
+        // tmpbuf : [node][src][local_dest]
+        // contig_buf : [local_dest][node][src]
+        repack(num_nodes*ppn, ppn, bytes, tmpbuf, contig_buf);
+    }
+
+    // 3. Scatter on-node to final destination
+    MPI_Scatter(contig_buf, proc_bytes, MPI_BYTE,
+            recvbuf, proc_bytes, MPI_BYTE,
+            0, local_comm);
+
+    if (local_rank == 0)
+    {
+        free(tmpbuf);
+        free(contig_buf);
+    }
+
+    return MPI_SUCCESS;
+}
+
+// Exchange aggregated node blocks with each node assigned to this rank
+// Node pairs are assigned symmetrically, so the matching process on 
+// node 'i' is the process with the same local rank (group_comm rank i)
+int node_exchange_pairwise(const char* sendbuf,
+        char* recvbuf,
+        const int* node_pos,
+        const int bytes,
+        MPI_Comm group_comm)
+{
+    int rank_node, num_nodes;
+    MPI_Comm_rank(group_comm, &rank_node);
+    MPI_Comm_size(group_comm, &num_nodes);
+
+    int tag = 102945;
+    int send_node, recv_node;
+    int n_msgs;
+    MPI_Request requests[2];
+
+    if (node_pos[rank_node] >= 0)
+        memcpy(recvbuf + (node_pos[rank_node] * bytes),
+                sendbuf + (node_pos[rank_node] * bytes),
+                bytes);
+
+    // Send to node + i
+    // Recv from node - i
+    for (int i = 1; i < num_nodes; i++)
+    {
+        send_node = rank_node + i;
+        if (send_node >= num_nodes)
+            send_node -= num_nodes;
+        recv_node = rank_node - i;
+        if (recv_node < 0)
+            recv_node += num_nodes;
+
+        n_msgs = 0;
+        if (node_pos[recv_node] >= 0)
+            MPI_Irecv(recvbuf + (node_pos[recv_node] * bytes),
+                    bytes,
+                    MPI_BYTE,
+                    recv_node,
+                    tag,
+                    group_comm,
+                    &(requests[n_msgs++]));
+        if (node_pos[send_node] >= 0)
+            MPI_Isend(sendbuf + (node_pos[send_node] * bytes),
+                    bytes,
+                    MPI_BYTE,
+                    send_node,
+                    tag,
+                    group_comm,
+                    &(requests[n_msgs++]));
+
+        if (n_msgs)
+            MPI_Waitall(n_msgs, requests, MPI_STATUSES_IGNORE);
+    }
+
+    return MPI_SUCCESS;
+}
+
+int node_exchange_nonblocking(const char* sendbuf,
+        char* recvbuf,
+        const int* node_pos,
+        const int bytes,
+        MPI_Comm group_comm)
+{
+    int rank_node, num_nodes;
+    MPI_Comm_rank(group_comm, &rank_node);
+    MPI_Comm_size(group_comm, &num_nodes);
+
+    int tag = 102945;
+    int n_msgs, pos;
+
+    MPI_Request* requests = (MPI_Request*)malloc(2*num_nodes*sizeof(MPI_Request));
+
+    n_msgs = 0;
+    for (int i = 0; i < num_nodes; i++)
+    {
+        pos = node_pos[i];
+        if (pos < 0) continue;
+
+        if (i == rank_node)
+        {
+            memcpy(recvbuf + (pos * bytes),
+                    sendbuf + (pos * bytes),
+                    bytes);
+            continue;
+        }
+
+        MPI_Irecv(recvbuf + (pos * bytes),
+                bytes,
+                MPI_BYTE,
+                i,
+                tag,
+                group_comm,
+                &(requests[n_msgs++]));
+        MPI_Isend(sendbuf + (pos * bytes),
+                bytes,
+                MPI_BYTE,
+                i,
+                tag,
+                group_comm,
+                &(requests[n_msgs++]));
+    }
+
+    if (n_msgs)
+        MPI_Waitall(n_msgs, requests, MPI_STATUSES_IGNORE);
+
+    free(requests);
+    return MPI_SUCCESS;
+}
+
+/**************************************************
+ * Locality-Aware Alltoall (three-step)
+ *  - Each pair of nodes (A, B) is assigned to the 
+ *      local rank (A + B) % PPN on both nodes, so 
+ *      there is exactly one message per node pair
+ *  - local_f : on-node exchange (local_comm)
+ *  - global_f : inter-node exchange (group_comm)
+ *  - If leader_comm is initialized (MPIX_Comm_leader_init),
+ *      leader_comm and leader_group_comm replace
+ *      local_comm and group_comm, spreading inter-node
+ *      messages across multiple leaders per node
+ *  - Assumes SMP ordering and equal PPN, otherwise 
+ *      falls back to alltoall_pairwise
+ *************************************************/
+int alltoall_loc(alltoallv_ftn local_f,
+        node_exchange_ftn global_f,
+        const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(comm->global_comm, &rank);
+    MPI_Comm_size(comm->global_comm, &num_procs);
+
+    if (comm->local_comm == MPI_COMM_NULL)
+        MPIX_Comm_topo_init(comm);
+
+    // With multiple leaders per node, each leader's group acts as a node
+    MPI_Comm local_comm, group_comm;
+    get_aggregation_comms(comm, &local_comm, &group_comm);
+
+    int local_rank, ppn, num_nodes;
+    MPI_Comm_rank(local_comm, &local_rank);
+    MPI_Comm_size(local_comm, &ppn);
+    MPI_Comm_size(group_comm, &num_nodes);
+
+    // Nodes split evenly in SMP order (checked once per comm)
+    if (!MPIX_Comm_uniform(comm) || ppn == 1 || num_nodes == 1)
+        return alltoall_pairwise(sendbuf, sendcount, sendtype,
+                recvbuf, recvcount, recvtype, comm);
+
+    int rank_node;
+    MPI_Comm_rank(group_comm, &rank_node);
+
+    char* recv_buffer = (char*)recvbuf;
+    char* send_buffer = (char*)sendbuf;
+
+    // MPI_IN_PLACE : recvbuf is fully copied into temporary 
+    // buffers before it is written
+    int bytes;
+    if (sendbuf == MPI_IN_PLACE)
+    {
+        send_buffer = recv_buffer;
+        MPI_Type_size(recvtype, &bytes);
+        bytes *= recvcount;
+    }
+    else
+    {
+        MPI_Type_size(sendtype, &bytes);
+        bytes *= sendcount;
+    }
+
+    // Aggregated node blocks are exchanged as MPI_BYTE counts
+    if ((long)num_procs * bytes > INT_MAX)
+        return alltoall_pairwise(sendbuf, sendcount, sendtype,
+                recvbuf, recvcount, recvtype, comm);
+    int node_bytes = ppn * bytes;
+
+    // Number of nodes assigned to each local rank
+    int* n_owned = (int*)malloc(ppn*sizeof(int));
+    int* node_pos = (int*)malloc(num_nodes*sizeof(int));
+    for (int i = 0; i < ppn; i++)
+        n_owned[i] = 0;
+    for (int i = 0; i < num_nodes; i++)
+    {
+        int owner = (rank_node + i) % ppn;
+        node_pos[i] = -1;
+        if (owner == local_rank)
+            node_pos[i] = n_owned[owner];
+        n_owned[owner]++;
+    }
+    int n_mine = n_owned[local_rank];
+
+    int buf_size = num_procs * bytes;
+    if (n_mine * ppn * node_bytes > buf_size)
+        buf_size = n_mine * ppn * node_bytes;
+    char* tmpbuf = (char*)malloc(buf_size*sizeof(char));
+    char* contig_buf = (char*)malloc(buf_size*sizeof(char));
+
+    int* sendcounts = (int*)malloc(ppn*sizeof(int));
+    int* sdispls = (int*)malloc(ppn*sizeof(int));
+    int* recvcounts = (int*)malloc(ppn*sizeof(int));
+    int* rdispls = (int*)malloc(ppn*sizeof(int));
+
+    // 1. Redistribute on-node : send data for every node
+    //      to the local rank assigned to that node
+    int ctr = 0;
+    for (int i = 0; i < ppn; i++)
+    {
+        sendcounts[i] = n_owned[i] * node_bytes;
+        sdispls[i] = ctr;
+        recvcounts[i] = n_mine * node_bytes;
+        rdispls[i] = i * recvcounts[i];
+        for (int node = (i - rank_node % ppn + ppn) % ppn; node < num_nodes; node += ppn)
+        {
+            memcpy(tmpbuf + ctr, send_buffer + node * node_bytes, node_bytes);
+            ctr += node_bytes;
+        }
+    }
+    local_f(tmpbuf, sendcounts, sdispls, MPI_BYTE,
+            contig_buf, recvcounts, rdispls, MPI_BYTE, local_comm);
+
+    // 2. Exchange one aggregated message with each assigned node
+    //      contig_buf : [local_src][node][local_dest]
+    //      tmpbuf : [node][local_src][local_dest]
+    repack(ppn, n_mine, node_bytes, contig_buf, tmpbuf);
+    global_f(tmpbuf, contig_buf, node_pos, ppn * node_bytes, group_comm);
+
+    // 3. Redistribute on-node : send received data to 
+    //      the final local destination
+    //      contig_buf : [node][src][local_dest]
+    //      tmpbuf : [local_dest][node][src]
+    repack(n_mine * ppn, ppn, bytes, contig_buf, tmpbuf);
+    ctr = 0;
+    for (int i = 0; i < ppn; i++)
+    {
+        sendcounts[i] = n_mine * node_bytes;
+        sdispls[i] = i * sendcounts[i];
+        recvcounts[i] = n_owned[i] * node_bytes;
+        rdispls[i] = ctr;
+        ctr += recvcounts[i];
+    }
+    local_f(tmpbuf, sendcounts, sdispls, MPI_BYTE,
+            contig_buf, recvcounts, rdispls, MPI_BYTE, local_comm);
+
+    // Unpack from [local_src][node][src] to recvbuf
+    ctr = 0;
+    for (int i = 0; i < ppn; i++)
+    {
+        for (int node = (i - rank_node % ppn + ppn) % ppn; node < num_nodes; node += ppn)
+        {
+            memcpy(recv_buffer + node * node_bytes, contig_buf + ctr, node_bytes);
+            ctr += node_bytes;
+        }
+    }
+
+    free(n_owned);
+    free(node_pos);
+    free(tmpbuf);
+    free(contig_buf);
+    free(sendcounts);
+    free(sdispls);
+    free(recvcounts);
+    free(rdispls);
+
+    return MPI_SUCCESS;
+}
+
+/**************************************************
+ * Segmented (Pipelined) Locality-Aware Alltoall
+ *  - Same three steps as alltoall_loc, but each 
+ *      block is split into chunks of at most
+ *      comm->pipeline_bytes bytes
+ *  - At every stage, chunk k is exchanged between
+ *      nodes while chunk k+1 is redistributed 
+ *      on-node and chunk k-1 is returned to its
+ *      final local destination
+ *  - On-node steps use MPI_Ialltoallv, inter-node
+ *      step uses nonblocking point-to-point 
+ *      over group_comm
+ *  - Assumes SMP ordering and equal PPN, otherwise 
+ *      falls back to alltoall_pairwise
+ *************************************************/
+int alltoall_pipelined_loc(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm)
+{
+    if (!contiguous_types(sendbuf, sendtype, recvtype))
+        return alltoall_packed(alltoall_pipelined_loc, sendbuf, sendcount, sendtype,
+                recvbuf, recvcount, recvtype, comm);
+
+    int rank, num_procs;
+    MPI_Comm_rank(comm->global_comm, &rank);
+    MPI_Comm_size(comm->global_comm, &num_procs);
+
+    if (comm->local_comm == MPI_COMM_NULL)
+        MPIX_Comm_topo_init(comm);
+
+    MPI_Comm local_comm, group_comm;
+    get_aggregation_comms(comm, &local_comm, &group_comm);
+
+    int local_rank, ppn, num_nodes;
+    MPI_Comm_rank(local_comm, &local_rank);
+    MPI_Comm_size(local_comm, &ppn);
+    MPI_Comm_size(group_comm, &num_nodes);
+
+    // Nodes split evenly in SMP order (checked once per comm)
+    if (!MPIX_Comm_uniform(comm) || ppn == 1 || num_nodes == 1)
+        return alltoall_pairwise(sendbuf, sendcount, sendtype,
+                recvbuf, recvcount, recvtype, comm);
+
+    int rank_node;
+    MPI_Comm_rank(group_comm, &rank_node);
+
+    int tag = 102947;
+    char* recv_buffer = (char*)recvbuf;
+    const char* send_buffer = (const char*)sendbuf;
+
+    // MPI_IN_PLACE : each chunk is copied out of recvbuf before 
+    // the same chunk is received
+    int bytes;
+    if (sendbuf == MPI_IN_PLACE)
+    {
+        send_buffer = recv_buffer;
+        MPI_Type_size(recvtype, &bytes);
+        bytes *= recvcount;
+    }
+    else
+    {
+        MPI_Type_size(sendtype, &bytes);
+        bytes *= sendcount;
+    }
+
+    int chunk_bytes = comm->pipeline_bytes;
+    if (chunk_bytes <= 0 || chunk_bytes > bytes)
+        chunk_bytes = bytes;
+    int n_chunks = bytes ? ((bytes - 1) / chunk_bytes) + 1 : 0;
+
+    // Stage buffers (at most (num_procs + ppn^2) chunks) are 
+    // exchanged as MPI_BYTE counts
+    if ((long)(num_procs + ppn * ppn) * chunk_bytes > INT_MAX)
+        return alltoall_pairwise(sendbuf, sendcount, sendtype,
+                recvbuf, recvcount, recvtype, comm);
+
+    // Nodes assigned to each local rank (as in alltoall_loc)
+    int* n_owned = (int*)malloc(ppn*sizeof(int));
+    int* my_nodes = (int*)malloc(num_nodes*sizeof(int));
+    for (int i = 0; i < ppn; i++)
+        n_owned[i] = 0;
+    int n_mine = 0;
+    for (int i = 0; i < num_nodes; i++)
+    {
+        int owner = (rank_node + i) % ppn;
+        if (owner == local_rank)
+            my_nodes[n_mine++] = i;
+        n_owned[owner]++;
+    }
+
+    // One buffer per stage in flight
+    int buf_size = num_procs * chunk_bytes;
+    if (n_mine * ppn * ppn * chunk_bytes > buf_size)
+        buf_size = n_mine * ppn * ppn * chunk_bytes;
+    char* gather_send = (char*)malloc(buf_size*sizeof(char));
+    char* gather_recv = (char*)malloc(buf_size*sizeof(char));
+    char* global_send = (char*)malloc(buf_size*sizeof(char));
+    char* global_recv = (char*)malloc(buf_size*sizeof(char));
+    char* scatter_send = (char*)malloc(buf_size*sizeof(char));
+    char* scatter_recv = (char*)malloc(buf_size*sizeof(char));
+
+    // Counts and displacements for the two on-node stages in flight
+    //      gather : [owned_counts, owned_displs, gather_counts, gather_displs]
+    //      scatter : [scatter_counts, scatter_displs, return_counts, return_displs]
+    int* counts = (int*)malloc(8*ppn*sizeof(int));
+    int* owned_counts = counts;
+    int* owned_displs = counts + ppn;
+    int* gather_counts = counts + 2*ppn;
+    int* gather_displs = counts + 3*ppn;
+    int* scatter_counts = counts + 4*ppn;
+    int* scatter_displs = counts + 5*ppn;
+    int* return_counts = counts + 6*ppn;
+    int* return_displs = counts + 7*ppn;
+
+    MPI_Request* requests = (MPI_Request*)malloc((2*n_mine+2)*sizeof(MPI_Request));
+
+    for (int step = 0; step < n_chunks + 2; step++)
+    {
+        int n_requests = 0;
+
+        // Inter-node exchange of chunk step-2 complete :
+        //      global_recv : [node][src][local_dest]
+        //      scatter_send : [local_dest][node][src]
+        int scatter_chunk = step - 2;
+        if (scatter_chunk >= 0)
+        {
+            int cb = chunk_bytes;
+            if ((scatter_chunk+1) * chunk_bytes > bytes)
+                cb = bytes - scatter_chunk * chunk_bytes;
+            repack(n_mine * ppn, ppn, cb, global_recv, scatter_send);
+
+            int ctr = 0;
+            for (int i = 0; i < ppn; i++)
+            {
+                scatter_counts[i] = n_mine * ppn * cb;
+                scatter_displs[i] = i * scatter_counts[i];
+                return_counts[i] = n_owned[i] * ppn * cb;
+                return_displs[i] = ctr;
+                ctr += return_counts[i];
+            }
+            MPI_Ialltoallv(scatter_send, scatter_counts, scatter_displs, MPI_BYTE,
+                    scatter_recv, return_counts, return_displs, MPI_BYTE, 
+                    local_comm, &(requests[n_requests++]));
+        }
+
+        // On-node redistribution of chunk step-1 complete :
+        //      gather_recv : [local_src][node][local_dest]
+        //      global_send : [node][local_src][local_dest]
+        int global_chunk = step - 1;
+        if (global_chunk >= 0 && global_chunk < n_chunks)
+        {
+            int cb = chunk_bytes;
+            if ((global_chunk+1) * chunk_bytes > bytes)
+                cb = bytes - global_chunk * chunk_bytes;
+            int node_msg = ppn * ppn * cb;
+            repack(ppn, n_mine, ppn * cb, gather_recv, global_send);
+
+            for (int i = 0; i < n_mine; i++)
+            {
+                int node = my_nodes[i];
+                if (node == rank_node)
+                {
+                    memcpy(global_recv + i * node_msg, global_send + i * node_msg, node_msg);
+                    continue;
+                }
+                MPI_Irecv(global_recv + i * node_msg, node_msg, MPI_BYTE, node, tag,
+                        group_comm, &(requests[n_requests++]));
+                MPI_Isend(global_send + i * node_msg, node_msg, MPI_BYTE, node, tag,
+                        group_comm, &(requests[n_requests++]));
+            }
+        }
+
+        // Pack chunk 'step' by owning local rank and redistribute on-node
+        //      gather_send : [owner][node][local_dest]
+        if (step < n_chunks)
+        {
+            int cb = chunk_bytes;
+            if ((step+1) * chunk_bytes > bytes)
+                cb = bytes - step * chunk_bytes;
+            int offset = step * chunk_bytes;
+
+            int ctr = 0;
+            for (int i = 0; i < ppn; i++)
+            {
+                owned_counts[i] = n_owned[i] * ppn * cb;
+                owned_displs[i] = ctr;
+                gather_counts[i] = n_mine * ppn * cb;
+                gather_displs[i] = i * gather_counts[i];
+                for (int node = (i - rank_node % ppn + ppn) % ppn; node < num_nodes; node += ppn)
+                {
+                    for (int j = 0; j < ppn; j++)
+                    {
+                        memcpy(gather_send + ctr, 
+                                send_buffer + (MPI_Aint)(node * ppn + j) * bytes + offset, cb);
+                        ctr += cb;
+                    }
+                }
+            }
+            MPI_Ialltoallv(gather_send, owned_counts, owned_displs, MPI_BYTE,
+                    gather_recv, gather_counts, gather_displs, MPI_BYTE,
+                    local_comm, &(requests[n_requests++]));
+        }
+
+        MPI_Waitall(n_requests, requests, MPI_STATUSES_IGNORE);
+
+        // Unpack chunk step-2 from [local_src][node][src] to recvbuf
+        if (scatter_chunk >= 0)
+        {
+            int cb = chunk_bytes;
+            if ((scatter_chunk+1) * chunk_bytes > bytes)
+                cb = bytes - scatter_chunk * chunk_bytes;
+            int offset = scatter_chunk * chunk_bytes;
+
+            int ctr = 0;
+            for (int i = 0; i < ppn; i++)
+            {
+                for (int node = (i - rank_node % ppn + ppn) % ppn; node < num_nodes; node += ppn)
+                {
+                    for (int j = 0; j < ppn; j++)
+                    {
+                        memcpy(recv_buffer + (MPI_Aint)(node * ppn + j) * bytes + offset,
+                                scatter_recv + ctr, cb);
+                        ctr += cb;
+                    }
+                }
+            }
+        }
+    }
+
+    free(n_owned);
+    free(my_nodes);
+    free(gather_send);
+    free(gather_recv);
+    free(global_send);
+    free(global_recv);
+    free(scatter_send);
+    free(scatter_recv);
+    free(counts);
+    free(requests);
+
+    return MPI_SUCCESS;
+}
+
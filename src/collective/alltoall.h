@@ -13,6 +13,8 @@ extern "C"
 {
 #endif
 
+typedef int (*alltoall_ftn)(const void*, const int, MPI_Datatype, void*, const int, MPI_Datatype, MPIX_Comm*);
+
 // Helper Functions
 int alltoall_pairwise(const void* sendbuf,
         const int sendcount,
@@ -21,6 +23,18 @@ int alltoall_pairwise(const void* sendbuf,
         const int recvcount,
         MPI_Datatype recvtype,
         MPIX_Comm* comm);
+int alltoall_pairwise_inplace(void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm);
+int alltoall_packed(alltoall_ftn f,
+        const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm);
 int alltoall_nonblocking(const void* sendbuf,
         const int sendcount,
         MPI_Datatype sendtype,
@@ -28,6 +42,91 @@ int alltoall_nonblocking(const void* sendbuf,
         const int recvcount,
         MPI_Datatype recvtype,
         MPIX_Comm* comm);
+int alltoall_nonblocking_window(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm);
+int alltoall_bruck(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm);
+int alltoall_pairwise_loc(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm);
+int alltoall_nonblocking_loc(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm);
+int alltoall_bruck_loc(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm);
+
+int alltoall_pipelined_loc(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm);
+// OpenMP threads split peers (MPI_THREAD_MULTIPLE)
+int alltoall_threaded(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm);
+
+// Bruck alltoall of 'bytes' sized blocks over any communicator
+int bruck_helper(const char* sendbuf,
+        char* recvbuf,
+        const int bytes,
+        MPI_Comm comm);
+
+// Locality-Aware Helpers
+typedef int (*alltoallv_ftn)(const void*, const int*, const int*, MPI_Datatype, 
+void*, const int*, const int*, MPI_Datatype, MPI_Comm);
+
+// node_pos[node] : position of node's aggregated block in 
+//      sendbuf/recvbuf, or -1 if node is handled by another local rank
+typedef int (*node_exchange_ftn)(const char*, char*, const int*, const int, MPI_Comm);
+
+int node_exchange_pairwise(const char* sendbuf,
+        char* recvbuf,
+        const int* node_pos,
+        const int bytes,
+        MPI_Comm group_comm);
+int node_exchange_nonblocking(const char* sendbuf,
+        char* recvbuf,
+        const int* node_pos,
+        const int bytes,
+        MPI_Comm group_comm);
+int alltoall_loc(alltoallv_ftn local_f,
+        node_exchange_ftn global_f,
+        const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm);
 
 
 #ifdef __cplusplus
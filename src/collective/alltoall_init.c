@@ -1,24 +1,23 @@
 #include "alltoall_init.h"
 #include <string.h>
 #include <math.h>
+#include <limits.h>
 
 #ifdef GPU
 #include "heterogeneous/gpu_alltoall_init.h"
 #endif
 
 /**************************************************
- * Locality-Aware Point-to-Point Alltoall
- *  - Aggregates messages locally to reduce 
- *      non-local communciation
- *  - First redistributes on-node so that each
- *      process holds all data for a subset
- *      of other nodes
- *  - Then, performs inter-node communication
- *      during which each process exchanges
- *      data with their assigned subset of nodes
- *  - Finally, redistribute received data
- *      on-node so that each process holds
- *      the correct final data
+ * Persistent Locality-Aware Alltoall
+ *  - Same three steps as alltoall_loc : gather on-node
+ *      all data for a subset of nodes, exchange one
+ *      aggregated message with each of those nodes,
+ *      then redistribute received data on-node
+ *  - Plan (LocalityComm), staging buffers and
+ *      inter-node requests are built once at init :
+ *      MPIX_Start/MPIX_Wait only pack and communicate
+ *  - Falls back to alltoall_init_schedule if topology
+ *      is not supported (see alltoall_init_loc)
  *************************************************/
 int MPIX_Alltoall_init(const void* sendbuf,
         const int sendcount,
@@ -63,17 +62,281 @@ int MPIX_Alltoall_init(const void* sendbuf,
     }
 #endif
 */
-    return alltoall_init_stride(sendbuf,
+    return alltoall_init_loc(sendbuf,
         sendcount,
         sendtype,
         recvbuf,
         recvcount,
         recvtype,
-        mpi_comm->global_comm, 
+        mpi_comm, 
         info,
         request_ptr);
 }
 
+/**************************************************
+ * Persistent Locality-Aware Alltoall (plan)
+ *  - Data is moved in blocks of sendcount values
+ *  - local_L : blocks for processes on my node,
+ *      exchanged directly on-node
+ *  - local_S : blocks for each remote node, sent to
+ *      the local rank owning that node
+ *      ((rank_node + node) % ppn, as in alltoall_loc)
+ *  - global : one message per owned node, with the
+ *      owning rank (same local rank) of that node
+ *  - local_R : received blocks, sent to their 
+ *      local destination
+ *  - On-node phases use node-shared memory 
+ *      (neighbor_shm_start / neighbor_shm_wait)
+ *  - Assumes SMP ordering and equal PPN, otherwise
+ *      falls back to alltoall_init_schedule
+ *************************************************/
+int alltoall_init_loc(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm,
+        MPI_Info info,
+        MPIX_Request** request_ptr)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(comm->global_comm, &rank);
+    MPI_Comm_size(comm->global_comm, &num_procs);
+
+    if (comm->local_comm == MPI_COMM_NULL)
+        MPIX_Comm_topo_init(comm);
+
+    int local_rank, ppn, num_nodes, rank_node;
+    MPI_Comm_rank(comm->local_comm, &local_rank);
+    MPI_Comm_size(comm->local_comm, &ppn);
+    num_nodes = comm->num_nodes;
+    rank_node = comm->rank_node;
+
+    // All processes must agree on PPN (min and max are equal), and
+    // blocks are staged as bytes, so every process needs contiguous types
+    int contig = MPIX_Type_is_contiguous(sendtype) && MPIX_Type_is_contiguous(recvtype);
+    int ppn_range[3] = {ppn, -ppn, contig};
+    MPI_Allreduce(MPI_IN_PLACE, ppn_range, 3, MPI_INT, MPI_MIN, comm->global_comm);
+    int send_size;
+    MPI_Type_size(sendtype, &send_size);
+    int bytes = sendcount * send_size;
+
+    // Shared-memory staging is sized in bytes (int)
+    if (ppn_range[0] != -ppn_range[1] || !ppn_range[2] || num_nodes * ppn != num_procs 
+            || ppn == 1 || num_nodes == 1
+            || (long)num_procs * bytes > INT_MAX)
+        return alltoall_init_schedule(sendbuf, sendcount, sendtype,
+                recvbuf, recvcount, recvtype, comm, info, request_ptr);
+
+    // Blocks are the unit of every CommPkg message
+    MPI_Datatype block_type;
+    MPI_Type_contiguous(bytes, MPI_BYTE, &block_type);
+    MPI_Type_commit(&block_type);
+
+    // Remote nodes owned by each local rank
+    int* n_owned = (int*)malloc(ppn*sizeof(int));
+    for (int i = 0; i < ppn; i++)
+        n_owned[i] = 0;
+    for (int node = 0; node < num_nodes; node++)
+        if (node != rank_node)
+            n_owned[(rank_node + node) % ppn]++;
+    int n_mine = n_owned[local_rank];
+
+    MPIX_Request* request;
+    init_neighbor_request(&request);
+    init_locality_comm(&(request->locality), comm, block_type, block_type);
+    LocalityComm* locality = request->locality;
+    CommData* send_data;
+    CommData* recv_data;
+    int ctr, node, n_msgs;
+
+    // local_L : one block to and from each local rank
+    send_data = locality->local_L_comm->send_data;
+    recv_data = locality->local_L_comm->recv_data;
+    init_num_msgs(send_data, ppn);
+    init_size_msgs(send_data, ppn);
+    init_num_msgs(recv_data, ppn);
+    init_size_msgs(recv_data, ppn);
+    for (int i = 0; i < ppn; i++)
+    {
+        send_data->procs[i] = i;
+        send_data->indptr[i+1] = i+1;
+        send_data->indices[i] = get_global_proc(comm, rank_node, i);
+        recv_data->procs[i] = i;
+        recv_data->indptr[i+1] = i+1;
+        recv_data->indices[i] = get_global_proc(comm, rank_node, i);
+    }
+
+    // local_S : send blocks for nodes owned by local rank i
+    //      recv buffer : [local_src][owned node][local_dest]
+    send_data = locality->local_S_comm->send_data;
+    recv_data = locality->local_S_comm->recv_data;
+    n_msgs = 0;
+    for (int i = 0; i < ppn; i++)
+        if (n_owned[i])
+            n_msgs++;
+    init_num_msgs(send_data, n_msgs);
+    init_size_msgs(send_data, (num_nodes - 1) * ppn);
+    ctr = 0;
+    n_msgs = 0;
+    for (int i = 0; i < ppn; i++)
+    {
+        if (n_owned[i] == 0)
+            continue;
+        for (node = (i - rank_node % ppn + ppn) % ppn; node < num_nodes; node += ppn)
+        {
+            if (node == rank_node)
+                continue;
+            for (int j = 0; j < ppn; j++)
+                send_data->indices[ctr++] = get_global_proc(comm, node, j);
+        }
+        send_data->procs[n_msgs++] = i;
+        send_data->indptr[n_msgs] = ctr;
+    }
+    n_msgs = n_mine ? ppn : 0;
+    init_num_msgs(recv_data, n_msgs);
+    init_size_msgs(recv_data, n_msgs * n_mine * ppn);
+    for (int i = 0; i < n_msgs; i++)
+    {
+        recv_data->procs[i] = i;
+        recv_data->indptr[i+1] = (i+1) * n_mine * ppn;
+    }
+    for (int i = 0; i < recv_data->size_msgs; i++)
+        recv_data->indices[i] = i;
+
+    // global : exchange [local_src][local_dest] with each owned node
+    //      indices point into local_S recv buffer
+    send_data = locality->global_comm->send_data;
+    recv_data = locality->global_comm->recv_data;
+    init_num_msgs(send_data, n_mine);
+    init_size_msgs(send_data, n_mine * ppn * ppn);
+    init_num_msgs(recv_data, n_mine);
+    init_size_msgs(recv_data, n_mine * ppn * ppn);
+    ctr = 0;
+    int pos = 0;
+    for (node = (local_rank - rank_node % ppn + ppn) % ppn; node < num_nodes; node += ppn)
+    {
+        if (node == rank_node)
+            continue;
+        for (int i = 0; i < ppn; i++)
+            for (int j = 0; j < ppn; j++)
+                send_data->indices[ctr++] = i * n_mine * ppn + pos * ppn + j;
+        send_data->procs[pos] = get_global_proc(comm, node, local_rank);
+        recv_data->procs[pos] = send_data->procs[pos];
+        pos++;
+        send_data->indptr[pos] = ctr;
+        recv_data->indptr[pos] = ctr;
+    }
+    for (int i = 0; i < recv_data->size_msgs; i++)
+        recv_data->indices[i] = i;
+
+    // local_R : send received blocks to local destination
+    //      indices point into global recv buffer [owned node][src][local_dest]
+    send_data = locality->local_R_comm->send_data;
+    recv_data = locality->local_R_comm->recv_data;
+    n_msgs = n_mine ? ppn : 0;
+    init_num_msgs(send_data, n_msgs);
+    init_size_msgs(send_data, n_msgs * n_mine * ppn);
+    ctr = 0;
+    for (int i = 0; i < n_msgs; i++)
+    {
+        for (int p = 0; p < n_mine; p++)
+            for (int j = 0; j < ppn; j++)
+                send_data->indices[ctr++] = (p * ppn + j) * ppn + i;
+        send_data->procs[i] = i;
+        send_data->indptr[i+1] = ctr;
+    }
+    n_msgs = 0;
+    for (int i = 0; i < ppn; i++)
+        if (n_owned[i])
+            n_msgs++;
+    init_num_msgs(recv_data, n_msgs);
+    init_size_msgs(recv_data, (num_nodes - 1) * ppn);
+    ctr = 0;
+    n_msgs = 0;
+    for (int i = 0; i < ppn; i++)
+    {
+        if (n_owned[i] == 0)
+            continue;
+        for (node = (i - rank_node % ppn + ppn) % ppn; node < num_nodes; node += ppn)
+        {
+            if (node == rank_node)
+                continue;
+            for (int j = 0; j < ppn; j++)
+                recv_data->indices[ctr++] = get_global_proc(comm, node, j);
+        }
+        recv_data->procs[n_msgs++] = i;
+        recv_data->indptr[n_msgs] = ctr;
+    }
+
+    finalize_locality_comm(locality);
+
+    request->sendbuf = sendbuf;
+    request->recvbuf = recvbuf;
+    request->recv_size = bytes;
+
+    // Values are whole blocks (request frees block_type)
+    request->sendtype = block_type;
+    request->recvtype = block_type;
+    request->packed_type = block_type;
+
+    // On-node phases exchange through node-shared memory, and
+    // inter-node requests over staging buffers
+    init_neighbor_shm(request, comm);
+
+    free(n_owned);
+
+    *request_ptr = request;
+
+    return MPI_SUCCESS;
+}
+
+/**************************************************
+ * Persistent Pairwise Alltoall
+ *  - Sends and receives with every process, in order
+ *      of comm->peer_schedule
+ *  - All messages are started at once (neighbor_start),
+ *      so no send waits for a receive posted later
+ *************************************************/
+int alltoall_init_schedule(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm,
+        MPI_Info info,
+        MPIX_Request** request_ptr)
+{
+    int num_procs;
+    MPI_Comm_size(comm->global_comm, &num_procs);
+
+    const int* send_procs;
+    const int* recv_procs;
+    MPIX_Comm_peer_schedule(comm, &send_procs, &recv_procs);
+
+    init_request(request_ptr);
+    MPIX_Request* request = *request_ptr;
+    request->global_n_msgs = 2*num_procs;
+    allocate_requests(request->global_n_msgs, &(request->global_requests));
+    request->start_function = (void*) neighbor_start;
+    request->wait_function = (void*) neighbor_wait;
+    request->test_function = (void*) neighbor_test;
+
+    return alltoall_init_nonblocking_helper(sendbuf,
+            sendcount,
+            sendtype,
+            recvbuf,
+            recvcount,
+            recvtype,
+            send_procs,
+            recv_procs,
+            comm->global_comm,
+            info,
+            request_ptr);
+}
+
 int alltoall_init_nonblocking(const void* sendbuf,
         const int sendcount,
         MPI_Datatype sendtype,
@@ -94,6 +357,7 @@ int alltoall_init_nonblocking(const void* sendbuf,
     allocate_requests(request->global_n_msgs, &(request->global_requests));
     request->start_function = (void*) neighbor_start;
     request->wait_function = (void*) neighbor_wait;
+    request->test_function = (void*) neighbor_test;
 
     return alltoall_init_nonblocking_helper(sendbuf,
             sendcount,
@@ -101,6 +365,8 @@ int alltoall_init_nonblocking(const void* sendbuf,
             recvbuf,
             recvcount,
             recvtype,
+            NULL,
+            NULL,
             comm,
             info,
             request_ptr);
@@ -135,6 +401,8 @@ int alltoall_init_stride(const void* sendbuf,
             recvbuf,
             recvcount,
             recvtype,
+            NULL,
+            NULL,
             comm,
             info,
             request_ptr);
@@ -146,6 +414,8 @@ int alltoall_init_nonblocking_helper(const void* sendbuf,
         void* recvbuf,
         const int recvcount,
         MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
         MPI_Comm comm,
         MPI_Info info,
         MPIX_Request** request_ptr)
@@ -158,27 +428,22 @@ int alltoall_init_nonblocking_helper(const void* sendbuf,
 
     int tag = 102944;
     int send_proc, recv_proc;
-    int send_pos, recv_pos;
+    MPI_Aint send_pos, recv_pos;
 
     char* recv_buffer = (char*)recvbuf;
     char* send_buffer = (char*)sendbuf;
 
-    int send_size, recv_size;
-    MPI_Type_size(sendtype, &send_size);
-    MPI_Type_size(recvtype, &recv_size);
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
 
-    // Send to rank + i
-    // Recv from rank - i
+    // Send to send_procs[i] (default rank + i)
+    // Recv from recv_procs[i] (default rank - i)
     for (int i = 0; i < num_procs; i++)
     {
-        send_proc = rank + i;
-        if (send_proc >= num_procs)
-            send_proc -= num_procs;
-        recv_proc = rank - i;
-        if (recv_proc < 0)
-            recv_proc += num_procs;
-        send_pos = send_proc * sendcount * send_size;
-        recv_pos = recv_proc * recvcount * recv_size;
+        get_step_peers(rank, num_procs, i, send_procs, recv_procs,
+                &send_proc, &recv_proc);
+        send_pos = (MPI_Aint)send_proc * sendcount * send_extent;
+        recv_pos = (MPI_Aint)recv_proc * recvcount * recv_extent;
 
         MPI_Send_init(send_buffer + send_pos,
                 sendcount, 
@@ -15,7 +15,35 @@ extern "C"
 {
 #endif
 
+int MPIX_Alltoall_init(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* mpi_comm,
+        MPI_Info info,
+        MPIX_Request** request_ptr);
+
 // Helper Functions
+int alltoall_init_loc(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm,
+        MPI_Info info,
+        MPIX_Request** request_ptr);
+int alltoall_init_schedule(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm,
+        MPI_Info info,
+        MPIX_Request** request_ptr);
 int alltoall_init_nonblocking(const void* sendbuf,
         const int sendcount,
         MPI_Datatype sendtype,
@@ -34,12 +62,15 @@ int alltoall_init_stride(const void* sendbuf,
         MPI_Comm comm,
         MPI_Info info,
         MPIX_Request** request_ptr);
+// send_procs/recv_procs : order of exchanges (NULL for rank + i / rank - i)
 int alltoall_init_nonblocking_helper(const void* sendbuf,
         const int sendcount,
         MPI_Datatype sendtype,
         void* recvbuf,
         const int recvcount,
         MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
         MPI_Comm comm,
         MPI_Info info,
         MPIX_Request** request_ptr);
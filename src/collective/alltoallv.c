@@ -1,11 +1,28 @@
 #include "alltoallv.h"
+#include "tuning.h"
 #include <string.h>
 #include <math.h>
+#include <limits.h>
 
 #ifdef GPU
 #include "heterogeneous/gpu_alltoallv.h"
 #endif
 
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+static int pairwise_loc_select(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm,
+        int sparse_percent);
+
 /**************************************************
  * Locality-Aware Point-to-Point Alltoallv
  * Same as PMPI_Alltoall (no load balancing)
@@ -24,6 +41,14 @@
  *  - For load balacing, use persistent version
  *      - Load balacing is too expensive for 
  *          non-persistent Alltoallv
+ *  - Algorithm may be overridden by a tuning 
+ *      table (see tuning.h)
+ *  - If fewer than comm->sparse_percent % of all
+ *      counts are non-zero, uses alltoallv_sparse
+ *      (the count of non-zero counts is added to
+ *      the reduction the method already needs : the
+ *      selection reduction of a tuning table, or
+ *      the overflow check of alltoallv_pairwise_loc)
  *************************************************/
 int MPIX_Alltoallv(const void* sendbuf,
         const int sendcounts[],
@@ -66,7 +91,88 @@ int MPIX_Alltoallv(const void* sendbuf,
                 mpi_comm);
     }
 #endif
-    return alltoallv_pairwise(
+    // Indexed by AlltoallvMethod (tuning.h), except
+    // ALLTOALLV_PAIRWISE_LOC, ALLTOALLV_HYBRID_LOC, 
+    // ALLTOALLV_BRUCK_LOC and ALLTOALLV_THREADED (need the MPIX_Comm)
+    alltoallv_sched_ftn methods[ALLTOALLV_PAIRWISE_LOC] = {
+        alltoallv_pairwise_sched,
+        alltoallv_nonblocking_sched,
+        alltoallv_pairwise_nonblocking_sched,
+        alltoallv_waitany_sched,
+        alltoallv_pairwise_log2_sched,
+        alltoallv_pairwise_nonblocking_log2_sched,
+        alltoallv_sparse_sched,
+        alltoallv_bruck_sched
+    };
+
+    if (mpi_comm->n_tuning_entries < 0)
+        MPIX_Comm_tuning_init(mpi_comm, NULL);
+
+    // Default : alltoallv_pairwise_loc, also selecting alltoallv_sparse
+    if (mpi_comm->n_tuning_entries == 0)
+        return pairwise_loc_select(sendbuf, sendcounts, sdispls, sendtype,
+                recvbuf, recvcounts, rdispls, recvtype, mpi_comm,
+                mpi_comm->sparse_percent);
+
+    // All processes must select the same method : 
+    // use average bytes per process pair, and
+    // number of non-zero counts
+    // (MPI_IN_PLACE : sizes given by recvcounts)
+    int num_procs, send_size;
+    MPI_Comm_size(mpi_comm->global_comm, &num_procs);
+    const int* counts = sendcounts;
+    if (sendbuf == MPI_IN_PLACE)
+    {
+        counts = recvcounts;
+        MPI_Type_size(recvtype, &send_size);
+    }
+    else
+        MPI_Type_size(sendtype, &send_size);
+
+    long totals[2] = {0, 0};
+    for (int i = 0; i < num_procs; i++)
+    {
+        totals[0] += counts[i];
+        if (counts[i])
+            totals[1]++;
+    }
+    totals[0] *= send_size;
+    MPI_Allreduce(MPI_IN_PLACE, totals, 2, MPI_LONG, MPI_SUM, mpi_comm->global_comm);
+
+    long n_pairs = (long)num_procs * num_procs;
+    int method = ALLTOALLV_SPARSE;
+    if (totals[1] * 100 >= mpi_comm->sparse_percent * n_pairs)
+        method = select_alltoallv_method(mpi_comm, totals[0] / n_pairs);
+
+    if (method == ALLTOALLV_PAIRWISE_LOC)
+        return alltoallv_pairwise_loc(sendbuf, sendcounts, sdispls, sendtype,
+                recvbuf, recvcounts, rdispls, recvtype, mpi_comm);
+    if (method == ALLTOALLV_HYBRID_LOC)
+        return alltoallv_hybrid_loc(sendbuf, sendcounts, sdispls, sendtype,
+                recvbuf, recvcounts, rdispls, recvtype, mpi_comm);
+    if (method == ALLTOALLV_BRUCK_LOC)
+        return alltoallv_bruck_loc(sendbuf, sendcounts, sdispls, sendtype,
+                recvbuf, recvcounts, rdispls, recvtype, mpi_comm);
+    if (method == ALLTOALLV_THREADED)
+        return alltoallv_threaded(sendbuf, sendcounts, sdispls, sendtype,
+                recvbuf, recvcounts, rdispls, recvtype, mpi_comm);
+
+    // Order of pairwise exchanges (comm->peer_schedule)
+    const int* send_procs;
+    const int* recv_procs;
+    MPIX_Comm_peer_schedule(mpi_comm, &send_procs, &recv_procs);
+
+    // Windowed methods use (and adapt) comm->nb_window
+    if (method == ALLTOALLV_PAIRWISE_NONBLOCKING)
+        return alltoallv_pairwise_nonblocking_window(sendbuf, sendcounts, sdispls, sendtype,
+                recvbuf, recvcounts, rdispls, recvtype, send_procs, recv_procs,
+                &(mpi_comm->nb_window), mpi_comm->global_comm);
+    if (method == ALLTOALLV_WAITANY)
+        return alltoallv_waitany_window(sendbuf, sendcounts, sdispls, sendtype,
+                recvbuf, recvcounts, rdispls, recvtype, send_procs, recv_procs,
+                &(mpi_comm->nb_window), mpi_comm->global_comm);
+
+    return methods[method](
         sendbuf,
         sendcounts,
         sdispls,
@@ -75,6 +181,8 @@ int MPIX_Alltoallv(const void* sendbuf,
         recvcounts,
         rdispls,
         recvtype,
+        send_procs,
+        recv_procs,
         mpi_comm->global_comm);
 }
 
@@ -89,50 +197,258 @@ int alltoallv_pairwise(const void* sendbuf,
         MPI_Datatype recvtype,
         MPI_Comm comm)
 {
+    return alltoallv_pairwise_sched(sendbuf, sendcounts, sdispls, sendtype,
+            recvbuf, recvcounts, rdispls, recvtype, NULL, NULL, comm);
+}
+
+int alltoallv_nonblocking(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPI_Comm comm)
+{
+    return alltoallv_nonblocking_sched(sendbuf, sendcounts, sdispls, sendtype,
+            recvbuf, recvcounts, rdispls, recvtype, NULL, NULL, comm);
+}
+
+int alltoallv_pairwise_nonblocking(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPI_Comm comm)
+{
+    return alltoallv_pairwise_nonblocking_sched(sendbuf, sendcounts, sdispls, sendtype,
+            recvbuf, recvcounts, rdispls, recvtype, NULL, NULL, comm);
+}
+
+int alltoallv_waitany(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPI_Comm comm)
+{
+    return alltoallv_waitany_sched(sendbuf, sendcounts, sdispls, sendtype,
+            recvbuf, recvcounts, rdispls, recvtype, NULL, NULL, comm);
+}
+
+/**************************************************
+ * Sparse Alltoallv
+ *  - Posts receives and sends only for non-zero
+ *      counts (from the counts already supplied,
+ *      no metadata exchange), so empty pairs cost
+ *      nothing
+ *  - Receives are posted first, then sends, in
+ *      order of send_procs / recv_procs, and all
+ *      complete in one MPI_Waitall
+ *  - Selected by MPIX_Alltoallv when fewer than
+ *      comm->sparse_percent % of counts are non-zero
+ *************************************************/
+int alltoallv_sparse(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPI_Comm comm)
+{
+    return alltoallv_sparse_sched(sendbuf, sendcounts, sdispls, sendtype,
+            recvbuf, recvcounts, rdispls, recvtype, NULL, NULL, comm);
+}
+
+int alltoallv_sparse_sched(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
+        MPI_Comm comm)
+{
+    if (sendbuf == MPI_IN_PLACE)
+        return alltoallv_pairwise_inplace(recvbuf, recvcounts, rdispls,
+                recvtype, comm);
+
     int rank, num_procs;
     MPI_Comm_rank(comm, &rank);
     MPI_Comm_size(comm, &num_procs);
 
     int tag = 103044;
     int send_proc, recv_proc;
-    int send_pos, recv_pos;
-    MPI_Status status;
+    MPI_Aint send_pos, recv_pos;
+
+    // Element i of a buffer starts at i * extent (datatype engine)
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
 
-    int send_size, recv_size;
-    MPI_Type_size(sendtype, &send_size);
-    MPI_Type_size(recvtype, &recv_size);
- 
     char* send_buffer = (char*)sendbuf;
     char* recv_buffer = (char*)recvbuf;
 
-    memcpy(
-        recv_buffer + (rdispls[rank] * recv_size),
-        send_buffer + (sdispls[rank] * send_size), 
-        sendcounts[rank] * send_size);        
+    MPIX_Type_copy(
+        send_buffer + ((MPI_Aint)sdispls[rank] * send_extent),
+        sendcounts[rank], sendtype,
+        recv_buffer + ((MPI_Aint)rdispls[rank] * recv_extent),
+        recvcounts[rank], recvtype);
 
-    // Send to rank + i
-    // Recv from rank - i
+    int n_sends = 0;
+    int n_recvs = 0;
     for (int i = 1; i < num_procs; i++)
     {
-        send_proc = rank + i;
-        if (send_proc >= num_procs)
-            send_proc -= num_procs;
-        recv_proc = rank - i;
-        if (recv_proc < 0)
-            recv_proc += num_procs;
+        get_step_peers(rank, num_procs, i, send_procs, recv_procs,
+                &send_proc, &recv_proc);
+        if (sendcounts[send_proc])
+            n_sends++;
+        if (recvcounts[recv_proc])
+            n_recvs++;
+    }
 
-        send_pos = sdispls[send_proc] * send_size;
-        recv_pos = rdispls[recv_proc] * recv_size;
+    MPI_Request* requests = (MPI_Request*)malloc((n_sends+n_recvs+1)*sizeof(MPI_Request));
 
-        MPI_Sendrecv(send_buffer + send_pos, sendcounts[send_proc], sendtype, send_proc, tag,
-                recv_buffer + recv_pos, recvcounts[recv_proc], recvtype, recv_proc, tag,
-                comm, &status);
+    int ctr = 0;
+    for (int i = 1; i < num_procs; i++)
+    {
+        get_step_peers(rank, num_procs, i, send_procs, recv_procs,
+                &send_proc, &recv_proc);
+        if (recvcounts[recv_proc] == 0)
+            continue;
+
+        recv_pos = (MPI_Aint)rdispls[recv_proc] * recv_extent;
+        MPI_Irecv(recv_buffer + recv_pos, recvcounts[recv_proc], recvtype, recv_proc, tag,
+                comm, &(requests[ctr++]));
+    }
+    for (int i = 1; i < num_procs; i++)
+    {
+        get_step_peers(rank, num_procs, i, send_procs, recv_procs,
+                &send_proc, &recv_proc);
+        if (sendcounts[send_proc] == 0)
+            continue;
+
+        send_pos = (MPI_Aint)sdispls[send_proc] * send_extent;
+        MPI_Isend(send_buffer + send_pos, sendcounts[send_proc], sendtype, send_proc, tag,
+                comm, &(requests[ctr++]));
     }
 
+    MPI_Waitall(ctr, requests, MPI_STATUSES_IGNORE);
+
+    free(requests);
+
     return 0;
 }
 
-int alltoallv_nonblocking(const void* sendbuf,
+/**************************************************
+ * Pairwise-XOR Alltoallv
+ *  - At step i, rank exchanges with rank ^ i, so
+ *      every step pairs processes in both directions
+ *      (send and receive peer are the same), avoiding
+ *      the collisions of rank + i / rank - i on
+ *      fat-tree networks
+ *  - Requires a power-of-two number of processes,
+ *      otherwise falls back to rank + i / rank - i
+ *************************************************/
+static int* xor_schedule(MPI_Comm comm)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &num_procs);
+
+    if (num_procs & (num_procs - 1))
+        return NULL;
+
+    int* procs = (int*)malloc(num_procs*sizeof(int));
+    for (int i = 0; i < num_procs; i++)
+        procs[i] = rank ^ i;
+    return procs;
+}
+
+int alltoallv_pairwise_log2(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPI_Comm comm)
+{
+    int* procs = xor_schedule(comm);
+    int ierr = alltoallv_pairwise_sched(sendbuf, sendcounts, sdispls, sendtype,
+            recvbuf, recvcounts, rdispls, recvtype, procs, procs, comm);
+    free(procs);
+    return ierr;
+}
+
+int alltoallv_pairwise_nonblocking_log2(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPI_Comm comm)
+{
+    int* procs = xor_schedule(comm);
+    int ierr = alltoallv_pairwise_nonblocking_sched(sendbuf, sendcounts, sdispls, sendtype,
+            recvbuf, recvcounts, rdispls, recvtype, procs, procs, comm);
+    free(procs);
+    return ierr;
+}
+
+// XOR methods fix their own order of exchanges,
+// so ignore the communicator's peer schedule
+int alltoallv_pairwise_log2_sched(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
+        MPI_Comm comm)
+{
+    (void)send_procs;
+    (void)recv_procs;
+    return alltoallv_pairwise_log2(sendbuf, sendcounts, sdispls, sendtype,
+            recvbuf, recvcounts, rdispls, recvtype, comm);
+}
+
+int alltoallv_pairwise_nonblocking_log2_sched(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
+        MPI_Comm comm)
+{
+    (void)send_procs;
+    (void)recv_procs;
+    return alltoallv_pairwise_nonblocking_log2(sendbuf, sendcounts, sdispls, sendtype,
+            recvbuf, recvcounts, rdispls, recvtype, comm);
+}
+
+int alltoallv_pairwise_sched(const void* sendbuf,
         const int sendcounts[],
         const int sdispls[],
         MPI_Datatype sendtype,
@@ -140,62 +456,61 @@ int alltoallv_nonblocking(const void* sendbuf,
         const int recvcounts[],
         const int rdispls[],
         MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
         MPI_Comm comm)
 {
+    if (sendbuf == MPI_IN_PLACE)
+        return alltoallv_pairwise_inplace(recvbuf, recvcounts, rdispls,
+                recvtype, comm);
+
     int rank, num_procs;
     MPI_Comm_rank(comm, &rank);
     MPI_Comm_size(comm, &num_procs);
 
     int tag = 103044;
     int send_proc, recv_proc;
-    int send_pos, recv_pos;
-
-    int send_size, recv_size;
-    MPI_Type_size(sendtype, &send_size);
-    MPI_Type_size(recvtype, &recv_size);
-
-    MPI_Request* requests = (MPI_Request*)malloc(2*(num_procs-1)*sizeof(MPI_Request));
+    MPI_Aint send_pos, recv_pos;
+    MPI_Status status;
 
+    // Element i of a buffer starts at i * extent (datatype engine)
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
+ 
     char* send_buffer = (char*)sendbuf;
     char* recv_buffer = (char*)recvbuf;
 
-    memcpy(
-        recv_buffer + (rdispls[rank] * recv_size),
-        send_buffer + (sdispls[rank] * send_size), 
-        sendcounts[rank] * send_size);        
+    MPIX_Type_copy(
+        send_buffer + ((MPI_Aint)sdispls[rank] * send_extent),
+        sendcounts[rank], sendtype,
+        recv_buffer + ((MPI_Aint)rdispls[rank] * recv_extent),
+        recvcounts[rank], recvtype);
 
-    // For each step i
-    // exchange among procs stride (i+1) apart
+    // Send to send_procs[i] (default rank + i)
+    // Recv from recv_procs[i] (default rank - i)
     for (int i = 1; i < num_procs; i++)
     {
-        send_proc = rank + i;
-        if (send_proc >= num_procs)
-            send_proc -= num_procs;
-        recv_proc = rank - i;
-        if (recv_proc < 0)
-            recv_proc += num_procs;
+        get_step_peers(rank, num_procs, i, send_procs, recv_procs,
+                &send_proc, &recv_proc);
 
-        send_pos = sdispls[send_proc] * send_size;
-        recv_pos = rdispls[recv_proc] * recv_size;
+        send_pos = (MPI_Aint)sdispls[send_proc] * send_extent;
+        recv_pos = (MPI_Aint)rdispls[recv_proc] * recv_extent;
 
-        MPI_Isend(send_buffer + send_pos, sendcounts[send_proc], sendtype, send_proc, tag,
-                comm, &(requests[i-1]));
-        MPI_Irecv(recv_buffer + recv_pos, recvcounts[recv_proc], recvtype, recv_proc, tag,
-                comm, &(requests[num_procs+i-2]));
+        MPI_Sendrecv(send_buffer + send_pos, sendcounts[send_proc], sendtype, send_proc, tag,
+                recv_buffer + recv_pos, recvcounts[recv_proc], recvtype, recv_proc, tag,
+                comm, &status);
     }
 
-    MPI_Waitall(2*(num_procs-1), requests, MPI_STATUSES_IGNORE);
-
-    free(requests);
-
     return 0;
 }
 
-int alltoallv_pairwise_nonblocking(const void* sendbuf,
-        const int sendcounts[],
-        const int sdispls[],
-        MPI_Datatype sendtype,
-        void* recvbuf,
+/**************************************************
+ * In-Place Pairwise Alltoallv (MPI_IN_PLACE)
+ *  - Same symmetric pairing as alltoall_pairwise_inplace :
+ *      at round r, swap blocks with (r - rank) mod p
+ *  - Scratch holds a single block (largest recvcount)
+ *************************************************/
+int alltoallv_pairwise_inplace(void* recvbuf,
         const int recvcounts[],
         const int rdispls[],
         MPI_Datatype recvtype,
@@ -205,65 +520,51 @@ int alltoallv_pairwise_nonblocking(const void* sendbuf,
     MPI_Comm_rank(comm, &rank);
     MPI_Comm_size(comm, &num_procs);
 
-    // Tuning Parameter : number of non-blocking messages between waits 
-    int nb_stride = 5;
-
     int tag = 103044;
-    int ctr;
-    int send_proc, recv_proc;
-    int send_pos, recv_pos;
-
-    int send_size, recv_size;
-    MPI_Type_size(sendtype, &send_size);
-    MPI_Type_size(recvtype, &recv_size);
-
-    MPI_Request* requests = (MPI_Request*)malloc(2*nb_stride*sizeof(MPI_Request));
+    int proc;
+    MPI_Aint pos;
+    MPI_Status status;
 
+    int max_count = 0;
+    for (int i = 0; i < num_procs; i++)
+        if (recvcounts[i] > max_count)
+            max_count = recvcounts[i];
 
-    char* send_buffer = (char*)sendbuf;
     char* recv_buffer = (char*)recvbuf;
 
-    memcpy(
-        recv_buffer + (rdispls[rank] * recv_size),
-        send_buffer + (sdispls[rank] * send_size),
-        sendcounts[rank] * send_size);
-
-    // For each step i
-    // exchange among procs stride (i+1) apart
-    ctr = 0;
-    for (int i = 1; i < num_procs; i++)
-    {
-        send_proc = rank + i;
-        if (send_proc >= num_procs)
-            send_proc -= num_procs;
-        recv_proc = rank - i;
-        if (recv_proc < 0)
-            recv_proc += num_procs;
+    // Scratch spans the largest block (only bytes in the type map are copied)
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
+    MPI_Aint true_lb, true_extent;
+    MPI_Type_get_true_extent(recvtype, &true_lb, &true_extent);
+    MPI_Aint span = 0;
+    if (max_count)
+        span = (max_count - 1) * recv_extent + true_extent;
 
-        send_pos = sdispls[send_proc] * send_size;
-        recv_pos = rdispls[recv_proc] * recv_size;
+    char* scratch = (char*)malloc(span*sizeof(char));
+    char* scratch_block = scratch - true_lb;
 
-        MPI_Isend(send_buffer + send_pos, sendcounts[send_proc], sendtype, send_proc, tag,
-                comm, &(requests[ctr++]));
-        MPI_Irecv(recv_buffer + recv_pos, recvcounts[recv_proc], recvtype, recv_proc, tag,
-                comm, &(requests[ctr++]));
+    for (int r = 0; r < num_procs; r++)
+    {
+        proc = r - rank;
+        if (proc < 0)
+            proc += num_procs;
+        if (proc == rank)
+            continue;
+        pos = (MPI_Aint)rdispls[proc] * recv_extent;
 
-        if (i % nb_stride == 0)
-        {
-            MPI_Waitall(2*nb_stride, requests, MPI_STATUSES_IGNORE);
-            ctr = 0;
-        }
+        MPIX_Type_copy(recv_buffer + pos, recvcounts[proc], recvtype,
+                scratch_block, recvcounts[proc], recvtype);
+        MPI_Sendrecv(scratch_block, recvcounts[proc], recvtype, proc, tag,
+                recv_buffer + pos, recvcounts[proc], recvtype, proc, tag,
+                comm, &status);
     }
-    
-    if (ctr)
-        MPI_Waitall(ctr, requests, MPI_STATUSES_IGNORE);
 
-    free(requests);
+    free(scratch);
 
     return 0;
 }
 
-int alltoallv_waitany(const void* sendbuf,
+int alltoallv_nonblocking_sched(const void* sendbuf,
         const int sendcounts[],
         const int sdispls[],
         MPI_Datatype sendtype,
@@ -271,100 +572,1790 @@ int alltoallv_waitany(const void* sendbuf,
         const int recvcounts[],
         const int rdispls[],
         MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
         MPI_Comm comm)
 {
+    if (sendbuf == MPI_IN_PLACE)
+        return alltoallv_pairwise_inplace(recvbuf, recvcounts, rdispls,
+                recvtype, comm);
+
     int rank, num_procs;
     MPI_Comm_rank(comm, &rank);
     MPI_Comm_size(comm, &num_procs);
 
-    // Tuning Parameter : number of non-blocking messages between waits 
-    int nb_stride = 5;
-
     int tag = 103044;
-    int ctr;
     int send_proc, recv_proc;
-    int send_pos, recv_pos;
+    MPI_Aint send_pos, recv_pos;
 
-    int send_size, recv_size;
-    MPI_Type_size(sendtype, &send_size);
-    MPI_Type_size(recvtype, &recv_size);
+    // Element i of a buffer starts at i * extent (datatype engine)
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
 
-    MPI_Request* requests = (MPI_Request*)malloc(2*nb_stride*sizeof(MPI_Request));
+    MPI_Request* requests = (MPI_Request*)malloc(2*(num_procs-1)*sizeof(MPI_Request));
 
     char* send_buffer = (char*)sendbuf;
     char* recv_buffer = (char*)recvbuf;
 
-    memcpy(
-        recv_buffer + (rdispls[rank] * recv_size),
-        send_buffer + (sdispls[rank] * send_size),
-        sendcounts[rank] * send_size);
+    MPIX_Type_copy(
+        send_buffer + ((MPI_Aint)sdispls[rank] * send_extent),
+        sendcounts[rank], sendtype,
+        recv_buffer + ((MPI_Aint)rdispls[rank] * recv_extent),
+        recvcounts[rank], recvtype);
 
     // For each step i
     // exchange among procs stride (i+1) apart
-    ctr = 0;
-    for (int i = 1; i <= nb_stride && i < num_procs; i++)
+    for (int i = 1; i < num_procs; i++)
     {
-        send_proc = rank + i;
-        if (send_proc >= num_procs)
-            send_proc -= num_procs;
-        recv_proc = rank - i;
-        if (recv_proc < 0)
-            recv_proc += num_procs;
+        get_step_peers(rank, num_procs, i, send_procs, recv_procs,
+                &send_proc, &recv_proc);
 
-        send_pos = sdispls[send_proc] * send_size;
-        recv_pos = rdispls[recv_proc] * recv_size;
+        send_pos = (MPI_Aint)sdispls[send_proc] * send_extent;
+        recv_pos = (MPI_Aint)rdispls[recv_proc] * recv_extent;
 
         MPI_Isend(send_buffer + send_pos, sendcounts[send_proc], sendtype, send_proc, tag,
-                comm, &(requests[ctr++]));
+                comm, &(requests[i-1]));
         MPI_Irecv(recv_buffer + recv_pos, recvcounts[recv_proc], recvtype, recv_proc, tag,
-                comm, &(requests[ctr++]));
-
+                comm, &(requests[num_procs+i-2]));
     }
 
-    if (nb_stride >= num_procs)
-    {
-        MPI_Waitall(2*(num_procs-1), requests, MPI_STATUSES_IGNORE);
-        free(requests);
-        return 0;
-    }
+    MPI_Waitall(2*(num_procs-1), requests, MPI_STATUSES_IGNORE);
 
-    int send_idx = nb_stride;
-    int recv_idx = nb_stride;
-    int idx;
-    while (1)
-    {
-        MPI_Waitany(2*nb_stride, requests, &idx, MPI_STATUSES_IGNORE);
+    free(requests);
 
-        if (idx == MPI_UNDEFINED)
-        {
-            break;
-        }
+    return 0;
+}
+
+int alltoallv_pairwise_nonblocking_sched(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
+        MPI_Comm comm)
+{
+    MPIX_Window window;
+    MPIX_Window_init(&window, 5, 0);
+    return alltoallv_pairwise_nonblocking_window(sendbuf, sendcounts, sdispls, sendtype,
+            recvbuf, recvcounts, rdispls, recvtype, send_procs, recv_procs,
+            &window, comm);
+}
+
+int alltoallv_waitany_sched(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
+        MPI_Comm comm)
+{
+    MPIX_Window window;
+    MPIX_Window_init(&window, 5, 0);
+    return alltoallv_waitany_window(sendbuf, sendcounts, sdispls, sendtype,
+            recvbuf, recvcounts, rdispls, recvtype, send_procs, recv_procs,
+            &window, comm);
+}
+
+/**************************************************
+ * Windowed Pairwise Nonblocking Alltoallv
+ *  - Posts window->size steps at a time, and waits
+ *      for all of them before posting the next batch
+ *  - Adaptive windows are updated after each batch
+ *      (see MPIX_Window_update)
+ *************************************************/
+int alltoallv_pairwise_nonblocking_window(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
+        MPIX_Window* window,
+        MPI_Comm comm)
+{
+    if (sendbuf == MPI_IN_PLACE)
+        return alltoallv_pairwise_inplace(recvbuf, recvcounts, rdispls,
+                recvtype, comm);
+
+    int rank, num_procs;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &num_procs);
+
+    int tag = 103044;
+    int ctr, n_steps;
+    int send_proc, recv_proc;
+    MPI_Aint send_pos, recv_pos;
+    long bytes;
+    double t0;
+
+    int send_size, recv_size;
+    MPI_Type_size(sendtype, &send_size);
+    MPI_Type_size(recvtype, &recv_size);
 
-        if (idx % 2 == 0 && send_idx < num_procs)
+    // Element i of a buffer starts at i * extent (datatype engine)
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
+
+    // Window may grow up to num_procs - 1 steps
+    MPI_Request* requests = (MPI_Request*)malloc(2*num_procs*sizeof(MPI_Request));
+
+    char* send_buffer = (char*)sendbuf;
+    char* recv_buffer = (char*)recvbuf;
+
+    MPIX_Type_copy(
+        send_buffer + ((MPI_Aint)sdispls[rank] * send_extent),
+        sendcounts[rank], sendtype,
+        recv_buffer + ((MPI_Aint)rdispls[rank] * recv_extent),
+        recvcounts[rank], recvtype);
+
+    MPIX_Window_start(window);
+
+    // For each batch of window->size steps
+    for (int i = 1; i < num_procs; i += n_steps)
+    {
+        n_steps = window->size;
+        if (n_steps > num_procs - i)
+            n_steps = num_procs - i;
+
+        ctr = 0;
+        bytes = 0;
+        t0 = MPI_Wtime();
+        for (int step = i; step < i + n_steps; step++)
         {
-            send_proc = rank + send_idx;
-            if (send_proc >= num_procs)
-                send_proc -= num_procs;
-            send_pos = sdispls[send_proc] * send_size;
+            get_step_peers(rank, num_procs, step, send_procs, recv_procs,
+                    &send_proc, &recv_proc);
+
+            send_pos = (MPI_Aint)sdispls[send_proc] * send_extent;
+            recv_pos = (MPI_Aint)rdispls[recv_proc] * recv_extent;
+            bytes += (long)sendcounts[send_proc] * send_size
+                + (long)recvcounts[recv_proc] * recv_size;
+
             MPI_Isend(send_buffer + send_pos, sendcounts[send_proc], sendtype, send_proc, tag,
-                    comm, &(requests[idx]));
-            send_idx++;
+                    comm, &(requests[ctr++]));
+            MPI_Irecv(recv_buffer + recv_pos, recvcounts[recv_proc], recvtype, recv_proc, tag,
+                    comm, &(requests[ctr++]));
+        }
+        MPI_Waitall(ctr, requests, MPI_STATUSES_IGNORE);
+
+        MPIX_Window_update(window, bytes, MPI_Wtime() - t0, num_procs - 1);
+    }
+
+    free(requests);
+
+    return 0;
+}
+
+/**************************************************
+ * Windowed Waitany Alltoallv
+ *  - Keeps window->size sends and window->size
+ *      receives in flight : each completed message
+ *      (MPI_Waitany) is replaced by the next step
+ *  - Even slots hold sends and odd slots receives,
+ *      and free slots are reused before new ones
+ *      are opened
+ *  - Adaptive windows are updated each time
+ *      2 * window->size messages complete.  Growing
+ *      posts more messages at once, and shrinking
+ *      stops replacing messages until few enough
+ *      are in flight
+ *************************************************/
+int alltoallv_waitany_window(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
+        MPIX_Window* window,
+        MPI_Comm comm)
+{
+    if (sendbuf == MPI_IN_PLACE)
+        return alltoallv_pairwise_inplace(recvbuf, recvcounts, rdispls,
+                recvtype, comm);
+
+    int rank, num_procs;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &num_procs);
+
+    int tag = 103044;
+    int send_proc, recv_proc;
+    MPI_Aint send_pos, recv_pos;
+
+    int send_size, recv_size;
+    MPI_Type_size(sendtype, &send_size);
+    MPI_Type_size(recvtype, &recv_size);
+
+    // Element i of a buffer starts at i * extent (datatype engine)
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
+
+    // Slots for up to num_procs - 1 steps (each way), and bytes of each
+    MPI_Request* requests = (MPI_Request*)malloc(2*num_procs*sizeof(MPI_Request));
+    long* slot_bytes = (long*)malloc(2*num_procs*sizeof(long));
+    int* free_slots = (int*)malloc(2*num_procs*sizeof(int));
+    for (int i = 0; i < 2*num_procs; i++)
+        requests[i] = MPI_REQUEST_NULL;
+
+    char* send_buffer = (char*)sendbuf;
+    char* recv_buffer = (char*)recvbuf;
+
+    MPIX_Type_copy(
+        send_buffer + ((MPI_Aint)sdispls[rank] * send_extent),
+        sendcounts[rank], sendtype,
+        recv_buffer + ((MPI_Aint)rdispls[rank] * recv_extent),
+        recvcounts[rank], recvtype);
+
+    MPIX_Window_start(window);
+
+    // For sends [0] and receives [1] :
+    // next : next step to post, active : messages in flight,
+    // n_slots : slots opened, n_free : free slots (in free_slots)
+    int next[2] = {1, 1};
+    int active[2] = {0, 0};
+    int n_slots[2] = {0, 0};
+    int n_free[2] = {0, 0};
+    int idx, dir, slot;
+    int n_done = 0;
+    long bytes = 0;
+    double t0 = MPI_Wtime();
+    while (1)
+    {
+        // Top up messages in flight to the window size, reusing
+        // free slots before opening new ones
+        for (dir = 0; dir < 2; dir++)
+        {
+            while (active[dir] < window->size && next[dir] < num_procs)
+            {
+                if (n_free[dir])
+                    slot = free_slots[dir*num_procs + (--n_free[dir])];
+                else
+                    slot = 2*(n_slots[dir]++) + dir;
+
+                get_step_peers(rank, num_procs, next[dir], send_procs, recv_procs,
+                        &send_proc, &recv_proc);
+                if (dir == 0)
+                {
+                    send_pos = (MPI_Aint)sdispls[send_proc] * send_extent;
+                    slot_bytes[slot] = (long)sendcounts[send_proc] * send_size;
+                    MPI_Isend(send_buffer + send_pos, sendcounts[send_proc], sendtype, send_proc, tag,
+                            comm, &(requests[slot]));
+                }
+                else
+                {
+                    recv_pos = (MPI_Aint)rdispls[recv_proc] * recv_extent;
+                    slot_bytes[slot] = (long)recvcounts[recv_proc] * recv_size;
+                    MPI_Irecv(recv_buffer + recv_pos, recvcounts[recv_proc], recvtype, recv_proc, tag,
+                            comm, &(requests[slot]));
+                }
+                next[dir]++;
+                active[dir]++;
+            }
         }
-        else if (idx % 2 == 1 && recv_idx < num_procs)
+
+        int n_requests = n_slots[0] > n_slots[1] ? 2*n_slots[0] : 2*n_slots[1];
+        MPI_Waitany(n_requests, requests, &idx, MPI_STATUS_IGNORE);
+
+        if (idx == MPI_UNDEFINED)
         {
-            recv_proc = rank - recv_idx;
-            if (recv_proc < 0)
-                recv_proc += num_procs;
-            recv_pos = rdispls[recv_proc] * recv_size;
+            break;
+        }
 
-            MPI_Irecv(recv_buffer + recv_pos, recvcounts[recv_proc], recvtype, recv_proc, tag,
-                    comm, &(requests[idx]));
-            recv_idx++;
+        dir = idx % 2;
+        active[dir]--;
+        free_slots[dir*num_procs + (n_free[dir]++)] = idx;
+
+        bytes += slot_bytes[idx];
+        if (++n_done == 2*window->size)
+        {
+            MPIX_Window_update(window, bytes, MPI_Wtime() - t0, num_procs - 1);
+            n_done = 0;
+            bytes = 0;
+            t0 = MPI_Wtime();
         }
     }
 
     free(requests);
+    free(slot_bytes);
+    free(free_slots);
 
     return 0;
 }
 
+/**************************************************
+ * Locality-Aware Pairwise Alltoallv
+ *  - Each pair of nodes (A, B) is assigned to the
+ *      local rank (A + B) % PPN on both nodes, as
+ *      in alltoall_loc
+ *  - 1. Exchange counts on-node : each process tells
+ *      the owner of every node how many bytes it 
+ *      sends to and receives from each process on 
+ *      that node, then sends the owner its (packed) 
+ *      blocks for the owned nodes
+ *  - 2. Owners exchange one aggregated message per
+ *      node pair over group_comm : at step i, send 
+ *      to node + i and receive from node - i (only 
+ *      the owner of each node pair takes part, so 
+ *      local ranks progress through their own
+ *      nodes independently)
+ *  - 3. Owners scatter received blocks on-node to 
+ *      their final local destination
+ *  - Blocks are packed with the datatype engine, so
+ *      any datatype and MPI_IN_PLACE are supported
+ *  - Assumes SMP ordering and equal PPN, otherwise 
+ *      falls back to alltoallv_pairwise
+ *************************************************/
+int alltoallv_pairwise_loc(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm)
+{
+    return pairwise_loc_select(sendbuf, sendcounts, sdispls, sendtype,
+            recvbuf, recvcounts, rdispls, recvtype, comm, 0);
+}
+
+// alltoallv_pairwise_loc, or alltoallv_sparse if fewer than 
+// sparse_percent % of all counts are non-zero (0 : never).  The
+// number of non-zero counts is reduced with the overflow check, so
+// selection adds no collective
+static int pairwise_loc_select(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm,
+        int sparse_percent)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(comm->global_comm, &rank);
+    MPI_Comm_size(comm->global_comm, &num_procs);
+
+    if (comm->local_comm == MPI_COMM_NULL)
+        MPIX_Comm_topo_init(comm);
+
+    // With multiple leaders per node, each leader's group acts as a node
+    MPI_Comm local_comm, group_comm;
+    get_aggregation_comms(comm, &local_comm, &group_comm);
+
+    int local_rank, ppn, num_nodes;
+    MPI_Comm_rank(local_comm, &local_rank);
+    MPI_Comm_size(local_comm, &ppn);
+    MPI_Comm_size(group_comm, &num_nodes);
+
+    // MPI_IN_PLACE : all blocks are packed before recvbuf is written
+    const char* send_buffer = (const char*)sendbuf;
+    char* recv_buffer = (char*)recvbuf;
+    if (sendbuf == MPI_IN_PLACE)
+    {
+        send_buffer = recv_buffer;
+        sendcounts = recvcounts;
+        sdispls = rdispls;
+        sendtype = recvtype;
+    }
+
+    int send_size, recv_size;
+    MPI_Type_size(sendtype, &send_size);
+    MPI_Type_size(recvtype, &recv_size);
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
+
+    long send_bytes = 0;
+    long recv_bytes = 0;
+    long n_nonzero = 0;
+    for (int i = 0; i < num_procs; i++)
+    {
+        send_bytes += (long)sendcounts[i] * send_size;
+        recv_bytes += (long)recvcounts[i] * recv_size;
+        if (sendcounts[i])
+            n_nonzero++;
+    }
+
+    // Nodes split evenly in SMP order (checked once per comm), and
+    // aggregated node messages are exchanged as MPI_BYTE counts
+    // (only the overflow check, and non-zero counts for sparse 
+    // selection, depend on this call)
+    long totals[2] = {0, n_nonzero};
+    totals[0] = (long)ppn * send_bytes > INT_MAX || (long)ppn * recv_bytes > INT_MAX;
+    int uniform = MPIX_Comm_uniform(comm) && ppn > 1 && num_nodes > 1;
+    if (uniform || sparse_percent > 0)
+        MPI_Allreduce(MPI_IN_PLACE, totals, 2, MPI_LONG, MPI_SUM, comm->global_comm);
+
+    if (totals[1] * 100 < sparse_percent * (long)num_procs * num_procs)
+    {
+        const int* send_procs;
+        const int* recv_procs;
+        MPIX_Comm_peer_schedule(comm, &send_procs, &recv_procs);
+        return alltoallv_sparse_sched(sendbuf, sendcounts, sdispls, sendtype,
+                recvbuf, recvcounts, rdispls, recvtype, send_procs, recv_procs,
+                comm->global_comm);
+    }
+
+    if (!uniform || totals[0])
+    {
+        if (sendbuf == MPI_IN_PLACE)
+            return alltoallv_pairwise_inplace(recvbuf, recvcounts, rdispls,
+                    recvtype, comm->global_comm);
+        return alltoallv_pairwise(sendbuf, sendcounts, sdispls, sendtype,
+                recvbuf, recvcounts, rdispls, recvtype, comm->global_comm);
+    }
+
+    // Byte offset of each block, all of one datatype
+    MPI_Aint* send_pos = (MPI_Aint*)malloc(num_procs*sizeof(MPI_Aint));
+    MPI_Aint* recv_pos = (MPI_Aint*)malloc(num_procs*sizeof(MPI_Aint));
+    MPI_Datatype* sendtypes = (MPI_Datatype*)malloc(num_procs*sizeof(MPI_Datatype));
+    MPI_Datatype* recvtypes = (MPI_Datatype*)malloc(num_procs*sizeof(MPI_Datatype));
+    for (int i = 0; i < num_procs; i++)
+    {
+        send_pos[i] = (MPI_Aint)sdispls[i] * send_extent;
+        recv_pos[i] = (MPI_Aint)rdispls[i] * recv_extent;
+        sendtypes[i] = sendtype;
+        recvtypes[i] = recvtype;
+    }
+
+    pairwise_loc_helper(send_buffer, sendcounts, send_pos, sendtypes,
+            recv_buffer, recvcounts, recv_pos, recvtypes, 
+            local_comm, group_comm);
+
+    free(send_pos);
+    free(recv_pos);
+    free(sendtypes);
+    free(recvtypes);
+
+    return MPI_SUCCESS;
+}
+
+// Three steps of alltoallv_pairwise_loc, once the topology is known
+// to be supported.  Block i is sendcounts[i] elements of sendtypes[i], 
+// starting send_pos[i] bytes into send_buffer (and likewise received).
+// Blocks are packed directly into (and unpacked from) the aggregated
+// byte streams with the datatype engine.
+int pairwise_loc_helper(const char* send_buffer,
+        const int sendcounts[],
+        const MPI_Aint send_pos[],
+        const MPI_Datatype sendtypes[],
+        char* recv_buffer,
+        const int recvcounts[],
+        const MPI_Aint recv_pos[],
+        const MPI_Datatype recvtypes[],
+        MPI_Comm local_comm,
+        MPI_Comm group_comm)
+{
+    int local_rank, ppn, num_nodes;
+    MPI_Comm_rank(local_comm, &local_rank);
+    MPI_Comm_size(local_comm, &ppn);
+    MPI_Comm_size(group_comm, &num_nodes);
+    int num_procs = ppn * num_nodes;
+
+    // Bytes of each block
+    int* send_sizes = (int*)malloc(num_procs*sizeof(int));
+    int* recv_sizes = (int*)malloc(num_procs*sizeof(int));
+    int send_bytes = 0;
+    int recv_bytes = 0;
+    for (int i = 0; i < num_procs; i++)
+    {
+        MPI_Type_size(sendtypes[i], &(send_sizes[i]));
+        MPI_Type_size(recvtypes[i], &(recv_sizes[i]));
+        send_sizes[i] *= sendcounts[i];
+        recv_sizes[i] *= recvcounts[i];
+        send_bytes += send_sizes[i];
+        recv_bytes += recv_sizes[i];
+    }
+
+    int rank_node;
+    MPI_Comm_rank(group_comm, &rank_node);
+
+    int tag = 103046;
+    int proc, ctr, pos, node, n_msgs;
+    MPI_Request requests[2];
+
+    // Number of nodes assigned to each local rank
+    int* n_owned = (int*)malloc(ppn*sizeof(int));
+    int* node_pos = (int*)malloc(num_nodes*sizeof(int));
+    for (int i = 0; i < ppn; i++)
+        n_owned[i] = 0;
+    for (int i = 0; i < num_nodes; i++)
+    {
+        int owner = (rank_node + i) % ppn;
+        node_pos[i] = -1;
+        if (owner == local_rank)
+            node_pos[i] = n_owned[owner];
+        n_owned[owner]++;
+    }
+    int n_mine = n_owned[local_rank];
+
+    int* local_sendcounts = (int*)malloc(ppn*sizeof(int));
+    int* local_sdispls = (int*)malloc((ppn+1)*sizeof(int));
+    int* local_recvcounts = (int*)malloc(ppn*sizeof(int));
+    int* local_rdispls = (int*)malloc((ppn+1)*sizeof(int));
+
+    // 1a. Exchange counts on-node
+    //      node_counts : [local_src][owned node][local_dest] pairs of 
+    //      (bytes local_src sends to dest, bytes local_src receives from dest)
+    int* counts_buf = (int*)malloc(2*num_nodes*ppn*sizeof(int));
+    int* node_counts = (int*)malloc(2*ppn*n_mine*ppn*sizeof(int));
+    ctr = 0;
+    local_sdispls[0] = 0;
+    for (int i = 0; i < ppn; i++)
+    {
+        for (node = (i - rank_node % ppn + ppn) % ppn; node < num_nodes; node += ppn)
+        {
+            for (int j = 0; j < ppn; j++)
+            {
+                proc = node * ppn + j;
+                counts_buf[ctr++] = send_sizes[proc];
+                counts_buf[ctr++] = recv_sizes[proc];
+            }
+        }
+        local_sendcounts[i] = 2 * n_owned[i] * ppn;
+        local_sdispls[i+1] = ctr;
+        local_recvcounts[i] = 2 * n_mine * ppn;
+        local_rdispls[i] = i * local_recvcounts[i];
+    }
+    alltoallv_pairwise(counts_buf, local_sendcounts, local_sdispls, MPI_INT,
+            node_counts, local_recvcounts, local_rdispls, MPI_INT, local_comm);
+
+    // 1b. Send packed blocks for each node to the local rank assigned 
+    //      to that node
+    char* tmpbuf = (char*)malloc(send_bytes*sizeof(char));
+    ctr = 0;
+    local_sdispls[0] = 0;
+    for (int i = 0; i < ppn; i++)
+    {
+        for (node = (i - rank_node % ppn + ppn) % ppn; node < num_nodes; node += ppn)
+        {
+            for (int j = 0; j < ppn; j++)
+            {
+                proc = node * ppn + j;
+                MPIX_Type_pack(send_buffer + send_pos[proc],
+                        sendcounts[proc], sendtypes[proc], tmpbuf + ctr);
+                ctr += send_sizes[proc];
+            }
+        }
+        local_sendcounts[i] = ctr - local_sdispls[i];
+        local_sdispls[i+1] = ctr;
+    }
+
+    // Bytes of each aggregated node message 
+    //      node_send_bytes[n] : sum over [local_src][local_dest]
+    //      node_recv_bytes[n] : sum over [remote_src][local_dest]
+    int* node_send_bytes = (int*)calloc(n_mine, sizeof(int));
+    int* node_recv_bytes = (int*)calloc(n_mine, sizeof(int));
+    local_rdispls[0] = 0;
+    for (int i = 0; i < ppn; i++)
+    {
+        local_recvcounts[i] = 0;
+        for (int n = 0; n < n_mine; n++)
+        {
+            for (int j = 0; j < ppn; j++)
+            {
+                pos = 2*((i * n_mine + n) * ppn + j);
+                local_recvcounts[i] += node_counts[pos];
+                node_send_bytes[n] += node_counts[pos];
+                node_recv_bytes[n] += node_counts[pos+1];
+            }
+        }
+        local_rdispls[i+1] = local_rdispls[i] + local_recvcounts[i];
+    }
+    int node_send_total = local_rdispls[ppn];
+    char* contig_buf = (char*)malloc(node_send_total*sizeof(char));
+    alltoallv_pairwise(tmpbuf, local_sendcounts, local_sdispls, MPI_BYTE,
+            contig_buf, local_recvcounts, local_rdispls, MPI_BYTE, local_comm);
+    free(tmpbuf);
+
+    // 2. Exchange one aggregated message with each assigned node
+    //      contig_buf : [local_src][node][local_dest]
+    //      node_sendbuf : [node][local_src][local_dest]
+    int* node_sdispls = (int*)malloc((n_mine+1)*sizeof(int));
+    int* node_rdispls = (int*)malloc((n_mine+1)*sizeof(int));
+    node_sdispls[0] = 0;
+    node_rdispls[0] = 0;
+    for (int n = 0; n < n_mine; n++)
+    {
+        node_sdispls[n+1] = node_sdispls[n] + node_send_bytes[n];
+        node_rdispls[n+1] = node_rdispls[n] + node_recv_bytes[n];
+    }
+    char* node_sendbuf = (char*)malloc(node_send_total*sizeof(char));
+    char* node_recvbuf = (char*)malloc(node_rdispls[n_mine]*sizeof(char));
+    ctr = 0;
+    for (int i = 0; i < ppn; i++)
+    {
+        for (int n = 0; n < n_mine; n++)
+        {
+            int bytes = 0;
+            for (int j = 0; j < ppn; j++)
+                bytes += node_counts[2*((i * n_mine + n) * ppn + j)];
+            memcpy(node_sendbuf + node_sdispls[n], contig_buf + ctr, bytes);
+            node_sdispls[n] += bytes;
+            ctr += bytes;
+        }
+    }
+    for (int n = 0; n < n_mine; n++)
+        node_sdispls[n] -= node_send_bytes[n];
+    free(contig_buf);
+
+    // Send to node + i, recv from node - i
+    for (int i = 0; i < num_nodes; i++)
+    {
+        int send_node = (rank_node + i) % num_nodes;
+        int recv_node = (rank_node - i + num_nodes) % num_nodes;
+
+        if (i == 0)
+        {
+            if (node_pos[rank_node] >= 0)
+            {
+                pos = node_pos[rank_node];
+                memcpy(node_recvbuf + node_rdispls[pos], node_sendbuf + node_sdispls[pos],
+                        node_send_bytes[pos]);
+            }
+            continue;
+        }
+
+        n_msgs = 0;
+        if (node_pos[recv_node] >= 0)
+        {
+            pos = node_pos[recv_node];
+            MPI_Irecv(node_recvbuf + node_rdispls[pos], node_recv_bytes[pos], MPI_BYTE,
+                    recv_node, tag, group_comm, &(requests[n_msgs++]));
+        }
+        if (node_pos[send_node] >= 0)
+        {
+            pos = node_pos[send_node];
+            MPI_Isend(node_sendbuf + node_sdispls[pos], node_send_bytes[pos], MPI_BYTE,
+                    send_node, tag, group_comm, &(requests[n_msgs++]));
+        }
+        if (n_msgs)
+            MPI_Waitall(n_msgs, requests, MPI_STATUSES_IGNORE);
+    }
+    free(node_sendbuf);
+
+    // 3. Redistribute on-node : send received blocks to the final
+    //      local destination
+    //      node_recvbuf : [node][remote_src][local_dest]
+    //      tmpbuf : [local_dest][node][remote_src]
+    tmpbuf = (char*)malloc(node_rdispls[n_mine]*sizeof(char));
+    local_sdispls[0] = 0;
+    for (int j = 0; j < ppn; j++)
+        local_sendcounts[j] = 0;
+    for (int n = 0; n < n_mine; n++)
+        for (int s = 0; s < ppn; s++)
+            for (int j = 0; j < ppn; j++)
+                local_sendcounts[j] += node_counts[2*((j * n_mine + n) * ppn + s) + 1];
+    for (int j = 0; j < ppn; j++)
+        local_sdispls[j+1] = local_sdispls[j] + local_sendcounts[j];
+    ctr = 0;
+    for (int n = 0; n < n_mine; n++)
+    {
+        for (int s = 0; s < ppn; s++)
+        {
+            for (int j = 0; j < ppn; j++)
+            {
+                int bytes = node_counts[2*((j * n_mine + n) * ppn + s) + 1];
+                memcpy(tmpbuf + local_sdispls[j], node_recvbuf + ctr, bytes);
+                local_sdispls[j] += bytes;
+                ctr += bytes;
+            }
+        }
+    }
+    for (int j = 0; j < ppn; j++)
+        local_sdispls[j] -= local_sendcounts[j];
+    free(node_recvbuf);
+
+    local_rdispls[0] = 0;
+    for (int i = 0; i < ppn; i++)
+    {
+        local_recvcounts[i] = 0;
+        for (node = (i - rank_node % ppn + ppn) % ppn; node < num_nodes; node += ppn)
+            for (int s = 0; s < ppn; s++)
+                local_recvcounts[i] += recv_sizes[node * ppn + s];
+        local_rdispls[i+1] = local_rdispls[i] + local_recvcounts[i];
+    }
+    contig_buf = (char*)malloc(recv_bytes*sizeof(char));
+    alltoallv_pairwise(tmpbuf, local_sendcounts, local_sdispls, MPI_BYTE,
+            contig_buf, local_recvcounts, local_rdispls, MPI_BYTE, local_comm);
+    free(tmpbuf);
+
+    // Unpack from [local_src][node][remote_src] to recvbuf
+    ctr = 0;
+    for (int i = 0; i < ppn; i++)
+    {
+        for (node = (i - rank_node % ppn + ppn) % ppn; node < num_nodes; node += ppn)
+        {
+            for (int s = 0; s < ppn; s++)
+            {
+                proc = node * ppn + s;
+                MPIX_Type_unpack(contig_buf + ctr, recv_buffer + recv_pos[proc],
+                        recvcounts[proc], recvtypes[proc]);
+                ctr += recv_sizes[proc];
+            }
+        }
+    }
+    free(contig_buf);
+
+    free(n_owned);
+    free(node_pos);
+    free(counts_buf);
+    free(node_counts);
+    free(node_send_bytes);
+    free(node_recv_bytes);
+    free(node_sdispls);
+    free(node_rdispls);
+    free(local_sendcounts);
+    free(local_sdispls);
+    free(local_recvcounts);
+    free(local_rdispls);
+    free(send_sizes);
+    free(recv_sizes);
+
+    return MPI_SUCCESS;
+}
+
+/**************************************************
+ * Size-Class Hybrid Alltoallv
+ *  - Blocks of at most comm->aggregation_bytes bytes
+ *      go through node aggregation 
+ *      (alltoallv_pairwise_loc, over local_comm / 
+ *      group_comm), larger blocks are sent directly
+ *      over global_comm
+ *  - Direct messages are posted first and complete
+ *      after the aggregated exchange, so both
+ *      streams progress concurrently
+ *  - Sender and receiver classify a block by its
+ *      bytes, which are equal on both sides
+ *  - MPI_IN_PLACE : all blocks are aggregated 
+ *      (alltoallv_pairwise_loc packs every block 
+ *      before recvbuf is written)
+ *************************************************/
+int alltoallv_hybrid_loc(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm)
+{
+    if (sendbuf == MPI_IN_PLACE)
+        return alltoallv_pairwise_loc(sendbuf, sendcounts, sdispls, sendtype,
+                recvbuf, recvcounts, rdispls, recvtype, comm);
+
+    int rank, num_procs;
+    MPI_Comm_rank(comm->global_comm, &rank);
+    MPI_Comm_size(comm->global_comm, &num_procs);
+
+    int tag = 103047;
+    long max_bytes = comm->aggregation_bytes;
+
+    int send_size, recv_size;
+    MPI_Type_size(sendtype, &send_size);
+    MPI_Type_size(recvtype, &recv_size);
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
+
+    const char* send_buffer = (const char*)sendbuf;
+    char* recv_buffer = (char*)recvbuf;
+
+    // Counts of aggregated blocks (zero for direct blocks)
+    int* small_sendcounts = (int*)malloc(num_procs*sizeof(int));
+    int* small_recvcounts = (int*)malloc(num_procs*sizeof(int));
+    MPI_Request* requests = (MPI_Request*)malloc(2*num_procs*sizeof(MPI_Request));
+    int n_requests = 0;
+
+    for (int i = 0; i < num_procs; i++)
+    {
+        small_recvcounts[i] = recvcounts[i];
+        if ((long)recvcounts[i] * recv_size <= max_bytes || i == rank)
+            continue;
+
+        small_recvcounts[i] = 0;
+        MPI_Irecv(recv_buffer + (MPI_Aint)rdispls[i] * recv_extent, recvcounts[i],
+                recvtype, i, tag, comm->global_comm, &(requests[n_requests++]));
+    }
+    for (int i = 0; i < num_procs; i++)
+    {
+        small_sendcounts[i] = sendcounts[i];
+        if ((long)sendcounts[i] * send_size <= max_bytes || i == rank)
+            continue;
+
+        small_sendcounts[i] = 0;
+        MPI_Isend(send_buffer + (MPI_Aint)sdispls[i] * send_extent, sendcounts[i],
+                sendtype, i, tag, comm->global_comm, &(requests[n_requests++]));
+    }
+
+    // Large block to self is copied directly
+    if ((long)sendcounts[rank] * send_size > max_bytes)
+    {
+        MPIX_Type_copy(send_buffer + (MPI_Aint)sdispls[rank] * send_extent,
+                sendcounts[rank], sendtype,
+                recv_buffer + (MPI_Aint)rdispls[rank] * recv_extent,
+                recvcounts[rank], recvtype);
+        small_sendcounts[rank] = 0;
+        small_recvcounts[rank] = 0;
+    }
+
+    alltoallv_pairwise_loc(sendbuf, small_sendcounts, sdispls, sendtype,
+            recvbuf, small_recvcounts, rdispls, recvtype, comm);
+
+    MPI_Waitall(n_requests, requests, MPI_STATUSES_IGNORE);
+
+    free(small_sendcounts);
+    free(small_recvcounts);
+    free(requests);
+
+    return MPI_SUCCESS;
+}
+
+/**************************************************
+ * Bruck Alltoallv
+ *  - log2(p) steps as in alltoall_bruck, for small
+ *      irregular blocks where latency dominates
+ *  - Blocks are packed (datatype engine) and
+ *      forwarded through intermediate processes,
+ *      which do not know their sizes : each message
+ *      carries the byte length of every block it
+ *      holds, followed by the blocks
+ *  - Message sizes are found with MPI_Probe, so
+ *      every step is a single exchange
+ *  - Blocks are unpacked into rdispls at the end,
+ *      so any datatype and MPI_IN_PLACE are 
+ *      supported
+ *  - Total bytes held by a process must fit in int
+ *************************************************/
+int alltoallv_bruck(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPI_Comm comm)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &num_procs);
+
+    // MPI_IN_PLACE : blocks are packed before recvbuf is written
+    if (sendbuf == MPI_IN_PLACE)
+    {
+        sendbuf = recvbuf;
+        sendcounts = recvcounts;
+        sdispls = rdispls;
+        sendtype = recvtype;
+    }
+
+    int send_size, recv_size;
+    MPI_Type_size(sendtype, &send_size);
+    MPI_Type_size(recvtype, &recv_size);
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
+
+    const char* send_buffer = (const char*)sendbuf;
+    char* recv_buffer = (char*)recvbuf;
+
+    int* send_lengths = (int*)malloc(num_procs*sizeof(int));
+    int* recv_lengths = (int*)malloc(num_procs*sizeof(int));
+    int pos = 0;
+    for (int i = 0; i < num_procs; i++)
+    {
+        send_lengths[i] = sendcounts[i] * send_size;
+        pos += send_lengths[i];
+    }
+
+    // Pack blocks in order of destination
+    char* packed_buf = (char*)malloc(pos*sizeof(char));
+    pos = 0;
+    for (int i = 0; i < num_procs; i++)
+    {
+        MPIX_Type_pack(send_buffer + (MPI_Aint)sdispls[i] * send_extent,
+                sendcounts[i], sendtype, packed_buf + pos);
+        pos += send_lengths[i];
+    }
+
+    char* contig_buf;
+    bruck_v_helper(packed_buf, send_lengths, 1, &contig_buf, recv_lengths, comm);
+
+    // contig_buf holds blocks in order of source
+    pos = 0;
+    for (int i = 0; i < num_procs; i++)
+    {
+        MPIX_Type_unpack(contig_buf + pos, 
+                recv_buffer + (MPI_Aint)rdispls[i] * recv_extent,
+                recvcounts[i], recvtype);
+        pos += recv_lengths[i];
+    }
+
+    free(send_lengths);
+    free(recv_lengths);
+    free(packed_buf);
+    free(contig_buf);
+
+    return MPI_SUCCESS;
+}
+
+// Bruck order is fixed by the algorithm, so the communicator's
+// peer schedule is ignored
+int alltoallv_bruck_sched(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
+        MPI_Comm comm)
+{
+    (void)send_procs;
+    (void)recv_procs;
+    return alltoallv_bruck(sendbuf, sendcounts, sdispls, sendtype,
+            recvbuf, recvcounts, rdispls, recvtype, comm);
+}
+
+// block_pos[i] : first byte of block i (of n_sub sub-blocks each)
+static void bruck_block_positions(const int* lengths, int n_sub,
+        int num_procs, int* block_pos)
+{
+    block_pos[0] = 0;
+    for (int i = 0; i < num_procs; i++)
+    {
+        block_pos[i+1] = block_pos[i];
+        for (int j = 0; j < n_sub; j++)
+            block_pos[i+1] += lengths[i*n_sub + j];
+    }
+}
+
+int bruck_v_helper(const char* sendbuf,
+        const int* send_lengths,
+        const int n_sub,
+        char** recvbuf_ptr,
+        int* recv_lengths,
+        MPI_Comm comm)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &num_procs);
+
+    int tag = 103048;
+    int send_proc, recv_proc;
+    int n_blocks, bytes, len, pos, recv_pos;
+    int header_bytes, msg_bytes, recv_msg_bytes;
+    MPI_Request request;
+    MPI_Status status;
+
+    int n_lengths = num_procs * n_sub;
+    int* lengths = (int*)malloc(n_lengths*sizeof(int));
+    int* new_lengths = (int*)malloc(n_lengths*sizeof(int));
+    int* block_pos = (int*)malloc((num_procs+1)*sizeof(int));
+    int* tmp_lengths;
+
+    memcpy(lengths, send_lengths, n_lengths*sizeof(int));
+    bruck_block_positions(lengths, n_sub, num_procs, block_pos);
+    int total = block_pos[num_procs];
+    char* tmpbuf = (char*)malloc(total*sizeof(char));
+    char* new_buf;
+    memcpy(tmpbuf, sendbuf, total);
+
+    // 1. Rotate so that block i is sent to rank + i
+    rotate(tmpbuf, block_pos[rank], total);
+    rotate(lengths, rank*n_sub*sizeof(int), n_lengths*sizeof(int));
+
+    // 2. At step k, send each block with bit k set to rank + k
+    //      message : sub-block lengths of each block, then blocks
+    for (int k = 1; k < num_procs; k <<= 1)
+    {
+        send_proc = rank + k;
+        if (send_proc >= num_procs)
+            send_proc -= num_procs;
+        recv_proc = rank - k;
+        if (recv_proc < 0)
+            recv_proc += num_procs;
+
+        bruck_block_positions(lengths, n_sub, num_procs, block_pos);
+
+        // Same number of blocks sent and received
+        n_blocks = 0;
+        bytes = 0;
+        for (int i = k; i < num_procs; i++)
+        {
+            if (i & k)
+            {
+                n_blocks++;
+                bytes += block_pos[i+1] - block_pos[i];
+            }
+        }
+        header_bytes = n_blocks * n_sub * sizeof(int);
+        msg_bytes = header_bytes + bytes;
+
+        char* send_msg = (char*)malloc(msg_bytes*sizeof(char));
+        int* send_header = (int*)send_msg;
+        pos = header_bytes;
+        n_blocks = 0;
+        for (int i = k; i < num_procs; i++)
+        {
+            if (i & k)
+            {
+                memcpy(send_header + n_blocks*n_sub, lengths + i*n_sub, 
+                        n_sub*sizeof(int));
+                len = block_pos[i+1] - block_pos[i];
+                memcpy(send_msg + pos, tmpbuf + block_pos[i], len);
+                pos += len;
+                n_blocks++;
+            }
+        }
+
+        MPI_Isend(send_msg, msg_bytes, MPI_BYTE, send_proc, tag, 
+                comm, &request);
+
+        // Size of incoming blocks is only known to the sender
+        MPI_Probe(recv_proc, tag, comm, &status);
+        MPI_Get_count(&status, MPI_BYTE, &recv_msg_bytes);
+        char* recv_msg = (char*)malloc(recv_msg_bytes*sizeof(char));
+        int* recv_header = (int*)recv_msg;
+        MPI_Recv(recv_msg, recv_msg_bytes, MPI_BYTE, recv_proc, tag,
+                comm, MPI_STATUS_IGNORE);
+
+        MPI_Wait(&request, MPI_STATUS_IGNORE);
+
+        // Replace blocks with bit k by received blocks
+        total += (recv_msg_bytes - header_bytes) - bytes;
+        new_buf = (char*)malloc(total*sizeof(char));
+        pos = 0;
+        recv_pos = header_bytes;
+        n_blocks = 0;
+        for (int i = 0; i < num_procs; i++)
+        {
+            if (i & k)
+            {
+                memcpy(new_lengths + i*n_sub, recv_header + n_blocks*n_sub,
+                        n_sub*sizeof(int));
+                len = 0;
+                for (int j = 0; j < n_sub; j++)
+                    len += new_lengths[i*n_sub + j];
+                memcpy(new_buf + pos, recv_msg + recv_pos, len);
+                recv_pos += len;
+                n_blocks++;
+            }
+            else
+            {
+                memcpy(new_lengths + i*n_sub, lengths + i*n_sub,
+                        n_sub*sizeof(int));
+                len = block_pos[i+1] - block_pos[i];
+                memcpy(new_buf + pos, tmpbuf + block_pos[i], len);
+            }
+            pos += len;
+        }
+
+        free(send_msg);
+        free(recv_msg);
+        free(tmpbuf);
+        tmpbuf = new_buf;
+        tmp_lengths = lengths;
+        lengths = new_lengths;
+        new_lengths = tmp_lengths;
+    }
+
+    // 3. Block i now holds data from rank - i
+    //      Reorder so block j holds data from j
+    bruck_block_positions(lengths, n_sub, num_procs, block_pos);
+    char* recv_buffer = (char*)malloc(total*sizeof(char));
+    pos = 0;
+    for (int j = 0; j < num_procs; j++)
+    {
+        int i = rank - j;
+        if (i < 0)
+            i += num_procs;
+        len = block_pos[i+1] - block_pos[i];
+        memcpy(recv_buffer + pos, tmpbuf + block_pos[i], len);
+        memcpy(recv_lengths + j*n_sub, lengths + i*n_sub, n_sub*sizeof(int));
+        pos += len;
+    }
+    *recvbuf_ptr = recv_buffer;
+
+    free(lengths);
+    free(new_lengths);
+    free(block_pos);
+    free(tmpbuf);
+
+    return MPI_SUCCESS;
+}
+
+/**************************************************
+ * Locality-Aware Bruck Alltoallv (two-level)
+ *  - Gathers all packed blocks (and their lengths)
+ *      on-node to a single leader (local rank 0)
+ *  - Leaders perform Bruck alltoallv over group_comm
+ *      with one block per node pair, made of the
+ *      ppn * ppn blocks between the two nodes
+ *      (lengths travel with each block)
+ *  - Leaders scatter received blocks on-node, and
+ *      each process unpacks them into rdispls
+ *  - If leader_comm is initialized, each leader 
+ *      aggregates its leader_comm rather than the node
+ *  - Assumes SMP ordering and equal PPN, otherwise 
+ *      falls back to alltoallv_bruck
+ *************************************************/
+int alltoallv_bruck_loc(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(comm->global_comm, &rank);
+    MPI_Comm_size(comm->global_comm, &num_procs);
+
+    if (comm->local_comm == MPI_COMM_NULL)
+        MPIX_Comm_topo_init(comm);
+
+    // With multiple leaders per node, each leader's group acts as a node
+    MPI_Comm local_comm, group_comm;
+    get_aggregation_comms(comm, &local_comm, &group_comm);
+
+    int local_rank, ppn, num_nodes;
+    MPI_Comm_rank(local_comm, &local_rank);
+    MPI_Comm_size(local_comm, &ppn);
+    MPI_Comm_size(group_comm, &num_nodes);
+
+    // Nodes split evenly in SMP order (checked once per comm)
+    if (!MPIX_Comm_uniform(comm) || ppn == 1 || num_nodes == 1)
+        return alltoallv_bruck(sendbuf, sendcounts, sdispls, sendtype,
+                recvbuf, recvcounts, rdispls, recvtype, comm->global_comm);
+
+    // MPI_IN_PLACE : blocks are gathered to the leader
+    // before recvbuf is written by the scatter
+    if (sendbuf == MPI_IN_PLACE)
+    {
+        sendbuf = recvbuf;
+        sendcounts = recvcounts;
+        sdispls = rdispls;
+        sendtype = recvtype;
+    }
+
+    int send_size, recv_size;
+    MPI_Type_size(sendtype, &send_size);
+    MPI_Type_size(recvtype, &recv_size);
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
+
+    const char* send_buffer = (const char*)sendbuf;
+    char* recv_buffer = (char*)recvbuf;
+
+    int* send_lengths = (int*)malloc(num_procs*sizeof(int));
+    int send_bytes = 0;
+    int recv_bytes = 0;
+    for (int i = 0; i < num_procs; i++)
+    {
+        send_lengths[i] = sendcounts[i] * send_size;
+        send_bytes += send_lengths[i];
+        recv_bytes += recvcounts[i] * recv_size;
+    }
+
+    char* packed_buf = (char*)malloc(send_bytes*sizeof(char));
+    int pos = 0;
+    for (int i = 0; i < num_procs; i++)
+    {
+        MPIX_Type_pack(send_buffer + (MPI_Aint)sdispls[i] * send_extent,
+                sendcounts[i], sendtype, packed_buf + pos);
+        pos += send_lengths[i];
+    }
+
+    int* local_lengths = NULL;
+    int* local_bytes = NULL;
+    int* local_displs = NULL;
+    char* tmpbuf = NULL;
+    char* contig_buf = NULL;
+    if (local_rank == 0)
+    {
+        local_lengths = (int*)malloc(ppn*num_procs*sizeof(int));
+        local_bytes = (int*)malloc(ppn*sizeof(int));
+        local_displs = (int*)malloc((ppn+1)*sizeof(int));
+    }
+
+    // 1. Gather all blocks on-node to leader
+    //      tmpbuf : [local_src][dest]
+    MPI_Gather(send_lengths, num_procs, MPI_INT,
+            local_lengths, num_procs, MPI_INT, 0, local_comm);
+    MPI_Gather(&send_bytes, 1, MPI_INT, local_bytes, 1, MPI_INT, 0, local_comm);
+    if (local_rank == 0)
+    {
+        local_displs[0] = 0;
+        for (int i = 0; i < ppn; i++)
+            local_displs[i+1] = local_displs[i] + local_bytes[i];
+        tmpbuf = (char*)malloc(local_displs[ppn]*sizeof(char));
+    }
+    MPI_Gatherv(packed_buf, send_bytes, MPI_BYTE,
+            tmpbuf, local_bytes, local_displs, MPI_BYTE, 0, local_comm);
+
+    if (local_rank == 0)
+    {
+        int n_sub = ppn * ppn;
+        int* src_pos = (int*)malloc(ppn*num_procs*sizeof(int));
+        int* node_lengths = (int*)malloc(num_nodes*n_sub*sizeof(int));
+        int* recv_lengths = (int*)malloc(num_nodes*n_sub*sizeof(int));
+        int idx, len;
+
+        for (int i = 0; i < ppn; i++)
+        {
+            pos = local_displs[i];
+            for (int j = 0; j < num_procs; j++)
+            {
+                src_pos[i*num_procs + j] = pos;
+                pos += local_lengths[i*num_procs + j];
+            }
+        }
+
+        // 2. Bruck among leaders, one block per node
+        //      contig_buf : [node][local_src][local_dest]
+        contig_buf = (char*)malloc(local_displs[ppn]*sizeof(char));
+        pos = 0;
+        for (int node = 0; node < num_nodes; node++)
+        {
+            for (int i = 0; i < ppn; i++)
+            {
+                for (int j = 0; j < ppn; j++)
+                {
+                    idx = i*num_procs + node*ppn + j;
+                    len = local_lengths[idx];
+                    node_lengths[node*n_sub + i*ppn + j] = len;
+                    memcpy(contig_buf + pos, tmpbuf + src_pos[idx], len);
+                    pos += len;
+                }
+            }
+        }
+        free(tmpbuf);
+        bruck_v_helper(contig_buf, node_lengths, n_sub, &tmpbuf,
+                recv_lengths, group_comm);
+        free(contig_buf);
+
+        // tmpbuf : [node][src][local_dest]
+        // contig_buf : [local_dest][node][src]
+        bruck_block_positions(recv_lengths, 1, num_nodes*n_sub, src_pos);
+        contig_buf = (char*)malloc(src_pos[num_nodes*n_sub]*sizeof(char));
+        pos = 0;
+        for (int j = 0; j < ppn; j++)
+        {
+            local_displs[j] = pos;
+            for (int node = 0; node < num_nodes; node++)
+            {
+                for (int i = 0; i < ppn; i++)
+                {
+                    idx = node*n_sub + i*ppn + j;
+                    len = recv_lengths[idx];
+                    memcpy(contig_buf + pos, tmpbuf + src_pos[idx], len);
+                    pos += len;
+                }
+            }
+            local_bytes[j] = pos - local_displs[j];
+        }
+
+        free(src_pos);
+        free(node_lengths);
+        free(recv_lengths);
+    }
+
+    // 3. Scatter on-node to final destination, in order of source
+    char* recv_packed = (char*)malloc(recv_bytes*sizeof(char));
+    MPI_Scatterv(contig_buf, local_bytes, local_displs, MPI_BYTE,
+            recv_packed, recv_bytes, MPI_BYTE, 0, local_comm);
+
+    pos = 0;
+    for (int i = 0; i < num_procs; i++)
+    {
+        MPIX_Type_unpack(recv_packed + pos, 
+                recv_buffer + (MPI_Aint)rdispls[i] * recv_extent,
+                recvcounts[i], recvtype);
+        pos += recvcounts[i] * recv_size;
+    }
+
+    if (local_rank == 0)
+    {
+        free(local_lengths);
+        free(local_bytes);
+        free(local_displs);
+        free(tmpbuf);
+        free(contig_buf);
+    }
+    free(send_lengths);
+    free(packed_buf);
+    free(recv_packed);
+
+    return MPI_SUCCESS;
+}
+
+/**************************************************
+ * Multithreaded Alltoallv
+ *  - Under MPI_THREAD_MULTIPLE, an OpenMP team
+ *      (bound with proc_bind(spread)) splits the
+ *      steps of the peer schedule : thread t
+ *      drives steps t+1, t+1+T, ... (T threads)
+ *  - Each thread posts and waits on its own 
+ *      contiguous slice of comm->requests
+ *  - Blocks of non-contiguous datatypes are packed
+ *      and unpacked by the thread that sends or
+ *      receives them, in buffers it allocates
+ *      (so pages are first touched by that thread)
+ *  - Falls back to alltoallv_nonblocking without
+ *      OpenMP, MPI_THREAD_MULTIPLE, or more than
+ *      one thread
+ *************************************************/
+int alltoallv_threaded(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(comm->global_comm, &rank);
+    MPI_Comm_size(comm->global_comm, &num_procs);
+
+    int num_threads = threaded_num_threads(comm->global_comm);
+    if (sendbuf == MPI_IN_PLACE || num_threads < 2)
+        return alltoallv_nonblocking(sendbuf, sendcounts, sdispls, sendtype,
+                recvbuf, recvcounts, rdispls, recvtype, comm->global_comm);
+
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
+
+    const char* send_buffer = (const char*)sendbuf;
+    char* recv_buffer = (char*)recvbuf;
+
+    MPIX_Type_copy(send_buffer + (MPI_Aint)sdispls[rank] * send_extent,
+            sendcounts[rank], sendtype,
+            recv_buffer + (MPI_Aint)rdispls[rank] * recv_extent,
+            recvcounts[rank], recvtype);
+
+    MPI_Aint* send_pos = (MPI_Aint*)malloc(num_procs*sizeof(MPI_Aint));
+    MPI_Aint* recv_pos = (MPI_Aint*)malloc(num_procs*sizeof(MPI_Aint));
+    for (int i = 0; i < num_procs; i++)
+    {
+        send_pos[i] = (MPI_Aint)sdispls[i] * send_extent;
+        recv_pos[i] = (MPI_Aint)rdispls[i] * recv_extent;
+    }
+
+    const int* send_procs;
+    const int* recv_procs;
+    MPIX_Comm_peer_schedule(comm, &send_procs, &recv_procs);
+
+    if (2*(num_procs-1) > comm->n_requests)
+        MPIX_Comm_req_resize(comm, 2*(num_procs-1));
+
+    threaded_exchange(send_buffer, sendcounts, send_pos, sendtype,
+            recv_buffer, recvcounts, recv_pos, recvtype, 
+            send_procs, recv_procs, num_threads, comm->requests,
+            comm->global_comm);
+
+    free(send_pos);
+    free(recv_pos);
+
+    return MPI_SUCCESS;
+}
+
+int threaded_num_threads(MPI_Comm comm)
+{
+    int num_threads = 1;
+#ifdef OPENMP
+    int provided;
+    MPI_Query_thread(&provided);
+    if (provided == MPI_THREAD_MULTIPLE)
+        num_threads = omp_get_max_threads();
+#endif
+
+    // At most one thread per step
+    int num_procs;
+    MPI_Comm_size(comm, &num_procs);
+    if (num_threads > num_procs - 1)
+        num_threads = num_procs - 1;
+    return num_threads;
+}
+
+// Steps of the peer schedule driven by thread_id (of num_threads)
+static void threaded_steps(const char* send_buffer,
+        const int sendcounts[],
+        const MPI_Aint send_pos[],
+        MPI_Datatype sendtype,
+        char* recv_buffer,
+        const int recvcounts[],
+        const MPI_Aint recv_pos[],
+        MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
+        int thread_id,
+        int num_threads,
+        MPI_Request* requests,
+        MPI_Comm comm)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &num_procs);
+
+    int tag = 103050;
+    int send_proc, recv_proc, step;
+
+    int send_size, recv_size;
+    MPI_Type_size(sendtype, &send_size);
+    MPI_Type_size(recvtype, &recv_size);
+    int pack_send = !MPIX_Type_is_contiguous(sendtype);
+    int pack_recv = !MPIX_Type_is_contiguous(recvtype);
+
+    // Thread's steps, and its slice of requests
+    int n_steps = num_procs - 1;
+    int thread_n_steps = n_steps / num_threads;
+    int extra_steps = n_steps % num_threads;
+    int first = thread_id * thread_n_steps 
+        + (thread_id < extra_steps ? thread_id : extra_steps);
+    if (thread_id < extra_steps)
+        thread_n_steps++;
+    MPI_Request* thread_requests = requests + 2*first;
+
+    // Packing buffers, owned by this thread
+    long send_bytes = 0;
+    long recv_bytes = 0;
+    for (int i = 0; i < thread_n_steps; i++)
+    {
+        step = thread_id + 1 + i*num_threads;
+        get_step_peers(rank, num_procs, step, send_procs, recv_procs,
+                &send_proc, &recv_proc);
+        send_bytes += (long)sendcounts[send_proc] * send_size;
+        recv_bytes += (long)recvcounts[recv_proc] * recv_size;
+    }
+    char* send_packed = NULL;
+    char* recv_packed = NULL;
+    if (pack_send)
+        send_packed = (char*)malloc(send_bytes*sizeof(char));
+    if (pack_recv)
+        recv_packed = (char*)malloc(recv_bytes*sizeof(char));
+
+    send_bytes = 0;
+    recv_bytes = 0;
+    for (int i = 0; i < thread_n_steps; i++)
+    {
+        step = thread_id + 1 + i*num_threads;
+        get_step_peers(rank, num_procs, step, send_procs, recv_procs,
+                &send_proc, &recv_proc);
+
+        if (pack_recv)
+        {
+            MPI_Irecv(recv_packed + recv_bytes, recvcounts[recv_proc] * recv_size,
+                    MPI_BYTE, recv_proc, tag, comm, &(thread_requests[2*i+1]));
+            recv_bytes += (long)recvcounts[recv_proc] * recv_size;
+        }
+        else
+            MPI_Irecv(recv_buffer + recv_pos[recv_proc], recvcounts[recv_proc],
+                    recvtype, recv_proc, tag, comm, &(thread_requests[2*i+1]));
+
+        if (pack_send)
+        {
+            MPIX_Type_pack(send_buffer + send_pos[send_proc], sendcounts[send_proc],
+                    sendtype, send_packed + send_bytes);
+            MPI_Isend(send_packed + send_bytes, sendcounts[send_proc] * send_size,
+                    MPI_BYTE, send_proc, tag, comm, &(thread_requests[2*i]));
+            send_bytes += (long)sendcounts[send_proc] * send_size;
+        }
+        else
+            MPI_Isend(send_buffer + send_pos[send_proc], sendcounts[send_proc],
+                    sendtype, send_proc, tag, comm, &(thread_requests[2*i]));
+    }
+
+    MPI_Waitall(2*thread_n_steps, thread_requests, MPI_STATUSES_IGNORE);
+
+    if (pack_recv)
+    {
+        recv_bytes = 0;
+        for (int i = 0; i < thread_n_steps; i++)
+        {
+            step = thread_id + 1 + i*num_threads;
+            get_step_peers(rank, num_procs, step, send_procs, recv_procs,
+                    &send_proc, &recv_proc);
+            MPIX_Type_unpack(recv_packed + recv_bytes, recv_buffer + recv_pos[recv_proc],
+                    recvcounts[recv_proc], recvtype);
+            recv_bytes += (long)recvcounts[recv_proc] * recv_size;
+        }
+    }
+
+    free(send_packed);
+    free(recv_packed);
+}
+
+int threaded_exchange(const char* send_buffer,
+        const int sendcounts[],
+        const MPI_Aint send_pos[],
+        MPI_Datatype sendtype,
+        char* recv_buffer,
+        const int recvcounts[],
+        const MPI_Aint recv_pos[],
+        MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
+        int num_threads,
+        MPI_Request* requests,
+        MPI_Comm comm)
+{
+    // Flattened types are cached here, before threads read them
+    MPIX_Type_is_contiguous(sendtype);
+    MPIX_Type_is_contiguous(recvtype);
+
+#ifdef OPENMP
+#pragma omp parallel num_threads(num_threads) proc_bind(spread)
+    threaded_steps(send_buffer, sendcounts, send_pos, sendtype,
+            recv_buffer, recvcounts, recv_pos, recvtype,
+            send_procs, recv_procs, omp_get_thread_num(), num_threads,
+            requests, comm);
+#else
+    threaded_steps(send_buffer, sendcounts, send_pos, sendtype,
+            recv_buffer, recvcounts, recv_pos, recvtype,
+            send_procs, recv_procs, 0, 1, requests, comm);
+#endif
+
+    return MPI_SUCCESS;
+}
+
+/**************************************************
+ * Big-Count Alltoallv
+ *  - Counts are MPI_Count and displacements are 
+ *      MPI_Aint (both in elements)
+ *  - If all counts and displacements fit in int
+ *      (on every process), calls MPIX_Alltoallv
+ *  - Otherwise exchanges pairwise (in the order of
+ *      comm->peer_schedule), sending any block of 
+ *      more than INT_MAX elements as a single 
+ *      derived datatype
+ *************************************************/
+int MPIX_Alltoallv_c(const void* sendbuf,
+        const MPI_Count sendcounts[],
+        const MPI_Aint sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const MPI_Count recvcounts[],
+        const MPI_Aint rdispls[],
+        MPI_Datatype recvtype,
+        MPIX_Comm* mpi_comm)
+{
+    int num_procs;
+    MPI_Comm_size(mpi_comm->global_comm, &num_procs);
+
+    int big = 0;
+    for (int i = 0; i < num_procs; i++)
+    {
+        if (recvcounts[i] > INT_MAX || rdispls[i] > INT_MAX)
+            big = 1;
+        if (sendbuf != MPI_IN_PLACE 
+                && (sendcounts[i] > INT_MAX || sdispls[i] > INT_MAX))
+            big = 1;
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &big, 1, MPI_INT, MPI_MAX, mpi_comm->global_comm);
+
+    if (big)
+    {
+        if (sendbuf == MPI_IN_PLACE)
+            return alltoallv_pairwise_inplace_c(recvbuf, recvcounts, rdispls,
+                    recvtype, mpi_comm->global_comm);
+
+        const int* send_procs;
+        const int* recv_procs;
+        MPIX_Comm_peer_schedule(mpi_comm, &send_procs, &recv_procs);
+        return alltoallv_pairwise_c(sendbuf, sendcounts, sdispls, sendtype,
+                recvbuf, recvcounts, rdispls, recvtype, 
+                send_procs, recv_procs, mpi_comm->global_comm);
+    }
+
+    // [sendcounts, sdispls, recvcounts, rdispls]
+    int* counts = (int*)malloc(4*num_procs*sizeof(int));
+    int* int_sendcounts = NULL;
+    int* int_sdispls = NULL;
+    int* int_recvcounts = counts + 2*num_procs;
+    int* int_rdispls = counts + 3*num_procs;
+    if (sendbuf != MPI_IN_PLACE)
+    {
+        int_sendcounts = counts;
+        int_sdispls = counts + num_procs;
+    }
+    for (int i = 0; i < num_procs; i++)
+    {
+        if (sendbuf != MPI_IN_PLACE)
+        {
+            int_sendcounts[i] = sendcounts[i];
+            int_sdispls[i] = sdispls[i];
+        }
+        int_recvcounts[i] = recvcounts[i];
+        int_rdispls[i] = rdispls[i];
+    }
+
+    int ierr = MPIX_Alltoallv(sendbuf, int_sendcounts, int_sdispls, sendtype,
+            recvbuf, int_recvcounts, int_rdispls, recvtype, mpi_comm);
+
+    free(counts);
+
+    return ierr;
+}
+
+// Count and datatype describing 'count' elements of 'type' :
+// more than INT_MAX elements are sent as one big_type_contiguous
+static void big_count_args(MPI_Count count, MPI_Datatype type, 
+        int* n, MPI_Datatype* count_type)
+{
+    if (count <= INT_MAX)
+    {
+        *n = count;
+        *count_type = type;
+        return;
+    }
+    *n = 1;
+    big_type_contiguous(count, type, count_type);
+}
+
+int alltoallv_pairwise_c(const void* sendbuf,
+        const MPI_Count sendcounts[],
+        const MPI_Aint sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const MPI_Count recvcounts[],
+        const MPI_Aint rdispls[],
+        MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
+        MPI_Comm comm)
+{
+    if (sendbuf == MPI_IN_PLACE)
+        return alltoallv_pairwise_inplace_c(recvbuf, recvcounts, rdispls,
+                recvtype, comm);
+
+    int rank, num_procs;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &num_procs);
+
+    int tag = 103044;
+    int send_proc, recv_proc;
+    int send_n, recv_n;
+    MPI_Datatype send_type, recv_type;
+    MPI_Status status;
+
+    // Element i of a buffer starts at i * extent (datatype engine)
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
+
+    char* send_buffer = (char*)sendbuf;
+    char* recv_buffer = (char*)recvbuf;
+
+    big_count_args(sendcounts[rank], sendtype, &send_n, &send_type);
+    big_count_args(recvcounts[rank], recvtype, &recv_n, &recv_type);
+    MPIX_Type_copy(send_buffer + sdispls[rank] * send_extent,
+            send_n, send_type,
+            recv_buffer + rdispls[rank] * recv_extent,
+            recv_n, recv_type);
+    if (send_type != sendtype)
+        MPI_Type_free(&send_type);
+    if (recv_type != recvtype)
+        MPI_Type_free(&recv_type);
+
+    for (int i = 1; i < num_procs; i++)
+    {
+        get_step_peers(rank, num_procs, i, send_procs, recv_procs,
+                &send_proc, &recv_proc);
+
+        big_count_args(sendcounts[send_proc], sendtype, &send_n, &send_type);
+        big_count_args(recvcounts[recv_proc], recvtype, &recv_n, &recv_type);
+
+        MPI_Sendrecv(send_buffer + sdispls[send_proc] * send_extent, 
+                send_n, send_type, send_proc, tag,
+                recv_buffer + rdispls[recv_proc] * recv_extent, 
+                recv_n, recv_type, recv_proc, tag,
+                comm, &status);
+
+        if (send_type != sendtype)
+            MPI_Type_free(&send_type);
+        if (recv_type != recvtype)
+            MPI_Type_free(&recv_type);
+    }
+
+    return 0;
+}
+
+// Same symmetric pairing as alltoallv_pairwise_inplace
+int alltoallv_pairwise_inplace_c(void* recvbuf,
+        const MPI_Count recvcounts[],
+        const MPI_Aint rdispls[],
+        MPI_Datatype recvtype,
+        MPI_Comm comm)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &num_procs);
+
+    int tag = 103044;
+    int proc, n;
+    MPI_Aint pos;
+    MPI_Datatype count_type;
+    MPI_Status status;
+
+    MPI_Count max_count = 0;
+    for (int i = 0; i < num_procs; i++)
+        if (recvcounts[i] > max_count)
+            max_count = recvcounts[i];
+
+    char* recv_buffer = (char*)recvbuf;
+
+    // Scratch spans the largest block (only bytes in the type map are copied)
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
+    MPI_Aint true_lb, true_extent;
+    MPI_Type_get_true_extent(recvtype, &true_lb, &true_extent);
+    MPI_Aint span = 0;
+    if (max_count)
+        span = (max_count - 1) * recv_extent + true_extent;
+
+    char* scratch = (char*)malloc(span*sizeof(char));
+    char* scratch_block = scratch - true_lb;
+
+    for (int r = 0; r < num_procs; r++)
+    {
+        proc = r - rank;
+        if (proc < 0)
+            proc += num_procs;
+        if (proc == rank)
+            continue;
+        pos = rdispls[proc] * recv_extent;
+
+        big_count_args(recvcounts[proc], recvtype, &n, &count_type);
+        MPIX_Type_copy(recv_buffer + pos, n, count_type,
+                scratch_block, n, count_type);
+        MPI_Sendrecv(scratch_block, n, count_type, proc, tag,
+                recv_buffer + pos, n, count_type, proc, tag,
+                comm, &status);
+        if (count_type != recvtype)
+            MPI_Type_free(&count_type);
+    }
+
+    free(scratch);
+
+    return 0;
+}
@@ -12,6 +12,12 @@ extern "C"
 {
 #endif
 
+// Alltoallv over a given order of pairwise exchanges : at step i, 
+// send to send_procs[i] and receive from recv_procs[i]
+// (see MPIX_Comm_peer_schedule, NULL for rank + i / rank - i)
+typedef int (*alltoallv_sched_ftn)(const void*, const int*, const int*, MPI_Datatype, 
+        void*, const int*, const int*, MPI_Datatype, const int*, const int*, MPI_Comm);
+
 // Helper Functions
 int alltoallv_pairwise(const void* sendbuf,
         const int sendcounts[],
@@ -49,6 +55,15 @@ int alltoallv_pairwise_nonblocking(const void* sendbuf,
         const int rdispls[],
         MPI_Datatype recvtype,
         MPI_Comm comm);
+int alltoallv_pairwise_nonblocking_log2(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPI_Comm comm);
 int alltoallv_waitany(const void* sendbuf,
         const int sendcounts[],
         const int sdispls[],
@@ -58,7 +73,7 @@ int alltoallv_waitany(const void* sendbuf,
         const int rdispls[],
         MPI_Datatype recvtype,
         MPI_Comm comm);
-int alltoallv_pairwise_nonblocking_log2(const void* sendbuf,
+int alltoallv_sparse(const void* sendbuf,
         const int sendcounts[],
         const int sdispls[],
         MPI_Datatype sendtype,
@@ -67,12 +82,164 @@ int alltoallv_pairwise_nonblocking_log2(const void* sendbuf,
         const int rdispls[],
         MPI_Datatype recvtype,
         MPI_Comm comm);
-
-
-
-
-
-
+int alltoallv_bruck(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPI_Comm comm);
+int alltoallv_pairwise_sched(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
+        MPI_Comm comm);
+int alltoallv_nonblocking_sched(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
+        MPI_Comm comm);
+int alltoallv_pairwise_nonblocking_sched(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
+        MPI_Comm comm);
+int alltoallv_waitany_sched(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
+        MPI_Comm comm);
+int alltoallv_sparse_sched(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
+        MPI_Comm comm);
+// In-flight window given by window (see MPIX_Window_update), the
+// _sched versions above use a fixed window of 5
+int alltoallv_pairwise_nonblocking_window(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
+        MPIX_Window* window,
+        MPI_Comm comm);
+int alltoallv_waitany_window(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
+        MPIX_Window* window,
+        MPI_Comm comm);
+// XOR methods ignore send_procs / recv_procs
+int alltoallv_pairwise_log2_sched(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
+        MPI_Comm comm);
+int alltoallv_pairwise_nonblocking_log2_sched(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
+        MPI_Comm comm);
+// Bruck method ignores send_procs / recv_procs
+int alltoallv_bruck_sched(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
+        MPI_Comm comm);
+// Bruck alltoallv of variable blocks over any communicator : sendbuf 
+// holds a block per process (in order of destination), each made of 
+// n_sub sub-blocks of send_lengths bytes.  Allocates *recvbuf_ptr,
+// holding blocks in order of source, with sub-block recv_lengths.
+int bruck_v_helper(const char* sendbuf,
+        const int* send_lengths,
+        const int n_sub,
+        char** recvbuf_ptr,
+        int* recv_lengths,
+        MPI_Comm comm);
+// MPI_IN_PLACE (sendbuf == MPI_IN_PLACE in any method above)
+int alltoallv_pairwise_inplace(void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPI_Comm comm);
+// Big-count pairwise exchanges (see MPIX_Alltoallv_c)
+int alltoallv_pairwise_c(const void* sendbuf,
+        const MPI_Count sendcounts[],
+        const MPI_Aint sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const MPI_Count recvcounts[],
+        const MPI_Aint rdispls[],
+        MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
+        MPI_Comm comm);
+int alltoallv_pairwise_inplace_c(void* recvbuf,
+        const MPI_Count recvcounts[],
+        const MPI_Aint rdispls[],
+        MPI_Datatype recvtype,
+        MPI_Comm comm);
 int alltoallv_pairwise_loc(const void* sendbuf,
         const int sendcounts[],
         const int sdispls[],
@@ -82,6 +249,66 @@ int alltoallv_pairwise_loc(const void* sendbuf,
         const int rdispls[],
         MPI_Datatype recvtype,
         MPIX_Comm* comm);
+// Aggregated exchange of alltoallv_pairwise_loc, for blocks of any
+// datatype at byte offsets send_pos / recv_pos (topology must be 
+// supported : SMP ordering and equal PPN)
+int pairwise_loc_helper(const char* send_buffer,
+        const int sendcounts[],
+        const MPI_Aint send_pos[],
+        const MPI_Datatype sendtypes[],
+        char* recv_buffer,
+        const int recvcounts[],
+        const MPI_Aint recv_pos[],
+        const MPI_Datatype recvtypes[],
+        MPI_Comm local_comm,
+        MPI_Comm group_comm);
+// OpenMP threads split peers (MPI_THREAD_MULTIPLE)
+int alltoallv_threaded(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm);
+// Threads that threaded methods use on comm : OpenMP threads under
+// MPI_THREAD_MULTIPLE (otherwise 1), at most one per peer
+int threaded_num_threads(MPI_Comm comm);
+// Exchange with every peer but self, split over num_threads threads.
+// Block i is sendcounts[i] elements at byte send_pos[i] (likewise
+// received), and requests holds at least 2 * (num_procs - 1).
+int threaded_exchange(const char* send_buffer,
+        const int sendcounts[],
+        const MPI_Aint send_pos[],
+        MPI_Datatype sendtype,
+        char* recv_buffer,
+        const int recvcounts[],
+        const MPI_Aint recv_pos[],
+        MPI_Datatype recvtype,
+        const int* send_procs,
+        const int* recv_procs,
+        int num_threads,
+        MPI_Request* requests,
+        MPI_Comm comm);
+int alltoallv_hybrid_loc(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm);
+int alltoallv_bruck_loc(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm);
 
 
 #ifdef __cplusplus
@@ -0,0 +1,587 @@
+#include "alltoallv_init.h"
+#include <string.h>
+#include <limits.h>
+
+/**************************************************
+ * Persistent Locality-Aware Alltoallv
+ *  - Same three steps as alltoallv_pairwise_loc :
+ *      gather on-node all data for a subset of
+ *      nodes, exchange one aggregated message with
+ *      each of those nodes, then redistribute
+ *      received data on-node
+ *  - Node pairs are assigned to local ranks by byte
+ *      volume (balance_node_pairs) rather than round
+ *      robin, so skewed alltoallv patterns do not
+ *      leave one rank with most inter-node bytes
+ *  - Byte volumes, plan (LocalityComm), staging
+ *      buffers and inter-node requests are computed
+ *      once at init : MPIX_Start/MPIX_Wait only pack
+ *      and communicate
+ *  - Counts, displacements and buffers are fixed
+ *      at init
+ *  - Falls back to alltoallv_init_schedule if
+ *      topology is not supported (see
+ *      alltoallv_init_loc)
+ *************************************************/
+int MPIX_Alltoallv_init(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPIX_Comm* mpi_comm,
+        MPI_Info info,
+        MPIX_Request** request_ptr)
+{
+    return alltoallv_init_loc(sendbuf,
+        sendcounts,
+        sdispls,
+        sendtype,
+        recvbuf,
+        recvcounts,
+        rdispls,
+        recvtype,
+        mpi_comm,
+        info,
+        request_ptr);
+}
+
+typedef struct _NodePair
+{
+    long bytes;
+    int node_a;
+    int node_b;
+} NodePair;
+
+// Largest volume first (ties in node order, so every process
+// sorts identically)
+static int compare_node_pairs(const void* a, const void* b)
+{
+    const NodePair* pair_a = (const NodePair*)a;
+    const NodePair* pair_b = (const NodePair*)b;
+    if (pair_a->bytes != pair_b->bytes)
+        return pair_a->bytes < pair_b->bytes ? 1 : -1;
+    if (pair_a->node_a != pair_b->node_a)
+        return pair_a->node_a - pair_b->node_a;
+    return pair_a->node_b - pair_b->node_b;
+}
+
+/**************************************************
+ * Load-Balanced Node Pair Assignment
+ *  - Local rank l of node a exchanges with local
+ *      rank l of node b, so each (unordered) node
+ *      pair is owned by one local rank index
+ *  - Volume of a pair is the bytes sent in both
+ *      directions (node_bytes gathered from all
+ *      processes)
+ *  - Greedy, largest pair first : each pair goes
+ *      to the local rank whose busier endpoint (on
+ *      either node) has the fewest bytes so far,
+ *      then the fewest pairs (so equal volumes
+ *      spread round robin)
+ *  - Every process computes the same assignment
+ *  - Collective over global_comm, and assumes SMP
+ *      ordering with equal ppn
+ *************************************************/
+void balance_node_pairs(const MPIX_Comm* comm,
+        const int sendcounts[],
+        int send_size,
+        int* owner)
+{
+    int num_procs;
+    MPI_Comm_size(comm->global_comm, &num_procs);
+
+    int ppn = comm->ppn;
+    int num_nodes = comm->num_nodes;
+    int rank_node = comm->rank_node;
+
+    // node_bytes[a*num_nodes + b] : bytes from node a to node b
+    long* node_bytes = (long*)calloc((long)num_nodes*num_nodes, sizeof(long));
+    long* my_bytes = &(node_bytes[(long)rank_node*num_nodes]);
+    for (int i = 0; i < num_procs; i++)
+        my_bytes[get_node(comm, i)] += (long)sendcounts[i] * send_size;
+    MPI_Allreduce(MPI_IN_PLACE, node_bytes, num_nodes*num_nodes, MPI_LONG,
+            MPI_SUM, comm->global_comm);
+
+    int n_pairs = 0;
+    NodePair* pairs = (NodePair*)malloc(((long)num_nodes*(num_nodes-1)/2 + 1)*sizeof(NodePair));
+    for (int a = 0; a < num_nodes; a++)
+    {
+        for (int b = a + 1; b < num_nodes; b++)
+        {
+            pairs[n_pairs].bytes = node_bytes[(long)a*num_nodes + b]
+                + node_bytes[(long)b*num_nodes + a];
+            pairs[n_pairs].node_a = a;
+            pairs[n_pairs].node_b = b;
+            n_pairs++;
+        }
+    }
+    qsort(pairs, n_pairs, sizeof(NodePair), compare_node_pairs);
+
+    // Bytes and pairs assigned to local rank l of node a (a*ppn + l)
+    long* load = (long*)calloc(num_procs, sizeof(long));
+    int* n_assigned = (int*)calloc(num_procs, sizeof(int));
+    for (int i = 0; i < n_pairs; i++)
+    {
+        int a = pairs[i].node_a;
+        int b = pairs[i].node_b;
+        int best = 0;
+        long best_load = 0;
+        int best_count = 0;
+        for (int l = 0; l < ppn; l++)
+        {
+            long l_load = load[a*ppn + l];
+            if (load[b*ppn + l] > l_load)
+                l_load = load[b*ppn + l];
+            int l_count = n_assigned[a*ppn + l];
+            if (n_assigned[b*ppn + l] > l_count)
+                l_count = n_assigned[b*ppn + l];
+
+            if (l == 0 || l_load < best_load
+                    || (l_load == best_load && l_count < best_count))
+            {
+                best = l;
+                best_load = l_load;
+                best_count = l_count;
+            }
+        }
+        load[a*ppn + best] += pairs[i].bytes;
+        load[b*ppn + best] += pairs[i].bytes;
+        n_assigned[a*ppn + best]++;
+        n_assigned[b*ppn + best]++;
+
+        if (a == rank_node)
+            owner[b] = best;
+        else if (b == rank_node)
+            owner[a] = best;
+    }
+    owner[rank_node] = -1;
+
+    free(node_bytes);
+    free(pairs);
+    free(load);
+    free(n_assigned);
+}
+
+/**************************************************
+ * Persistent Locality-Aware Alltoallv (plan)
+ *  - Data is moved in elements (send and recv
+ *      types must have equal size), indexed by
+ *      sdispls/rdispls as in the neighbor plans
+ *  - owner[node] : local rank exchanging with
+ *      remote node (balance_node_pairs)
+ *  - Owners first receive the counts of the
+ *      processes on their node for the nodes they
+ *      own (on-node alltoallv of counts)
+ *  - local_L : data for processes on my node,
+ *      exchanged directly on-node
+ *  - local_S : data for each remote node, sent to
+ *      its owner
+ *      recv buffer : [local_src][owned node][local_dest]
+ *  - global : one message per owned node, with the
+ *      owner (same local rank) of that node
+ *      recv buffer : [owned node][src][local_dest]
+ *  - local_R : received data, sent to its local
+ *      destination
+ *  - On-node phases use node-shared memory
+ *      (neighbor_shm_start / neighbor_shm_wait)
+ *  - Assumes SMP ordering and equal PPN, otherwise
+ *      falls back to alltoallv_init_schedule
+ *************************************************/
+int alltoallv_init_loc(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm,
+        MPI_Info info,
+        MPIX_Request** request_ptr)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(comm->global_comm, &rank);
+    MPI_Comm_size(comm->global_comm, &num_procs);
+
+    if (comm->local_comm == MPI_COMM_NULL)
+        MPIX_Comm_topo_init(comm);
+
+    int local_rank, ppn, num_nodes, rank_node;
+    MPI_Comm_rank(comm->local_comm, &local_rank);
+    MPI_Comm_size(comm->local_comm, &ppn);
+    num_nodes = comm->num_nodes;
+    rank_node = comm->rank_node;
+
+    // All processes must agree on PPN (min and max are equal), and
+    // elements are staged as bytes, so send and recv elements
+    // must have equal size
+    int send_size, recv_size;
+    MPI_Type_size(sendtype, &send_size);
+    MPI_Type_size(recvtype, &recv_size);
+    int ppn_range[3] = {ppn, -ppn, send_size == recv_size && send_size > 0};
+    MPI_Allreduce(MPI_IN_PLACE, ppn_range, 3, MPI_INT, MPI_MIN, comm->global_comm);
+
+    if (ppn_range[0] != -ppn_range[1] || !ppn_range[2] || num_nodes * ppn != num_procs
+            || ppn == 1 || num_nodes == 1)
+        return alltoallv_init_schedule(sendbuf, sendcounts, sdispls, sendtype,
+                recvbuf, recvcounts, rdispls, recvtype, comm, info, request_ptr);
+
+    int* owner = (int*)malloc(num_nodes*sizeof(int));
+    balance_node_pairs(comm, sendcounts, send_size, owner);
+
+    // Remote nodes owned by each local rank (mine : in node order)
+    int* n_owned = (int*)calloc(ppn, sizeof(int));
+    for (int node = 0; node < num_nodes; node++)
+        if (node != rank_node)
+            n_owned[owner[node]]++;
+    int n_mine = n_owned[local_rank];
+    int* mine = (int*)malloc((n_mine+1)*sizeof(int));
+    int pos = 0;
+    for (int node = 0; node < num_nodes; node++)
+        if (node != rank_node && owner[node] == local_rank)
+            mine[pos++] = node;
+
+    // Counts exchange : (sendcount, recvcount) of each process for
+    //      each process of the nodes owned by local rank i
+    //      counts[((src*n_mine + p)*ppn + j)*2] : count from local
+    //      src to local j of node mine[p] (+1 : from that process)
+    int* cnt_sizes = (int*)malloc(ppn*sizeof(int));
+    int* cnt_displs = (int*)malloc((ppn+1)*sizeof(int));
+    int* cnt_recv_sizes = (int*)malloc(ppn*sizeof(int));
+    int* cnt_recv_displs = (int*)malloc((ppn+1)*sizeof(int));
+    int* cnt_send = (int*)malloc((2*(num_nodes-1)*ppn+1)*sizeof(int));
+    int* counts = (int*)malloc((2*ppn*n_mine*ppn+1)*sizeof(int));
+    int ctr = 0;
+    cnt_displs[0] = 0;
+    cnt_recv_displs[0] = 0;
+    for (int i = 0; i < ppn; i++)
+    {
+        for (int node = 0; node < num_nodes; node++)
+        {
+            if (node == rank_node || owner[node] != i)
+                continue;
+            for (int j = 0; j < ppn; j++)
+            {
+                int proc = get_global_proc(comm, node, j);
+                cnt_send[ctr++] = sendcounts[proc];
+                cnt_send[ctr++] = recvcounts[proc];
+            }
+        }
+        cnt_displs[i+1] = ctr;
+        cnt_sizes[i] = ctr - cnt_displs[i];
+        cnt_recv_sizes[i] = 2*n_mine*ppn;
+        cnt_recv_displs[i+1] = cnt_recv_displs[i] + cnt_recv_sizes[i];
+    }
+    alltoallv_pairwise(cnt_send, cnt_sizes, cnt_displs, MPI_INT,
+            counts, cnt_recv_sizes, cnt_recv_displs, MPI_INT, comm->local_comm);
+
+    // Sizes of each buffer (elements), and offsets of each
+    //      [src][owned node][local_dest] block in local_S recv buffer
+    //      and [owned node][src][local_dest] block in global recv buffer
+    int n_blocks = ppn*n_mine*ppn;
+    long* S_offsets = (long*)malloc((n_blocks+1)*sizeof(long));
+    long* R_offsets = (long*)malloc((n_blocks+1)*sizeof(long));
+    long L_send = 0, L_recv = 0, S_send = 0, R_recv = 0;
+    for (int j = 0; j < ppn; j++)
+    {
+        int proc = get_global_proc(comm, rank_node, j);
+        L_send += sendcounts[proc];
+        L_recv += recvcounts[proc];
+    }
+    for (int i = 0; i < num_procs; i++)
+    {
+        if (get_node(comm, i) == rank_node)
+            continue;
+        S_send += sendcounts[i];
+        R_recv += recvcounts[i];
+    }
+    S_offsets[0] = 0;
+    for (int i = 0; i < n_blocks; i++)
+        S_offsets[i+1] = S_offsets[i] + counts[2*i];
+    R_offsets[0] = 0;
+    ctr = 0;
+    for (int p = 0; p < n_mine; p++)
+        for (int i = 0; i < ppn; i++)
+            for (int j = 0; j < ppn; j++)
+            {
+                R_offsets[ctr+1] = R_offsets[ctr] + counts[2*((j*n_mine + p)*ppn + i) + 1];
+                ctr++;
+            }
+
+    // Buffers (and node-shared segments) are sized in bytes (int)
+    long max_size = L_send;
+    if (L_recv > max_size) max_size = L_recv;
+    if (S_send > max_size) max_size = S_send;
+    if (R_recv > max_size) max_size = R_recv;
+    if (S_offsets[n_blocks] > max_size) max_size = S_offsets[n_blocks];
+    if (R_offsets[n_blocks] > max_size) max_size = R_offsets[n_blocks];
+    int too_big = max_size * send_size > INT_MAX;
+    MPI_Allreduce(MPI_IN_PLACE, &too_big, 1, MPI_INT, MPI_MAX, comm->global_comm);
+    if (too_big)
+    {
+        free(owner);
+        free(n_owned);
+        free(mine);
+        free(cnt_sizes);
+        free(cnt_displs);
+        free(cnt_recv_sizes);
+        free(cnt_recv_displs);
+        free(cnt_send);
+        free(counts);
+        free(S_offsets);
+        free(R_offsets);
+        return alltoallv_init_schedule(sendbuf, sendcounts, sdispls, sendtype,
+                recvbuf, recvcounts, rdispls, recvtype, comm, info, request_ptr);
+    }
+
+    // Internal buffers hold packed elements
+    MPI_Datatype packed_type;
+    MPI_Type_contiguous(send_size, MPI_BYTE, &packed_type);
+    MPI_Type_commit(&packed_type);
+
+    MPIX_Request* request;
+    init_neighbor_request(&request);
+    init_locality_comm(&(request->locality), comm, packed_type, packed_type);
+    LocalityComm* locality = request->locality;
+    CommData* send_data;
+    CommData* recv_data;
+    int proc, n_msgs;
+
+    // local_L : data to and from each local rank
+    send_data = locality->local_L_comm->send_data;
+    recv_data = locality->local_L_comm->recv_data;
+    init_num_msgs(send_data, ppn);
+    init_size_msgs(send_data, L_send);
+    init_num_msgs(recv_data, ppn);
+    init_size_msgs(recv_data, L_recv);
+    int send_ctr = 0;
+    int recv_ctr = 0;
+    for (int i = 0; i < ppn; i++)
+    {
+        proc = get_global_proc(comm, rank_node, i);
+        for (int k = 0; k < sendcounts[proc]; k++)
+            send_data->indices[send_ctr++] = sdispls[proc] + k;
+        for (int k = 0; k < recvcounts[proc]; k++)
+            recv_data->indices[recv_ctr++] = rdispls[proc] + k;
+        send_data->procs[i] = i;
+        send_data->indptr[i+1] = send_ctr;
+        recv_data->procs[i] = i;
+        recv_data->indptr[i+1] = recv_ctr;
+    }
+
+    // local_S : send data for nodes owned by local rank i
+    send_data = locality->local_S_comm->send_data;
+    recv_data = locality->local_S_comm->recv_data;
+    n_msgs = 0;
+    for (int i = 0; i < ppn; i++)
+        if (n_owned[i])
+            n_msgs++;
+    init_num_msgs(send_data, n_msgs);
+    init_size_msgs(send_data, S_send);
+    ctr = 0;
+    n_msgs = 0;
+    for (int i = 0; i < ppn; i++)
+    {
+        if (n_owned[i] == 0)
+            continue;
+        for (int node = 0; node < num_nodes; node++)
+        {
+            if (node == rank_node || owner[node] != i)
+                continue;
+            for (int j = 0; j < ppn; j++)
+            {
+                proc = get_global_proc(comm, node, j);
+                for (int k = 0; k < sendcounts[proc]; k++)
+                    send_data->indices[ctr++] = sdispls[proc] + k;
+            }
+        }
+        send_data->procs[n_msgs++] = i;
+        send_data->indptr[n_msgs] = ctr;
+    }
+    n_msgs = n_mine ? ppn : 0;
+    init_num_msgs(recv_data, n_msgs);
+    init_size_msgs(recv_data, S_offsets[n_blocks]);
+    for (int i = 0; i < n_msgs; i++)
+    {
+        recv_data->procs[i] = i;
+        recv_data->indptr[i+1] = S_offsets[(i+1)*n_mine*ppn];
+    }
+    for (int i = 0; i < recv_data->size_msgs; i++)
+        recv_data->indices[i] = i;
+
+    // global : exchange [local_src][local_dest] with each owned node
+    //      indices point into local_S recv buffer
+    send_data = locality->global_comm->send_data;
+    recv_data = locality->global_comm->recv_data;
+    init_num_msgs(send_data, n_mine);
+    init_size_msgs(send_data, S_offsets[n_blocks]);
+    init_num_msgs(recv_data, n_mine);
+    init_size_msgs(recv_data, R_offsets[n_blocks]);
+    ctr = 0;
+    for (int p = 0; p < n_mine; p++)
+    {
+        for (int i = 0; i < ppn; i++)
+            for (int j = 0; j < ppn; j++)
+            {
+                int block = (i*n_mine + p)*ppn + j;
+                for (long k = S_offsets[block]; k < S_offsets[block+1]; k++)
+                    send_data->indices[ctr++] = k;
+            }
+        send_data->procs[p] = get_global_proc(comm, mine[p], local_rank);
+        recv_data->procs[p] = send_data->procs[p];
+        send_data->indptr[p+1] = ctr;
+        recv_data->indptr[p+1] = R_offsets[(p+1)*ppn*ppn];
+    }
+    for (int i = 0; i < recv_data->size_msgs; i++)
+        recv_data->indices[i] = i;
+
+    // local_R : send received data to local destination
+    //      indices point into global recv buffer
+    send_data = locality->local_R_comm->send_data;
+    recv_data = locality->local_R_comm->recv_data;
+    n_msgs = n_mine ? ppn : 0;
+    init_num_msgs(send_data, n_msgs);
+    init_size_msgs(send_data, R_offsets[n_blocks]);
+    ctr = 0;
+    for (int j = 0; j < n_msgs; j++)
+    {
+        for (int p = 0; p < n_mine; p++)
+            for (int i = 0; i < ppn; i++)
+            {
+                int block = (p*ppn + i)*ppn + j;
+                for (long k = R_offsets[block]; k < R_offsets[block+1]; k++)
+                    send_data->indices[ctr++] = k;
+            }
+        send_data->procs[j] = j;
+        send_data->indptr[j+1] = ctr;
+    }
+    n_msgs = 0;
+    for (int i = 0; i < ppn; i++)
+        if (n_owned[i])
+            n_msgs++;
+    init_num_msgs(recv_data, n_msgs);
+    init_size_msgs(recv_data, R_recv);
+    ctr = 0;
+    n_msgs = 0;
+    for (int i = 0; i < ppn; i++)
+    {
+        if (n_owned[i] == 0)
+            continue;
+        for (int node = 0; node < num_nodes; node++)
+        {
+            if (node == rank_node || owner[node] != i)
+                continue;
+            for (int j = 0; j < ppn; j++)
+            {
+                proc = get_global_proc(comm, node, j);
+                for (int k = 0; k < recvcounts[proc]; k++)
+                    recv_data->indices[ctr++] = rdispls[proc] + k;
+            }
+        }
+        recv_data->procs[n_msgs++] = i;
+        recv_data->indptr[n_msgs] = ctr;
+    }
+
+    finalize_locality_comm(locality);
+
+    request->sendbuf = sendbuf;
+    request->recvbuf = recvbuf;
+    request->recv_size = send_size;
+    request->sendtype = sendtype;
+    request->recvtype = recvtype;
+    request->packed_type = packed_type;
+
+    // On-node phases exchange through node-shared memory, and
+    // inter-node requests over staging buffers
+    init_neighbor_shm(request, comm);
+
+    free(owner);
+    free(n_owned);
+    free(mine);
+    free(cnt_sizes);
+    free(cnt_displs);
+    free(cnt_recv_sizes);
+    free(cnt_recv_displs);
+    free(cnt_send);
+    free(counts);
+    free(S_offsets);
+    free(R_offsets);
+
+    *request_ptr = request;
+
+    return MPI_SUCCESS;
+}
+
+/**************************************************
+ * Persistent Pairwise Alltoallv
+ *  - One persistent send and receive per process,
+ *      in order of comm->peer_schedule
+ *  - All started at once in MPIX_Start
+ *************************************************/
+int alltoallv_init_schedule(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm,
+        MPI_Info info,
+        MPIX_Request** request_ptr)
+{
+    (void)info;
+    int rank, num_procs;
+    MPI_Comm_rank(comm->global_comm, &rank);
+    MPI_Comm_size(comm->global_comm, &num_procs);
+
+    const int* send_procs;
+    const int* recv_procs;
+    MPIX_Comm_peer_schedule(comm, &send_procs, &recv_procs);
+
+    init_request(request_ptr);
+    MPIX_Request* request = *request_ptr;
+    request->global_n_msgs = 2*num_procs;
+    allocate_requests(request->global_n_msgs, &(request->global_requests));
+    request->start_function = (void*) neighbor_start;
+    request->wait_function = (void*) neighbor_wait;
+    request->test_function = (void*) neighbor_test;
+
+    int tag = 103044;
+    int send_proc, recv_proc;
+    MPI_Aint send_pos, recv_pos;
+
+    const char* send_buffer = (const char*)sendbuf;
+    char* recv_buffer = (char*)recvbuf;
+
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
+
+    for (int i = 0; i < num_procs; i++)
+    {
+        get_step_peers(rank, num_procs, i, send_procs, recv_procs,
+                &send_proc, &recv_proc);
+        send_pos = (MPI_Aint)sdispls[send_proc] * send_extent;
+        recv_pos = (MPI_Aint)rdispls[recv_proc] * recv_extent;
+
+        MPI_Send_init(send_buffer + send_pos,
+                sendcounts[send_proc],
+                sendtype,
+                send_proc,
+                tag,
+                comm->global_comm,
+                &(request->global_requests[i]));
+        MPI_Recv_init(recv_buffer + recv_pos,
+                recvcounts[recv_proc],
+                recvtype,
+                recv_proc,
+                tag,
+                comm->global_comm,
+                &(request->global_requests[num_procs+i]));
+    }
+
+    return MPI_SUCCESS;
+}
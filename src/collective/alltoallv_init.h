@@ -0,0 +1,66 @@
+#ifndef MPI_ADVANCE_ALLTOALLV_INIT_H
+#define MPI_ADVANCE_ALLTOALLV_INIT_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <mpi.h>
+#include "utils/utils.h"
+#include "collective.h"
+#include "locality/topology.h"
+#include "persistent/persistent.h"
+#include "neighborhood/neighbor_persistent.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+int MPIX_Alltoallv_init(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPIX_Comm* mpi_comm,
+        MPI_Info info,
+        MPIX_Request** request_ptr);
+
+// Helper Functions
+int alltoallv_init_loc(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm,
+        MPI_Info info,
+        MPIX_Request** request_ptr);
+int alltoallv_init_schedule(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm,
+        MPI_Info info,
+        MPIX_Request** request_ptr);
+
+// owner[node] : local rank exchanging with node (-1 for my node),
+// balancing inter-node bytes across local ranks
+void balance_node_pairs(const MPIX_Comm* comm,
+        const int sendcounts[],
+        int send_size,
+        int* owner);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,278 @@
+#include "collective.h"
+#include <string.h>
+#include <limits.h>
+
+/**************************************************
+ * Locality-Aware Point-to-Point Alltoallw
+ *  - Each block has its own datatype, and
+ *      displacements are in bytes
+ *  - Same three steps as alltoallv_pairwise_loc :
+ *      blocks are packed with the datatype engine
+ *      straight into node-aggregated byte streams,
+ *      exchanged once per node pair, and unpacked
+ *      from them (no contiguous copy of each block
+ *      is made first)
+ *  - Falls back to alltoallw_pairwise if topology
+ *      is not supported (see alltoallw_pairwise_loc)
+ *************************************************/
+int MPIX_Alltoallw(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        const MPI_Datatype sendtypes[],
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        const MPI_Datatype recvtypes[],
+        MPIX_Comm* mpi_comm)
+{
+    return alltoallw_pairwise_loc(sendbuf,
+        sendcounts,
+        sdispls,
+        sendtypes,
+        recvbuf,
+        recvcounts,
+        rdispls,
+        recvtypes,
+        mpi_comm);
+}
+
+int alltoallw_pairwise(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        const MPI_Datatype sendtypes[],
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        const MPI_Datatype recvtypes[],
+        MPI_Comm comm)
+{
+    if (sendbuf == MPI_IN_PLACE)
+        return alltoallw_pairwise_inplace(recvbuf, recvcounts, rdispls,
+                recvtypes, comm);
+
+    int rank, num_procs;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &num_procs);
+
+    int tag = 103049;
+    int send_proc, recv_proc;
+    MPI_Status status;
+
+    const char* send_buffer = (const char*)sendbuf;
+    char* recv_buffer = (char*)recvbuf;
+
+    MPIX_Type_copy(send_buffer + sdispls[rank], sendcounts[rank], sendtypes[rank],
+            recv_buffer + rdispls[rank], recvcounts[rank], recvtypes[rank]);
+
+    // Send to rank + i
+    // Recv from rank - i
+    for (int i = 1; i < num_procs; i++)
+    {
+        get_step_peers(rank, num_procs, i, NULL, NULL, &send_proc, &recv_proc);
+
+        MPI_Sendrecv(send_buffer + sdispls[send_proc], sendcounts[send_proc], 
+                sendtypes[send_proc], send_proc, tag,
+                recv_buffer + rdispls[recv_proc], recvcounts[recv_proc], 
+                recvtypes[recv_proc], recv_proc, tag,
+                comm, &status);
+    }
+
+    return MPI_SUCCESS;
+}
+
+int alltoallw_nonblocking(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        const MPI_Datatype sendtypes[],
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        const MPI_Datatype recvtypes[],
+        MPI_Comm comm)
+{
+    if (sendbuf == MPI_IN_PLACE)
+        return alltoallw_pairwise_inplace(recvbuf, recvcounts, rdispls,
+                recvtypes, comm);
+
+    int rank, num_procs;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &num_procs);
+
+    int tag = 103049;
+    int send_proc, recv_proc;
+
+    MPI_Request* requests = (MPI_Request*)malloc(2*num_procs*sizeof(MPI_Request));
+    int n_requests = 0;
+
+    const char* send_buffer = (const char*)sendbuf;
+    char* recv_buffer = (char*)recvbuf;
+
+    MPIX_Type_copy(send_buffer + sdispls[rank], sendcounts[rank], sendtypes[rank],
+            recv_buffer + rdispls[rank], recvcounts[rank], recvtypes[rank]);
+
+    // Receives are all posted before sends
+    for (int i = 1; i < num_procs; i++)
+    {
+        get_step_peers(rank, num_procs, i, NULL, NULL, &send_proc, &recv_proc);
+        MPI_Irecv(recv_buffer + rdispls[recv_proc], recvcounts[recv_proc],
+                recvtypes[recv_proc], recv_proc, tag, comm, &(requests[n_requests++]));
+    }
+    for (int i = 1; i < num_procs; i++)
+    {
+        get_step_peers(rank, num_procs, i, NULL, NULL, &send_proc, &recv_proc);
+        MPI_Isend(send_buffer + sdispls[send_proc], sendcounts[send_proc],
+                sendtypes[send_proc], send_proc, tag, comm, &(requests[n_requests++]));
+    }
+
+    MPI_Waitall(n_requests, requests, MPI_STATUSES_IGNORE);
+
+    free(requests);
+
+    return MPI_SUCCESS;
+}
+
+/**************************************************
+ * In-Place Pairwise Alltoallw (MPI_IN_PLACE)
+ *  - Same symmetric pairing as alltoallv_pairwise_inplace :
+ *      at round r, swap blocks with (r - rank) mod p
+ *  - Scratch holds a single block (largest span)
+ *************************************************/
+int alltoallw_pairwise_inplace(void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        const MPI_Datatype recvtypes[],
+        MPI_Comm comm)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &num_procs);
+
+    int tag = 103049;
+    int proc;
+    MPI_Status status;
+
+    char* recv_buffer = (char*)recvbuf;
+
+    // Scratch spans the largest block (only bytes in the type map are copied)
+    MPI_Aint true_lb, true_extent, extent;
+    MPI_Aint max_span = 0;
+    for (int i = 0; i < num_procs; i++)
+    {
+        if (recvcounts[i] == 0 || i == rank)
+            continue;
+        extent = MPIX_Type_extent(recvtypes[i]);
+        MPI_Type_get_true_extent(recvtypes[i], &true_lb, &true_extent);
+        if ((recvcounts[i] - 1) * extent + true_extent > max_span)
+            max_span = (recvcounts[i] - 1) * extent + true_extent;
+    }
+    char* scratch = (char*)malloc(max_span*sizeof(char));
+
+    for (int r = 0; r < num_procs; r++)
+    {
+        proc = r - rank;
+        if (proc < 0)
+            proc += num_procs;
+        if (proc == rank)
+            continue;
+
+        MPI_Type_get_true_extent(recvtypes[proc], &true_lb, &true_extent);
+        char* scratch_block = scratch - true_lb;
+
+        MPIX_Type_copy(recv_buffer + rdispls[proc], recvcounts[proc], recvtypes[proc],
+                scratch_block, recvcounts[proc], recvtypes[proc]);
+        MPI_Sendrecv(scratch_block, recvcounts[proc], recvtypes[proc], proc, tag,
+                recv_buffer + rdispls[proc], recvcounts[proc], recvtypes[proc], proc, tag,
+                comm, &status);
+    }
+
+    free(scratch);
+
+    return MPI_SUCCESS;
+}
+
+/**************************************************
+ * Locality-Aware Pairwise Alltoallw
+ *  - Same node pair assignment and three steps
+ *      as alltoallv_pairwise_loc (pairwise_loc_helper)
+ *  - Each block is packed with its own datatype 
+ *      directly into the on-node byte stream, and
+ *      unpacked with its own datatype from the
+ *      final on-node stream
+ *  - MPI_IN_PLACE : all blocks are packed before 
+ *      recvbuf is written
+ *  - Assumes SMP ordering and equal PPN, otherwise 
+ *      falls back to alltoallw_pairwise
+ *************************************************/
+int alltoallw_pairwise_loc(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        const MPI_Datatype sendtypes[],
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        const MPI_Datatype recvtypes[],
+        MPIX_Comm* comm)
+{
+    int num_procs;
+    MPI_Comm_size(comm->global_comm, &num_procs);
+
+    if (comm->local_comm == MPI_COMM_NULL)
+        MPIX_Comm_topo_init(comm);
+
+    // With multiple leaders per node, each leader's group acts as a node
+    MPI_Comm local_comm, group_comm;
+    get_aggregation_comms(comm, &local_comm, &group_comm);
+
+    int ppn, num_nodes;
+    MPI_Comm_size(local_comm, &ppn);
+    MPI_Comm_size(group_comm, &num_nodes);
+
+    const char* send_buffer = (const char*)sendbuf;
+    char* recv_buffer = (char*)recvbuf;
+    if (sendbuf == MPI_IN_PLACE)
+    {
+        send_buffer = recv_buffer;
+        sendcounts = recvcounts;
+        sdispls = rdispls;
+        sendtypes = recvtypes;
+    }
+
+    int size;
+    long send_bytes = 0;
+    long recv_bytes = 0;
+    for (int i = 0; i < num_procs; i++)
+    {
+        MPI_Type_size(sendtypes[i], &size);
+        send_bytes += (long)sendcounts[i] * size;
+        MPI_Type_size(recvtypes[i], &size);
+        recv_bytes += (long)recvcounts[i] * size;
+    }
+
+    // Nodes split evenly in SMP order (checked once per comm), and
+    // aggregated node messages are exchanged as MPI_BYTE counts
+    // (only the overflow check depends on this call)
+    int too_big = (long)ppn * send_bytes > INT_MAX || (long)ppn * recv_bytes > INT_MAX;
+    int uniform = MPIX_Comm_uniform(comm) && ppn > 1 && num_nodes > 1;
+    if (uniform)
+        MPI_Allreduce(MPI_IN_PLACE, &too_big, 1, MPI_INT, MPI_MAX, comm->global_comm);
+    if (!uniform || too_big)
+        return alltoallw_pairwise(sendbuf, sendcounts, sdispls, sendtypes,
+                recvbuf, recvcounts, rdispls, recvtypes, comm->global_comm);
+
+    MPI_Aint* send_pos = (MPI_Aint*)malloc(num_procs*sizeof(MPI_Aint));
+    MPI_Aint* recv_pos = (MPI_Aint*)malloc(num_procs*sizeof(MPI_Aint));
+    for (int i = 0; i < num_procs; i++)
+    {
+        send_pos[i] = sdispls[i];
+        recv_pos[i] = rdispls[i];
+    }
+
+    pairwise_loc_helper(send_buffer, sendcounts, send_pos, sendtypes,
+            recv_buffer, recvcounts, recv_pos, recvtypes,
+            local_comm, group_comm);
+
+    free(send_pos);
+    free(recv_pos);
+
+    return MPI_SUCCESS;
+}
@@ -0,0 +1,55 @@
+#ifndef MPI_ADVANCE_ALLTOALLW_H
+#define MPI_ADVANCE_ALLTOALLW_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <mpi.h>
+#include "utils/utils.h"
+#include "locality/topology.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Helper Functions
+// (displacements are in bytes, as in MPI_Alltoallw)
+int alltoallw_pairwise(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        const MPI_Datatype sendtypes[],
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        const MPI_Datatype recvtypes[],
+        MPI_Comm comm);
+int alltoallw_nonblocking(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        const MPI_Datatype sendtypes[],
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        const MPI_Datatype recvtypes[],
+        MPI_Comm comm);
+int alltoallw_pairwise_loc(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        const MPI_Datatype sendtypes[],
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        const MPI_Datatype recvtypes[],
+        MPIX_Comm* comm);
+// MPI_IN_PLACE (sendbuf == MPI_IN_PLACE in any method above)
+int alltoallw_pairwise_inplace(void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        const MPI_Datatype recvtypes[],
+        MPI_Comm comm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -8,6 +8,7 @@
 #include "utils/utils.h"
 #include "alltoall.h"
 #include "alltoallv.h"
+#include "alltoallw.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -41,6 +42,36 @@ int MPIX_Alltoallv(const void* sendbuf,
         MPI_Datatype recvtype,
         MPIX_Comm* comm);
 
+// Displacements in bytes, one datatype per block
+int MPIX_Alltoallw(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        const MPI_Datatype sendtypes[],
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        const MPI_Datatype recvtypes[],
+        MPIX_Comm* comm);
+
+// Big-count variants (MPI_Count counts, MPI_Aint displacements in 
+// elements), for buffers and blocks beyond INT_MAX elements
+int MPIX_Alltoall_c(const void* sendbuf,
+        const MPI_Count sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const MPI_Count recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm);
+int MPIX_Alltoallv_c(const void* sendbuf,
+        const MPI_Count sendcounts[],
+        const MPI_Aint sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const MPI_Count recvcounts[],
+        const MPI_Aint rdispls[],
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,555 @@
+#include "ialltoall.h"
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+
+// State of a nonblocking alltoall(v) schedule
+typedef struct _IalltoallSchedule
+{
+    MPIX_Comm* comm;
+    int tag;
+    const char* sendbuf;
+    char* recvbuf;
+    MPI_Datatype sendtype;
+    MPI_Datatype recvtype;
+    MPI_Aint send_extent;
+    MPI_Aint recv_extent;
+
+    // Pairwise rounds (counts/displs are NULL for alltoall)
+    int sendcount;
+    int recvcount;
+    const int* sendcounts;
+    const int* sdispls;
+    const int* recvcounts;
+    const int* rdispls;
+    const int* send_procs;
+    const int* recv_procs;
+    int rounds_per_step;
+
+    // Hierarchical phases (see alltoall_loc)
+    MPI_Comm local_comm;
+    MPI_Comm group_comm;
+    int ppn;
+    int num_nodes;
+    int rank_node;
+    int local_rank;
+    int n_mine;
+    int bytes;
+    int* n_owned;
+    int* node_pos;
+    int* counts;
+    char* tmpbuf;
+    char* contig_buf;
+
+    // Copy of recvbuf when sendbuf is MPI_IN_PLACE
+    char* inplace_buf;
+} IalltoallSchedule;
+
+static void init_schedule(IalltoallSchedule** sched_ptr, MPIX_Comm* comm,
+        const void* sendbuf, MPI_Datatype sendtype,
+        void* recvbuf, MPI_Datatype recvtype)
+{
+    IalltoallSchedule* sched = (IalltoallSchedule*)calloc(1, sizeof(IalltoallSchedule));
+
+    sched->comm = comm;
+    sched->sendbuf = (const char*)sendbuf;
+    sched->recvbuf = (char*)recvbuf;
+    sched->sendtype = (sendbuf == MPI_IN_PLACE) ? recvtype : sendtype;
+    sched->recvtype = recvtype;
+    sched->send_extent = MPIX_Type_extent(sched->sendtype);
+    sched->recv_extent = MPIX_Type_extent(recvtype);
+
+    // Every process creates its requests in the same order, so
+    // outstanding schedules on comm get distinct (matching) tags
+    MPIX_Comm_tag(comm, &(sched->tag));
+
+    *sched_ptr = sched;
+}
+
+// MPI_IN_PLACE : send from a copy of recvbuf, with the receive
+// counts and displacements (call after counts are set; the type
+// is set by init_schedule)
+static void set_inplace(IalltoallSchedule* sched, int num_procs)
+{
+    if (sched->sendbuf != MPI_IN_PLACE)
+        return;
+
+    MPI_Aint size = (MPI_Aint)num_procs * sched->recvcount;
+    if (sched->recvcounts != NULL)
+    {
+        size = 0;
+        for (int i = 0; i < num_procs; i++)
+            if ((MPI_Aint)sched->rdispls[i] + sched->recvcounts[i] > size)
+                size = (MPI_Aint)sched->rdispls[i] + sched->recvcounts[i];
+    }
+    size *= sched->recv_extent;
+
+    sched->inplace_buf = (char*)malloc(size > 0 ? size : 1);
+    memcpy(sched->inplace_buf, sched->recvbuf, size);
+
+    sched->sendbuf = sched->inplace_buf;
+    sched->sendcount = sched->recvcount;
+    sched->sendcounts = sched->recvcounts;
+    sched->sdispls = sched->rdispls;
+}
+
+static void free_schedule(void* schedule)
+{
+    IalltoallSchedule* sched = (IalltoallSchedule*)schedule;
+
+    free(sched->n_owned);
+    free(sched->node_pos);
+    free(sched->counts);
+    free(sched->tmpbuf);
+    free(sched->contig_buf);
+    free(sched->inplace_buf);
+    free(sched);
+}
+
+// Attach schedule to a new request and post its first step
+static int start_schedule(IalltoallSchedule* sched, int n_steps, int max_msgs,
+        mpix_step_ftn step_function, MPIX_Request** request_ptr)
+{
+    init_request(request_ptr);
+    MPIX_Request* request = *request_ptr;
+
+    request->schedule = sched;
+    request->free_function = (void*) free_schedule;
+    request->step_function = (void*) step_function;
+    request->wait_function = (void*) schedule_wait;
+    request->test_function = (void*) schedule_test;
+
+    request->n_steps = n_steps;
+    request->current_step = 0;
+    request->n_step_msgs = 0;
+    request->phase = MPIX_PHASE_LOCAL_S;
+    if (max_msgs)
+        request->step_requests = (MPI_Request*)malloc(max_msgs*sizeof(MPI_Request));
+
+    return step_function(request);
+}
+
+
+/**************************************************
+ * Nonblocking Alltoall
+ *  - Uses the three-step locality-aware schedule
+ *      (falls back to pairwise rounds if topology
+ *      is not supported)
+ *************************************************/
+int MPIX_Ialltoall(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm,
+        MPIX_Request** request_ptr)
+{
+    return ialltoall_loc(sendbuf,
+            sendcount,
+            sendtype,
+            recvbuf,
+            recvcount,
+            recvtype,
+            comm,
+            request_ptr);
+}
+
+int MPIX_Ialltoallv(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm,
+        MPIX_Request** request_ptr)
+{
+    return ialltoallv_pairwise(sendbuf,
+            sendcounts,
+            sdispls,
+            sendtype,
+            recvbuf,
+            recvcounts,
+            rdispls,
+            recvtype,
+            comm,
+            request_ptr);
+}
+
+
+/**************************************************
+ * Pairwise Rounds
+ *  - Step k posts rounds k*W+1 ... (k+1)*W of the
+ *      comm->peer_schedule order, with
+ *      W = comm->window_size
+ *  - Step 0 also copies the block to self
+ *************************************************/
+static int pairwise_step(MPIX_Request* request)
+{
+    IalltoallSchedule* sched = (IalltoallSchedule*)(request->schedule);
+
+    int rank, num_procs;
+    MPI_Comm_rank(sched->comm->global_comm, &rank);
+    MPI_Comm_size(sched->comm->global_comm, &num_procs);
+
+    int tag = sched->tag;
+    int send_proc, recv_proc;
+    MPI_Aint send_pos, recv_pos;
+    int send_count, recv_count;
+    int ierr = 0;
+
+    if (request->current_step == 0)
+    {
+        if (sched->sendcounts == NULL)
+            MPIX_Type_copy(sched->sendbuf + ((MPI_Aint)rank * sched->sendcount * sched->send_extent),
+                    sched->sendcount, sched->sendtype,
+                    sched->recvbuf + ((MPI_Aint)rank * sched->recvcount * sched->recv_extent),
+                    sched->recvcount, sched->recvtype);
+        else
+            MPIX_Type_copy(sched->sendbuf + ((MPI_Aint)sched->sdispls[rank] * sched->send_extent),
+                    sched->sendcounts[rank], sched->sendtype,
+                    sched->recvbuf + ((MPI_Aint)sched->rdispls[rank] * sched->recv_extent),
+                    sched->recvcounts[rank], sched->recvtype);
+    }
+
+    if (request->current_step == request->n_steps)
+        return MPI_SUCCESS;
+
+    int first = request->current_step * sched->rounds_per_step + 1;
+    int last = first + sched->rounds_per_step;
+    if (last > num_procs)
+        last = num_procs;
+
+    int n_msgs = 0;
+    for (int i = first; i < last; i++)
+    {
+        get_step_peers(rank, num_procs, i, sched->send_procs, sched->recv_procs,
+                &send_proc, &recv_proc);
+
+        if (sched->sendcounts == NULL)
+        {
+            send_pos = (MPI_Aint)send_proc * sched->sendcount * sched->send_extent;
+            recv_pos = (MPI_Aint)recv_proc * sched->recvcount * sched->recv_extent;
+            send_count = sched->sendcount;
+            recv_count = sched->recvcount;
+        }
+        else
+        {
+            send_pos = (MPI_Aint)sched->sdispls[send_proc] * sched->send_extent;
+            recv_pos = (MPI_Aint)sched->rdispls[recv_proc] * sched->recv_extent;
+            send_count = sched->sendcounts[send_proc];
+            recv_count = sched->recvcounts[recv_proc];
+        }
+
+        ierr += MPI_Irecv(sched->recvbuf + recv_pos, recv_count, sched->recvtype,
+                recv_proc, tag, sched->comm->global_comm,
+                &(request->step_requests[n_msgs++]));
+        ierr += MPI_Isend(sched->sendbuf + send_pos, send_count, sched->sendtype,
+                send_proc, tag, sched->comm->global_comm,
+                &(request->step_requests[n_msgs++]));
+    }
+    request->n_step_msgs = n_msgs;
+
+    return ierr;
+}
+
+static int start_pairwise(IalltoallSchedule* sched, MPIX_Request** request_ptr)
+{
+    int num_procs;
+    MPI_Comm_size(sched->comm->global_comm, &num_procs);
+
+    MPIX_Comm_peer_schedule(sched->comm, &(sched->send_procs), &(sched->recv_procs));
+
+    int window = sched->comm->window_size;
+    if (window <= 0 || window > num_procs - 1)
+        window = num_procs - 1;
+    if (window == 0)
+        window = 1;
+    sched->rounds_per_step = window;
+
+    int n_steps = (num_procs - 1 + window - 1) / window;
+
+    return start_schedule(sched, n_steps, 2*window, pairwise_step, request_ptr);
+}
+
+int ialltoall_pairwise(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm,
+        MPIX_Request** request_ptr)
+{
+    IalltoallSchedule* sched;
+    init_schedule(&sched, comm, sendbuf, sendtype, recvbuf, recvtype);
+    sched->sendcount = sendcount;
+    sched->recvcount = recvcount;
+
+    int num_procs;
+    MPI_Comm_size(comm->global_comm, &num_procs);
+    set_inplace(sched, num_procs);
+
+    return start_pairwise(sched, request_ptr);
+}
+
+int ialltoallv_pairwise(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm,
+        MPIX_Request** request_ptr)
+{
+    IalltoallSchedule* sched;
+    init_schedule(&sched, comm, sendbuf, sendtype, recvbuf, recvtype);
+    sched->sendcounts = sendcounts;
+    sched->sdispls = sdispls;
+    sched->recvcounts = recvcounts;
+    sched->rdispls = rdispls;
+
+    int num_procs;
+    MPI_Comm_size(comm->global_comm, &num_procs);
+    set_inplace(sched, num_procs);
+
+    return start_pairwise(sched, request_ptr);
+}
+
+
+/**************************************************
+ * Hierarchical Phases (same data movement as
+ *      alltoall_loc)
+ *  - Step 0 : pack by owning local rank, gather
+ *      on-node (point-to-point over local_comm)
+ *  - Step 1 : one message with each owned node
+ *      (over group_comm)
+ *  - Step 2 : redistribute on-node to local
+ *      destination (point-to-point)
+ *  - Completion : unpack into recvbuf
+ *  - Blocks are packed from sendbuf and unpacked into
+ *      recvbuf by the datatype engine, so only bytes
+ *      are exchanged and processes need not agree on
+ *      type contiguity (no collective at the start)
+ *  - On-node steps use tagged point-to-point rather
+ *      than MPI_Ialltoallv : steps are posted during
+ *      progress, which may order requests differently
+ *      on each process
+ *************************************************/
+// Post on-node exchange of sched->counts (sendcounts, sdispls,
+// recvcounts, rdispls) between sendbuf and recvbuf
+static int local_exchange(MPIX_Request* request, IalltoallSchedule* sched,
+        const char* sendbuf, char* recvbuf)
+{
+    int ppn = sched->ppn;
+    int* sendcounts = sched->counts;
+    int* sdispls = sched->counts + ppn;
+    int* recvcounts = sched->counts + 2*ppn;
+    int* rdispls = sched->counts + 3*ppn;
+    int ierr = 0;
+
+    for (int i = 0; i < ppn; i++)
+    {
+        if (i == sched->local_rank)
+        {
+            memcpy(recvbuf + rdispls[i], sendbuf + sdispls[i], recvcounts[i]);
+            continue;
+        }
+        if (recvcounts[i])
+            ierr += MPI_Irecv(recvbuf + rdispls[i], recvcounts[i], MPI_BYTE,
+                    i, sched->tag, sched->local_comm,
+                    &(request->step_requests[request->n_step_msgs++]));
+        if (sendcounts[i])
+            ierr += MPI_Isend(sendbuf + sdispls[i], sendcounts[i], MPI_BYTE,
+                    i, sched->tag, sched->local_comm,
+                    &(request->step_requests[request->n_step_msgs++]));
+    }
+
+    return ierr;
+}
+
+static int loc_step(MPIX_Request* request)
+{
+    IalltoallSchedule* sched = (IalltoallSchedule*)(request->schedule);
+
+    int tag = sched->tag;
+    int ppn = sched->ppn;
+    int num_nodes = sched->num_nodes;
+    int rank_node = sched->rank_node;
+    int n_mine = sched->n_mine;
+    int bytes = sched->bytes;
+    int node_bytes = ppn * bytes;
+    int* sendcounts = sched->counts;
+    int* sdispls = sched->counts + ppn;
+    int* recvcounts = sched->counts + 2*ppn;
+    int* rdispls = sched->counts + 3*ppn;
+    char* tmpbuf = sched->tmpbuf;
+    char* contig_buf = sched->contig_buf;
+    int ctr, pos;
+    int ierr = 0;
+
+    switch (request->current_step)
+    {
+        case 0:
+            // Send data for every node to the local rank assigned to that node
+            ctr = 0;
+            for (int i = 0; i < ppn; i++)
+            {
+                sendcounts[i] = sched->n_owned[i] * node_bytes;
+                sdispls[i] = ctr;
+                recvcounts[i] = n_mine * node_bytes;
+                rdispls[i] = i * recvcounts[i];
+                for (int node = (i - rank_node % ppn + ppn) % ppn; node < num_nodes; node += ppn)
+                {
+                    MPIX_Type_pack(sched->sendbuf
+                                + (MPI_Aint)node * ppn * sched->sendcount * sched->send_extent,
+                            ppn * sched->sendcount, sched->sendtype, tmpbuf + ctr);
+                    ctr += node_bytes;
+                }
+            }
+            ierr += local_exchange(request, sched, tmpbuf, contig_buf);
+            break;
+
+        case 1:
+            // contig_buf : [local_src][node][local_dest]
+            // tmpbuf : [node][local_src][local_dest]
+            repack(ppn, n_mine, node_bytes, contig_buf, tmpbuf);
+            for (int i = 0; i < num_nodes; i++)
+            {
+                pos = sched->node_pos[i];
+                if (pos < 0) continue;
+
+                if (i == rank_node)
+                {
+                    memcpy(contig_buf + (pos * ppn * node_bytes),
+                            tmpbuf + (pos * ppn * node_bytes),
+                            ppn * node_bytes);
+                    continue;
+                }
+
+                ierr += MPI_Irecv(contig_buf + (pos * ppn * node_bytes), ppn * node_bytes,
+                        MPI_BYTE, i, tag, sched->group_comm,
+                        &(request->step_requests[request->n_step_msgs++]));
+                ierr += MPI_Isend(tmpbuf + (pos * ppn * node_bytes), ppn * node_bytes,
+                        MPI_BYTE, i, tag, sched->group_comm,
+                        &(request->step_requests[request->n_step_msgs++]));
+            }
+            break;
+
+        case 2:
+            // contig_buf : [node][src][local_dest]
+            // tmpbuf : [local_dest][node][src]
+            repack(n_mine * ppn, ppn, bytes, contig_buf, tmpbuf);
+            ctr = 0;
+            for (int i = 0; i < ppn; i++)
+            {
+                sendcounts[i] = n_mine * node_bytes;
+                sdispls[i] = i * sendcounts[i];
+                recvcounts[i] = sched->n_owned[i] * node_bytes;
+                rdispls[i] = ctr;
+                ctr += recvcounts[i];
+            }
+            ierr += local_exchange(request, sched, tmpbuf, contig_buf);
+            break;
+
+        default:
+            // Unpack from [local_src][node][src] to recvbuf
+            ctr = 0;
+            for (int i = 0; i < ppn; i++)
+            {
+                for (int node = (i - rank_node % ppn + ppn) % ppn; node < num_nodes; node += ppn)
+                {
+                    MPIX_Type_unpack(contig_buf + ctr,
+                            sched->recvbuf
+                                + (MPI_Aint)node * ppn * sched->recvcount * sched->recv_extent,
+                            ppn * sched->recvcount, sched->recvtype);
+                    ctr += node_bytes;
+                }
+            }
+            break;
+    }
+
+    return ierr;
+}
+
+int ialltoall_loc(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm,
+        MPIX_Request** request_ptr)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(comm->global_comm, &rank);
+    MPI_Comm_size(comm->global_comm, &num_procs);
+
+    if (comm->local_comm == MPI_COMM_NULL)
+        MPIX_Comm_topo_init(comm);
+
+    IalltoallSchedule* sched;
+    init_schedule(&sched, comm, sendbuf, sendtype, recvbuf, recvtype);
+    sched->sendcount = sendcount;
+    sched->recvcount = recvcount;
+    set_inplace(sched, num_procs);
+
+    // With multiple leaders per node, each leader's group acts as a node
+    get_aggregation_comms(comm, &(sched->local_comm), &(sched->group_comm));
+
+    int local_rank, ppn, num_nodes;
+    MPI_Comm_rank(sched->local_comm, &local_rank);
+    MPI_Comm_size(sched->local_comm, &ppn);
+    MPI_Comm_size(sched->group_comm, &num_nodes);
+
+    // Nodes split evenly in SMP order (checked once per comm), and
+    // aggregated node blocks are exchanged as MPI_BYTE counts (block
+    // bytes are equal on every process, so no reduction is needed)
+    int send_size;
+    MPI_Type_size(sched->sendtype, &send_size);
+    if (!MPIX_Comm_uniform(comm) || ppn == 1 || num_nodes == 1
+            || (long)num_procs * sched->sendcount * send_size > INT_MAX)
+        return start_pairwise(sched, request_ptr);
+
+    int rank_node;
+    MPI_Comm_rank(sched->group_comm, &rank_node);
+
+    sched->ppn = ppn;
+    sched->num_nodes = num_nodes;
+    sched->rank_node = rank_node;
+    sched->local_rank = local_rank;
+    sched->bytes = sched->sendcount * send_size;
+    int node_bytes = ppn * sched->bytes;
+
+    // Number of nodes assigned to each local rank
+    sched->n_owned = (int*)malloc(ppn*sizeof(int));
+    sched->node_pos = (int*)malloc(num_nodes*sizeof(int));
+    for (int i = 0; i < ppn; i++)
+        sched->n_owned[i] = 0;
+    for (int i = 0; i < num_nodes; i++)
+    {
+        int owner = (rank_node + i) % ppn;
+        sched->node_pos[i] = -1;
+        if (owner == local_rank)
+            sched->node_pos[i] = sched->n_owned[owner];
+        sched->n_owned[owner]++;
+    }
+    sched->n_mine = sched->n_owned[local_rank];
+
+    int buf_size = num_procs * sched->bytes;
+    if (sched->n_mine * ppn * node_bytes > buf_size)
+        buf_size = sched->n_mine * ppn * node_bytes;
+    sched->tmpbuf = (char*)malloc(buf_size*sizeof(char));
+    sched->contig_buf = (char*)malloc(buf_size*sizeof(char));
+    sched->counts = (int*)malloc(4*ppn*sizeof(int));
+
+    int max_msgs = 2*sched->n_mine;
+    if (max_msgs < 2*ppn)
+        max_msgs = 2*ppn;
+
+    return start_schedule(sched, 3, max_msgs, loc_step, request_ptr);
+}
@@ -0,0 +1,83 @@
+#ifndef MPI_ADVANCE_IALLTOALL_H
+#define MPI_ADVANCE_IALLTOALL_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <mpi.h>
+#include "utils/utils.h"
+#include "locality/topology.h"
+#include "persistent/persistent.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**************************************************
+ * Nonblocking Alltoall(v)
+ *  - Returns an MPIX_Request holding a schedule of
+ *      steps (see schedule_progress in persistent.h)
+ *  - Schedule advances in MPIX_Test (without blocking)
+ *      and MPIX_Wait, and must complete before
+ *      MPIX_Request_free
+ *  - Send and receive buffers (and counts/displs
+ *      for alltoallv) must not be modified until
+ *      complete
+ *  - sendbuf may be MPI_IN_PLACE (recvbuf is copied
+ *      when the request is created)
+ *  - Several requests may be outstanding on a
+ *      communicator, if every process creates them
+ *      in the same order (each gets its own tag)
+ *************************************************/
+int MPIX_Ialltoall(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm,
+        MPIX_Request** request_ptr);
+int MPIX_Ialltoallv(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm,
+        MPIX_Request** request_ptr);
+
+// Helper Functions
+int ialltoall_pairwise(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm,
+        MPIX_Request** request_ptr);
+int ialltoall_loc(const void* sendbuf,
+        const int sendcount,
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcount,
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm,
+        MPIX_Request** request_ptr);
+int ialltoallv_pairwise(const void* sendbuf,
+        const int sendcounts[],
+        const int sdispls[],
+        MPI_Datatype sendtype,
+        void* recvbuf,
+        const int recvcounts[],
+        const int rdispls[],
+        MPI_Datatype recvtype,
+        MPIX_Comm* comm,
+        MPIX_Request** request_ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
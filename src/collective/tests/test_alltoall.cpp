@@ -41,11 +41,27 @@ TEST(RandomCommTest, TestsInTests)
     std::vector<int> std_alltoall(max_s*num_procs);
     std::vector<int> pairwise_alltoall(max_s*num_procs);
     std::vector<int> loc_pairwise_alltoall(max_s*num_procs);
+    std::vector<int> bruck_alltoall(max_s*num_procs);
 
     MPIX_Comm* locality_comm;
     MPIX_Comm_init(&locality_comm, MPI_COMM_WORLD);
     update_locality(locality_comm, 4);
 
+    // Two leaders per (4-process) node
+    MPIX_Info* xinfo;
+    MPIX_Info_init(&xinfo);
+    xinfo->leaders_per_node = 2;
+    MPIX_Comm* leader_comm;
+    MPIX_Comm_init(&leader_comm, MPI_COMM_WORLD);
+    update_locality(leader_comm, 4);
+    MPIX_Comm_leader_init(leader_comm, xinfo);
+
+    // Small (uneven) chunks for pipelined alltoall,
+    // and small window for windowed nonblocking alltoall
+    xinfo->pipeline_bytes = 24;
+    xinfo->window_size = 3;
+    MPIX_Comm_info_init(locality_comm, xinfo);
+
     for (int i = 0; i < max_i; i++)
     {
         int s = pow(2, i);
@@ -87,19 +103,665 @@ TEST(RandomCommTest, TestsInTests)
         for (int j = 0; j < s*num_procs; j++)
             ASSERT_EQ(std_alltoall[j], loc_pairwise_alltoall[j]);
 
-        /*
+        // Locality-Aware Nonblocking Alltoall
+        std::fill(loc_pairwise_alltoall.begin(), loc_pairwise_alltoall.end(), 0);
+        alltoall_nonblocking_loc(local_data.data(), 
+                s, 
+                MPI_INT,
+                loc_pairwise_alltoall.data(), 
+                s, 
+                MPI_INT,
+                locality_comm);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoall[j], loc_pairwise_alltoall[j]);
+
+        // Bruck Alltoall
         alltoall_bruck(local_data.data(), 
                 s, 
                 MPI_INT,
                 bruck_alltoall.data(), 
                 s, 
                 MPI_INT,
-                MPI_COMM_WORLD);
+                locality_comm);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoall[j], bruck_alltoall[j]);
+
+        // Locality-Aware Bruck Alltoall
+        std::fill(bruck_alltoall.begin(), bruck_alltoall.end(), 0);
+        alltoall_bruck_loc(local_data.data(), 
+                s, 
+                MPI_INT,
+                bruck_alltoall.data(), 
+                s, 
+                MPI_INT,
+                locality_comm);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoall[j], bruck_alltoall[j]);
+
+        // Pipelined Locality-Aware Alltoall
+        std::fill(loc_pairwise_alltoall.begin(), loc_pairwise_alltoall.end(), 0);
+        alltoall_pipelined_loc(local_data.data(), 
+                s, 
+                MPI_INT,
+                loc_pairwise_alltoall.data(), 
+                s, 
+                MPI_INT,
+                locality_comm);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoall[j], loc_pairwise_alltoall[j]);
+
+        // Bounded-Window Nonblocking Alltoall
+        std::fill(pairwise_alltoall.begin(), pairwise_alltoall.end(), 0);
+        alltoall_nonblocking_window(local_data.data(), 
+                s, 
+                MPI_INT,
+                pairwise_alltoall.data(), 
+                s, 
+                MPI_INT,
+                locality_comm);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoall[j], pairwise_alltoall[j]);
+
+        // Persistent Locality-Aware Alltoall (started twice)
+        MPIX_Request* xreq;
+        MPIX_Alltoall_init(local_data.data(), 
+                s, 
+                MPI_INT,
+                loc_pairwise_alltoall.data(), 
+                s, 
+                MPI_INT,
+                locality_comm,
+                MPI_INFO_NULL,
+                &xreq);
+        for (int iter = 0; iter < 2; iter++)
+        {
+            std::fill(loc_pairwise_alltoall.begin(), loc_pairwise_alltoall.end(), 0);
+            MPIX_Start(xreq);
+            MPIX_Wait(xreq, MPI_STATUS_IGNORE);
+            for (int j = 0; j < s*num_procs; j++)
+                ASSERT_EQ(std_alltoall[j], loc_pairwise_alltoall[j]);
+        }
+        MPIX_Request_free(&xreq);
+
+        // Nonblocking Locality-Aware Alltoall (polled)
+        std::fill(loc_pairwise_alltoall.begin(), loc_pairwise_alltoall.end(), 0);
+        MPIX_Ialltoall(local_data.data(), 
+                s, 
+                MPI_INT,
+                loc_pairwise_alltoall.data(), 
+                s, 
+                MPI_INT,
+                locality_comm,
+                &xreq);
+        int flag = 0;
+        while (!flag)
+            MPIX_Test(xreq, &flag, MPI_STATUS_IGNORE);
+        MPIX_Request_free(&xreq);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoall[j], loc_pairwise_alltoall[j]);
+
+        // Nonblocking Pairwise Alltoall (window of 3 rounds)
+        std::fill(pairwise_alltoall.begin(), pairwise_alltoall.end(), 0);
+        ialltoall_pairwise(local_data.data(), 
+                s, 
+                MPI_INT,
+                pairwise_alltoall.data(), 
+                s, 
+                MPI_INT,
+                locality_comm,
+                &xreq);
+        MPIX_Wait(xreq, MPI_STATUS_IGNORE);
+        MPIX_Request_free(&xreq);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoall[j], pairwise_alltoall[j]);
+
+        // Multi-Leader Nonblocking Alltoall
+        std::fill(loc_pairwise_alltoall.begin(), loc_pairwise_alltoall.end(), 0);
+        MPIX_Ialltoall(local_data.data(), 
+                s, 
+                MPI_INT,
+                loc_pairwise_alltoall.data(), 
+                s, 
+                MPI_INT,
+                leader_comm,
+                &xreq);
+        MPIX_Wait(xreq, MPI_STATUS_IGNORE);
+        MPIX_Request_free(&xreq);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoall[j], loc_pairwise_alltoall[j]);
+
+        // Multi-Leader Pairwise Alltoall
+        std::fill(loc_pairwise_alltoall.begin(), loc_pairwise_alltoall.end(), 0);
+        alltoall_pairwise_loc(local_data.data(), 
+                s, 
+                MPI_INT,
+                loc_pairwise_alltoall.data(), 
+                s, 
+                MPI_INT,
+                leader_comm);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoall[j], loc_pairwise_alltoall[j]);
+
+        // Multi-Leader Bruck Alltoall
+        std::fill(bruck_alltoall.begin(), bruck_alltoall.end(), 0);
+        alltoall_bruck_loc(local_data.data(), 
+                s, 
+                MPI_INT,
+                bruck_alltoall.data(), 
+                s, 
+                MPI_INT,
+                leader_comm);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoall[j], bruck_alltoall[j]);
+
+        // Big-Count Alltoall
+        std::fill(loc_pairwise_alltoall.begin(), loc_pairwise_alltoall.end(), 0);
+        MPIX_Alltoall_c(local_data.data(), 
+                (MPI_Count)s, 
+                MPI_INT,
+                loc_pairwise_alltoall.data(), 
+                (MPI_Count)s, 
+                MPI_INT,
+                locality_comm);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoall[j], loc_pairwise_alltoall[j]);
+
+        // In-Place Alltoall (pairwise swap)
+        std::copy(local_data.begin(), local_data.begin() + s*num_procs, 
+                pairwise_alltoall.begin());
+        alltoall_pairwise(MPI_IN_PLACE, 
+                0, 
+                MPI_DATATYPE_NULL,
+                pairwise_alltoall.data(), 
+                s, 
+                MPI_INT,
+                locality_comm);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoall[j], pairwise_alltoall[j]);
+
+        // In-Place Locality-Aware Alltoall
+        std::copy(local_data.begin(), local_data.begin() + s*num_procs, 
+                loc_pairwise_alltoall.begin());
+        MPIX_Alltoall(MPI_IN_PLACE, 
+                0, 
+                MPI_DATATYPE_NULL,
+                loc_pairwise_alltoall.data(), 
+                s, 
+                MPI_INT,
+                leader_comm);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoall[j], loc_pairwise_alltoall[j]);
+
+        // In-Place Pipelined Alltoall
+        std::copy(local_data.begin(), local_data.begin() + s*num_procs, 
+                loc_pairwise_alltoall.begin());
+        alltoall_pipelined_loc(MPI_IN_PLACE, 
+                0, 
+                MPI_DATATYPE_NULL,
+                loc_pairwise_alltoall.data(), 
+                s, 
+                MPI_INT,
+                locality_comm);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoall[j], loc_pairwise_alltoall[j]);
+
+        // In-Place Multi-Leader Bruck Alltoall
+        std::copy(local_data.begin(), local_data.begin() + s*num_procs, 
+                bruck_alltoall.begin());
+        alltoall_bruck_loc(MPI_IN_PLACE, 
+                0, 
+                MPI_DATATYPE_NULL,
+                bruck_alltoall.data(), 
+                s, 
+                MPI_INT,
+                leader_comm);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoall[j], bruck_alltoall[j]);
+    }
+
+    MPIX_Info_free(&xinfo);
+    MPIX_Comm_free(&leader_comm);
+    MPIX_Comm_free(&locality_comm);
+}
+
+
+
+TEST(DatatypeTest, TestsInTests)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+
+    int max_i = 6;
+    int max_s = pow(2, max_i);
+
+    MPIX_Comm* locality_comm;
+    MPIX_Comm_init(&locality_comm, MPI_COMM_WORLD);
+    update_locality(locality_comm, 4);
+
+    // Every other int (extent of two ints), and pairs of ints 
+    // with a hole before them (lower bound -1 int)
+    MPI_Datatype strided_type, pair_type, vector_type;
+    MPI_Type_create_resized(MPI_INT, 0, 2*sizeof(int), &strided_type);
+    MPI_Type_commit(&strided_type);
+    MPI_Type_vector(2, 1, 2, MPI_INT, &vector_type);
+    MPI_Type_create_resized(vector_type, -(MPI_Aint)sizeof(int), 4*sizeof(int), &pair_type);
+    MPI_Type_commit(&pair_type);
+    MPI_Type_free(&vector_type);
+
+    alltoall_ftn alltoall_methods[ALLTOALL_NUM_METHODS] = {
+        alltoall_pairwise,
+        alltoall_nonblocking,
+        alltoall_bruck,
+        alltoall_pairwise_loc,
+        alltoall_nonblocking_loc,
+        alltoall_bruck_loc,
+        alltoall_pipelined_loc,
+        alltoall_nonblocking_window,
+        alltoall_threaded
+    };
+
+    std::vector<int> local_data(2*max_s*num_procs);
+    std::vector<int> std_alltoall(2*max_s*num_procs);
+    std::vector<int> new_alltoall(2*max_s*num_procs);
+    for (int i = 0; i < max_i; i++)
+    {
+        int s = pow(2, i);
+        for (int j = 0; j < 2*s*num_procs; j++)
+            local_data[j] = rank*10000 + j;
+
+        // Expected values are computed directly (PMPI_Alltoall is not
+        // reliable for differing send and recv type maps)
+
+        // Strided send, contiguous receive
+        std::fill(std_alltoall.begin(), std_alltoall.end(), -1);
+        for (int j = 0; j < num_procs; j++)
+            for (int k = 0; k < s; k++)
+                std_alltoall[j*s + k] = j*10000 + 2*(rank*s + k);
+        for (int m = 0; m < ALLTOALL_NUM_METHODS; m++)
+        {
+            std::fill(new_alltoall.begin(), new_alltoall.end(), -1);
+            alltoall_methods[m](local_data.data(), s, strided_type,
+                    new_alltoall.data(), s, MPI_INT, locality_comm);
+            for (int j = 0; j < 2*s*num_procs; j++)
+                ASSERT_EQ(std_alltoall[j], new_alltoall[j]);
+        }
+
+        // Contiguous send, strided receive (holes untouched)
+        std::fill(std_alltoall.begin(), std_alltoall.end(), -1);
+        for (int j = 0; j < num_procs; j++)
+            for (int k = 0; k < s; k++)
+                std_alltoall[2*(j*s + k)] = j*10000 + rank*s + k;
+        for (int m = 0; m < ALLTOALL_NUM_METHODS; m++)
+        {
+            std::fill(new_alltoall.begin(), new_alltoall.end(), -1);
+            alltoall_methods[m](local_data.data(), s, MPI_INT,
+                    new_alltoall.data(), s, strided_type, locality_comm);
+            for (int j = 0; j < 2*s*num_procs; j++)
+                ASSERT_EQ(std_alltoall[j], new_alltoall[j]);
+        }
+
+        // Pairs with a negative lower bound, in place
+        int n = s / 2;
+        if (n == 0) continue;
+        std::copy(local_data.begin(), local_data.end(), std_alltoall.begin());
+        for (int j = 0; j < num_procs; j++)
+            for (int k = 0; k < n; k++)
+            {
+                std_alltoall[1 + 4*(j*n + k)] = j*10000 + 1 + 4*(rank*n + k);
+                std_alltoall[3 + 4*(j*n + k)] = j*10000 + 3 + 4*(rank*n + k);
+            }
+        std::copy(local_data.begin(), local_data.end(), new_alltoall.begin());
+        MPIX_Alltoall(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+                new_alltoall.data() + 1, n, pair_type, locality_comm);
+        for (int j = 0; j < 2*s*num_procs; j++)
+            ASSERT_EQ(std_alltoall[j], new_alltoall[j]);
+
+        // Nonblocking (locality-aware, packs strided blocks itself) and
+        // persistent (locality-aware falls back to pairwise)
+        std::fill(std_alltoall.begin(), std_alltoall.end(), -1);
+        for (int j = 0; j < num_procs; j++)
+            for (int k = 0; k < s; k++)
+                std_alltoall[j*s + k] = j*10000 + 2*(rank*s + k);
+
+        MPIX_Request* xreq;
+        std::fill(new_alltoall.begin(), new_alltoall.end(), -1);
+        ialltoall_loc(local_data.data(), s, strided_type,
+                new_alltoall.data(), s, MPI_INT, locality_comm, &xreq);
+        MPIX_Wait(xreq, MPI_STATUS_IGNORE);
+        MPIX_Request_free(&xreq);
+        for (int j = 0; j < 2*s*num_procs; j++)
+            ASSERT_EQ(std_alltoall[j], new_alltoall[j]);
+
+        std::vector<int> strided_alltoall(2*s*num_procs, -1);
+        for (int j = 0; j < num_procs; j++)
+            for (int k = 0; k < s; k++)
+                strided_alltoall[2*(j*s + k)] = j*10000 + rank*s + k;
+        std::fill(new_alltoall.begin(), new_alltoall.end(), -1);
+        ialltoall_loc(local_data.data(), s, MPI_INT,
+                new_alltoall.data(), s, strided_type, locality_comm, &xreq);
+        MPIX_Wait(xreq, MPI_STATUS_IGNORE);
+        MPIX_Request_free(&xreq);
+        for (int j = 0; j < 2*s*num_procs; j++)
+            ASSERT_EQ(strided_alltoall[j], new_alltoall[j]);
+
+        std::fill(new_alltoall.begin(), new_alltoall.end(), -1);
+        alltoall_init_loc(local_data.data(), s, strided_type,
+                new_alltoall.data(), s, MPI_INT, locality_comm,
+                MPI_INFO_NULL, &xreq);
+        MPIX_Start(xreq);
+        MPIX_Wait(xreq, MPI_STATUS_IGNORE);
+        MPIX_Request_free(&xreq);
+        for (int j = 0; j < 2*s*num_procs; j++)
+            ASSERT_EQ(std_alltoall[j], new_alltoall[j]);
+    }
+
+    MPI_Type_free(&strided_type);
+    MPI_Type_free(&pair_type);
+    MPIX_Comm_free(&locality_comm);
+}
+
+TEST(TuningTableTest, TestsInTests)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+
+    const char* filename = "test_alltoall_tuning.txt";
+    if (rank == 0)
+    {
+        FILE* f = fopen(filename, "w");
+        fprintf(f, "# collective ppn num_nodes max_bytes algorithm\n");
+        fprintf(f, "alltoall 4 4 64 bruck_loc\n");
+        fprintf(f, "alltoall 4 4 1024 nonblocking_loc\n");
+        fprintf(f, "alltoall 4 4 8192 pairwise\n");
+        fprintf(f, "alltoall 32 64 1048576 bruck\n");
+        fprintf(f, "alltoallv 4 4 4096 waitany\n");
+        fclose(f);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    MPIX_Info* xinfo;
+    MPIX_Info_init(&xinfo);
+    xinfo->tuning_file = filename;
+
+    MPIX_Comm* locality_comm;
+    MPIX_Comm_init(&locality_comm, MPI_COMM_WORLD);
+    update_locality(locality_comm, 4);
+    MPIX_Comm_tuning_init(locality_comm, xinfo);
+
+    ASSERT_EQ(select_alltoall_method(locality_comm, 8), ALLTOALL_BRUCK_LOC);
+    ASSERT_EQ(select_alltoall_method(locality_comm, 512), ALLTOALL_NONBLOCKING_LOC);
+    ASSERT_EQ(select_alltoall_method(locality_comm, 8192), ALLTOALL_PAIRWISE);
+    ASSERT_EQ(select_alltoall_method(locality_comm, 1<<20), ALLTOALL_PAIRWISE);
+    ASSERT_EQ(select_alltoallv_method(locality_comm, 8), ALLTOALLV_WAITANY);
+
+    int max_i = 10;
+    int max_s = pow(2, max_i);
+    std::vector<int> local_data(max_s*num_procs);
+    std::vector<int> std_alltoall(max_s*num_procs);
+    std::vector<int> tuned_alltoall(max_s*num_procs);
+    for (int i = 0; i < max_i; i++)
+    {
+        int s = pow(2, i);
+        for (int j = 0; j < num_procs; j++)
+            for (int k = 0; k < s; k++)
+                local_data[j*s + k] = rank*10000 + j*100 + k;
+
+        PMPI_Alltoall(local_data.data(), s, MPI_INT, 
+                std_alltoall.data(), s, MPI_INT, MPI_COMM_WORLD);
+
+        std::fill(tuned_alltoall.begin(), tuned_alltoall.end(), 0);
+        MPIX_Alltoall(local_data.data(), s, MPI_INT, 
+                tuned_alltoall.data(), s, MPI_INT, locality_comm);
         for (int j = 0; j < s*num_procs; j++)
-            ASSERT_EQ(std_alltoall[j], bruck_alltoall[j]);*/
+            ASSERT_EQ(std_alltoall[j], tuned_alltoall[j]);
     }
 
+    MPIX_Info_free(&xinfo);
     MPIX_Comm_free(&locality_comm);
+
+    if (rank == 0)
+        remove(filename);
 }
 
+TEST(PeerScheduleTest, TestsInTests)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+
+    int max_i = 8;
+    int max_s = pow(2, max_i);
+    std::vector<int> local_data(max_s*num_procs);
+    std::vector<int> std_alltoall(max_s*num_procs);
+    std::vector<int> sched_alltoall(max_s*num_procs);
+    std::vector<int> sizes(num_procs);
+    std::vector<int> displs(num_procs);
+
+    MPIX_Info* xinfo;
+    MPIX_Info_init(&xinfo);
+    xinfo->window_size = 3;
+
+    for (int schedule = 0; schedule < PEER_SCHEDULE_NUM; schedule++)
+    {
+        MPIX_Comm* locality_comm;
+        MPIX_Comm_init(&locality_comm, MPI_COMM_WORLD);
+        update_locality(locality_comm, 4);
+        xinfo->peer_schedule = schedule;
+        MPIX_Comm_info_init(locality_comm, xinfo);
 
+        // Each step must be a permutation, visiting every process once
+        const int* send_procs;
+        const int* recv_procs;
+        MPIX_Comm_peer_schedule(locality_comm, &send_procs, &recv_procs);
+        ASSERT_EQ(send_procs[0], rank);
+        ASSERT_EQ(recv_procs[0], rank);
+        std::vector<int> step_recv(num_procs);
+        std::set<int> send_set, recv_set;
+        for (int i = 0; i < num_procs; i++)
+        {
+            MPI_Allgather(&(send_procs[i]), 1, MPI_INT, step_recv.data(), 1, MPI_INT, 
+                    MPI_COMM_WORLD);
+            for (int j = 0; j < num_procs; j++)
+            {
+                if (step_recv[j] == rank)
+                {
+                    ASSERT_EQ(recv_procs[i], j);
+                }
+            }
+            send_set.insert(send_procs[i]);
+            recv_set.insert(recv_procs[i]);
+        }
+        ASSERT_EQ(send_set.size(), num_procs);
+        ASSERT_EQ(recv_set.size(), num_procs);
+
+        for (int i = 0; i < max_i; i++)
+        {
+            int s = pow(2, i);
+            for (int j = 0; j < num_procs; j++)
+            {
+                for (int k = 0; k < s; k++)
+                    local_data[j*s + k] = rank*10000 + j*100 + k;
+                sizes[j] = s;
+                displs[j] = j*s;
+            }
+
+            PMPI_Alltoall(local_data.data(), s, MPI_INT, 
+                    std_alltoall.data(), s, MPI_INT, MPI_COMM_WORLD);
+
+            std::fill(sched_alltoall.begin(), sched_alltoall.end(), 0);
+            alltoall_pairwise(local_data.data(), s, MPI_INT, 
+                    sched_alltoall.data(), s, MPI_INT, locality_comm);
+            for (int j = 0; j < s*num_procs; j++)
+                ASSERT_EQ(std_alltoall[j], sched_alltoall[j]);
+
+            std::fill(sched_alltoall.begin(), sched_alltoall.end(), 0);
+            alltoall_nonblocking(local_data.data(), s, MPI_INT, 
+                    sched_alltoall.data(), s, MPI_INT, locality_comm);
+            for (int j = 0; j < s*num_procs; j++)
+                ASSERT_EQ(std_alltoall[j], sched_alltoall[j]);
+
+            std::fill(sched_alltoall.begin(), sched_alltoall.end(), 0);
+            alltoall_nonblocking_window(local_data.data(), s, MPI_INT, 
+                    sched_alltoall.data(), s, MPI_INT, locality_comm);
+            for (int j = 0; j < s*num_procs; j++)
+                ASSERT_EQ(std_alltoall[j], sched_alltoall[j]);
+
+            std::fill(sched_alltoall.begin(), sched_alltoall.end(), 0);
+            MPIX_Alltoallv(local_data.data(), sizes.data(), displs.data(), MPI_INT,
+                    sched_alltoall.data(), sizes.data(), displs.data(), MPI_INT,
+                    locality_comm);
+            for (int j = 0; j < s*num_procs; j++)
+                ASSERT_EQ(std_alltoall[j], sched_alltoall[j]);
+
+            std::fill(sched_alltoall.begin(), sched_alltoall.end(), 0);
+            alltoallv_waitany_sched(local_data.data(), sizes.data(), displs.data(), MPI_INT,
+                    sched_alltoall.data(), sizes.data(), displs.data(), MPI_INT,
+                    send_procs, recv_procs, MPI_COMM_WORLD);
+            for (int j = 0; j < s*num_procs; j++)
+                ASSERT_EQ(std_alltoall[j], sched_alltoall[j]);
+
+            MPIX_Request* xreq;
+            std::fill(sched_alltoall.begin(), sched_alltoall.end(), 0);
+            alltoall_init_schedule(local_data.data(), s, MPI_INT, 
+                    sched_alltoall.data(), s, MPI_INT, locality_comm,
+                    MPI_INFO_NULL, &xreq);
+            MPIX_Start(xreq);
+            MPIX_Wait(xreq, MPI_STATUS_IGNORE);
+            MPIX_Request_free(&xreq);
+            for (int j = 0; j < s*num_procs; j++)
+                ASSERT_EQ(std_alltoall[j], sched_alltoall[j]);
+        }
+
+        MPIX_Comm_free(&locality_comm);
+    }
+
+    MPIX_Info_free(&xinfo);
+}
+
+TEST(SingleNodeInitTest, TestsInTests)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+
+    int max_i = 12;
+    int max_s = pow(2, max_i);
+    std::vector<int> local_data(max_s*num_procs);
+    std::vector<int> std_alltoall(max_s*num_procs);
+    std::vector<int> persistent_alltoall(max_s*num_procs);
+
+    // All processes on one node : persistent alltoall falls back to
+    // the pairwise schedule (messages beyond the eager limit)
+    MPIX_Comm* single_comm;
+    MPIX_Comm_init(&single_comm, MPI_COMM_WORLD);
+    update_locality(single_comm, num_procs);
+
+    for (int i = 0; i < max_i; i += 4)
+    {
+        int s = pow(2, i);
+        for (int j = 0; j < num_procs; j++)
+            for (int k = 0; k < s; k++)
+                local_data[j*s + k] = rank*10000 + j*100 + k;
+
+        PMPI_Alltoall(local_data.data(), s, MPI_INT,
+                std_alltoall.data(), s, MPI_INT, MPI_COMM_WORLD);
+
+        MPIX_Request* xreq;
+        MPIX_Alltoall_init(local_data.data(), 
+                s, 
+                MPI_INT,
+                persistent_alltoall.data(), 
+                s, 
+                MPI_INT,
+                single_comm,
+                MPI_INFO_NULL,
+                &xreq);
+        for (int iter = 0; iter < 2; iter++)
+        {
+            std::fill(persistent_alltoall.begin(), persistent_alltoall.end(), 0);
+            MPIX_Start(xreq);
+            MPIX_Wait(xreq, MPI_STATUS_IGNORE);
+            for (int j = 0; j < s*num_procs; j++)
+                ASSERT_EQ(std_alltoall[j], persistent_alltoall[j]);
+        }
+        MPIX_Request_free(&xreq);
+    }
+
+    MPIX_Comm_free(&single_comm);
+}
+
+TEST(OutstandingIalltoallTest, TestsInTests)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+
+    int max_i = 10;
+    int max_s = pow(2, max_i);
+    std::vector<int> local_data(max_s*num_procs);
+    std::vector<int> std_alltoall(max_s*num_procs);
+    std::vector<int> loc_alltoall(max_s*num_procs);
+    std::vector<int> inplace_alltoall(max_s*num_procs);
+
+    MPIX_Comm* locality_comm;
+    MPIX_Comm_init(&locality_comm, MPI_COMM_WORLD);
+    update_locality(locality_comm, 4);
+
+    for (int i = 0; i < max_i; i += 3)
+    {
+        int s = pow(2, i);
+        for (int j = 0; j < num_procs; j++)
+            for (int k = 0; k < s; k++)
+                local_data[j*s + k] = rank*10000 + j*100 + k;
+
+        PMPI_Alltoall(local_data.data(), s, MPI_INT,
+                std_alltoall.data(), s, MPI_INT, MPI_COMM_WORLD);
+
+        // Two outstanding requests (the second in place), polled in
+        // opposite orders on even and odd ranks
+        for (int pairwise = 0; pairwise < 2; pairwise++)
+        {
+            std::fill(loc_alltoall.begin(), loc_alltoall.end(), 0);
+            std::copy(local_data.begin(), local_data.end(), inplace_alltoall.begin());
+
+            MPIX_Request* xreqs[2];
+            if (pairwise)
+            {
+                ialltoall_pairwise(local_data.data(), s, MPI_INT,
+                        loc_alltoall.data(), s, MPI_INT, locality_comm, &xreqs[0]);
+                ialltoall_pairwise(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+                        inplace_alltoall.data(), s, MPI_INT, locality_comm, &xreqs[1]);
+            }
+            else
+            {
+                MPIX_Ialltoall(local_data.data(), s, MPI_INT,
+                        loc_alltoall.data(), s, MPI_INT, locality_comm, &xreqs[0]);
+                MPIX_Ialltoall(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+                        inplace_alltoall.data(), s, MPI_INT, locality_comm, &xreqs[1]);
+            }
+
+            int flags[2] = {0, 0};
+            while (!flags[0] || !flags[1])
+            {
+                for (int j = 0; j < 2; j++)
+                {
+                    int idx = (rank % 2) ? 1 - j : j;
+                    if (!flags[idx])
+                        MPIX_Test(xreqs[idx], &flags[idx], MPI_STATUS_IGNORE);
+                }
+            }
+            MPIX_Request_free(&xreqs[0]);
+            MPIX_Request_free(&xreqs[1]);
+
+            for (int j = 0; j < s*num_procs; j++)
+            {
+                ASSERT_EQ(std_alltoall[j], loc_alltoall[j]);
+                ASSERT_EQ(std_alltoall[j], inplace_alltoall[j]);
+            }
+        }
+    }
+
+    MPIX_Comm_free(&locality_comm);
+}
@@ -0,0 +1,120 @@
+// EXPECT_EQ and ASSERT_EQ are macros
+// EXPECT_EQ test execution and continues even if there is a failure
+// ASSERT_EQ test execution and aborts if there is a failure
+// The ASSERT_* variants abort the program execution if an assertion fails
+// while EXPECT_* variants continue with the run.
+
+
+#include "gtest/gtest.h"
+#include "mpi_advance.h"
+#include <mpi.h>
+#include <math.h>
+#include <stdlib.h>
+#include <iostream>
+#include <assert.h>
+#include <vector>
+
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+int main(int argc, char** argv)
+{
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+#ifdef OPENMP
+    // Uneven split of 15 peers
+    omp_set_num_threads(4);
+#endif
+    ::testing::InitGoogleTest(&argc, argv);
+    int temp=RUN_ALL_TESTS();
+    MPI_Finalize();
+    return temp;
+} // end of main() //
+
+
+TEST(ThreadedTest, TestsInTests)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+
+    int max_i = 6;
+    int max_s = pow(2, max_i);
+
+    MPIX_Comm* xcomm;
+    MPIX_Comm_init(&xcomm, MPI_COMM_WORLD);
+
+    // Every other int (packed by each thread)
+    MPI_Datatype strided_type;
+    MPI_Type_create_resized(MPI_INT, 0, 2*sizeof(int), &strided_type);
+    MPI_Type_commit(&strided_type);
+
+    std::vector<int> local_data(2*max_s*num_procs);
+    std::vector<int> std_alltoall(2*max_s*num_procs);
+    std::vector<int> new_alltoall(2*max_s*num_procs);
+    std::vector<int> sendcounts(num_procs);
+    std::vector<int> sdispls(num_procs+1);
+    std::vector<int> recvcounts(num_procs);
+    std::vector<int> rdispls(num_procs+1);
+
+    for (int i = 0; i < max_i; i++)
+    {
+        int s = pow(2, i);
+        for (int j = 0; j < 2*max_s*num_procs; j++)
+            local_data[j] = rank*10000 + j;
+
+        // Alltoall
+        PMPI_Alltoall(local_data.data(), s, MPI_INT,
+                std_alltoall.data(), s, MPI_INT, MPI_COMM_WORLD);
+        std::fill(new_alltoall.begin(), new_alltoall.end(), -1);
+        alltoall_threaded(local_data.data(), s, MPI_INT,
+                new_alltoall.data(), s, MPI_INT, xcomm);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoall[j], new_alltoall[j]);
+
+        std::fill(std_alltoall.begin(), std_alltoall.end(), -1);
+        PMPI_Alltoall(local_data.data(), s, strided_type,
+                std_alltoall.data(), s, strided_type, MPI_COMM_WORLD);
+        std::fill(new_alltoall.begin(), new_alltoall.end(), -1);
+        alltoall_threaded(local_data.data(), s, strided_type,
+                new_alltoall.data(), s, strided_type, xcomm);
+        for (int j = 0; j < 2*s*num_procs; j++)
+            ASSERT_EQ(std_alltoall[j], new_alltoall[j]);
+
+        // Alltoallv, uneven sizes
+        sdispls[0] = 0;
+        rdispls[0] = 0;
+        for (int j = 0; j < num_procs; j++)
+        {
+            sendcounts[j] = (rank + 2*j + i) % max_s;
+            recvcounts[j] = (j + 2*rank + i) % max_s;
+            sdispls[j+1] = sdispls[j] + sendcounts[j];
+            rdispls[j+1] = rdispls[j] + recvcounts[j];
+        }
+
+        PMPI_Alltoallv(local_data.data(), sendcounts.data(), sdispls.data(), MPI_INT,
+                std_alltoall.data(), recvcounts.data(), rdispls.data(), MPI_INT,
+                MPI_COMM_WORLD);
+        std::fill(new_alltoall.begin(), new_alltoall.end(), -1);
+        alltoallv_threaded(local_data.data(), sendcounts.data(), sdispls.data(), MPI_INT,
+                new_alltoall.data(), recvcounts.data(), rdispls.data(), MPI_INT,
+                xcomm);
+        for (int j = 0; j < rdispls[num_procs]; j++)
+            ASSERT_EQ(std_alltoall[j], new_alltoall[j]);
+
+        std::fill(std_alltoall.begin(), std_alltoall.end(), -1);
+        PMPI_Alltoallv(local_data.data(), sendcounts.data(), sdispls.data(), strided_type,
+                std_alltoall.data(), recvcounts.data(), rdispls.data(), strided_type,
+                MPI_COMM_WORLD);
+        std::fill(new_alltoall.begin(), new_alltoall.end(), -1);
+        alltoallv_threaded(local_data.data(), sendcounts.data(), sdispls.data(), strided_type,
+                new_alltoall.data(), recvcounts.data(), rdispls.data(), strided_type,
+                xcomm);
+        for (int j = 0; j < 2*rdispls[num_procs]; j++)
+            ASSERT_EQ(std_alltoall[j], new_alltoall[j]);
+    }
+
+    MPI_Type_free(&strided_type);
+    MPIX_Comm_free(&xcomm);
+}
@@ -9,6 +9,7 @@
 #include "mpi_advance.h"
 #include <mpi.h>
 #include <math.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <iostream>
 #include <assert.h>
@@ -41,6 +42,7 @@ TEST(RandomCommTest, TestsInTests)
     std::vector<int> std_alltoallv(max_s*num_procs);
     std::vector<int> pairwise_alltoallv(max_s*num_procs);
     std::vector<int> loc_pairwise_alltoallv(max_s*num_procs);
+    std::vector<int> sub_alltoallv(max_s*num_procs);
 
     std::vector<int> sizes(num_procs);
     std::vector<int> displs(num_procs+1);
@@ -49,6 +51,11 @@ TEST(RandomCommTest, TestsInTests)
     MPIX_Comm_init(&locality_comm, MPI_COMM_WORLD);
     update_locality(locality_comm, 4);
 
+    // Communicator without the last process
+    MPI_Comm sub_comm;
+    int sub_procs = num_procs - 1;
+    MPI_Comm_split(MPI_COMM_WORLD, rank < sub_procs, rank, &sub_comm);
+
     for (int i = 0; i < max_i; i++)
     {
         int s = pow(2, i);
@@ -99,9 +106,653 @@ TEST(RandomCommTest, TestsInTests)
                 locality_comm);
         for (int j = 0; j < s*num_procs; j++)
             ASSERT_EQ(std_alltoallv[j], loc_pairwise_alltoallv[j]);
+
+        // Pairwise-XOR Alltoallv
+        std::fill(pairwise_alltoallv.begin(), pairwise_alltoallv.end(), 0);
+        alltoallv_pairwise_log2(local_data.data(), 
+                sizes.data(),
+                displs.data(),
+                MPI_INT, 
+                pairwise_alltoallv.data(), 
+                sizes.data(),
+                displs.data(),
+                MPI_INT,
+                MPI_COMM_WORLD);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoallv[j], pairwise_alltoallv[j]);
+
+        std::fill(pairwise_alltoallv.begin(), pairwise_alltoallv.end(), 0);
+        alltoallv_pairwise_nonblocking_log2(local_data.data(), 
+                sizes.data(),
+                displs.data(),
+                MPI_INT, 
+                pairwise_alltoallv.data(), 
+                sizes.data(),
+                displs.data(),
+                MPI_INT,
+                MPI_COMM_WORLD);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoallv[j], pairwise_alltoallv[j]);
+
+        // Pairwise-XOR fallback (process count not a power of two)
+        if (rank < sub_procs)
+        {
+            PMPI_Alltoallv(local_data.data(), 
+                    sizes.data(),
+                    displs.data(),
+                    MPI_INT, 
+                    sub_alltoallv.data(), 
+                    sizes.data(),
+                    displs.data(),
+                    MPI_INT,
+                    sub_comm);
+
+            std::fill(pairwise_alltoallv.begin(), pairwise_alltoallv.end(), 0);
+            alltoallv_pairwise_log2(local_data.data(), 
+                    sizes.data(),
+                    displs.data(),
+                    MPI_INT, 
+                    pairwise_alltoallv.data(), 
+                    sizes.data(),
+                    displs.data(),
+                    MPI_INT,
+                    sub_comm);
+            for (int j = 0; j < s*sub_procs; j++)
+                ASSERT_EQ(sub_alltoallv[j], pairwise_alltoallv[j]);
+
+            std::fill(pairwise_alltoallv.begin(), pairwise_alltoallv.end(), 0);
+            alltoallv_pairwise_nonblocking_log2(local_data.data(), 
+                    sizes.data(),
+                    displs.data(),
+                    MPI_INT, 
+                    pairwise_alltoallv.data(), 
+                    sizes.data(),
+                    displs.data(),
+                    MPI_INT,
+                    sub_comm);
+            for (int j = 0; j < s*sub_procs; j++)
+                ASSERT_EQ(sub_alltoallv[j], pairwise_alltoallv[j]);
+        }
+
+        // Nonblocking Alltoallv (polled)
+        MPIX_Request* xreq;
+        std::fill(loc_pairwise_alltoallv.begin(), loc_pairwise_alltoallv.end(), 0);
+        MPIX_Ialltoallv(local_data.data(), 
+                sizes.data(),
+                displs.data(),
+                MPI_INT, 
+                loc_pairwise_alltoallv.data(), 
+                sizes.data(),
+                displs.data(),
+                MPI_INT,
+                locality_comm,
+                &xreq);
+        int flag = 0;
+        while (!flag)
+            MPIX_Test(xreq, &flag, MPI_STATUS_IGNORE);
+        MPIX_Request_free(&xreq);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoallv[j], loc_pairwise_alltoallv[j]);
+
+        // Big-Count Alltoallv (MPI_Count counts, MPI_Aint displacements)
+        std::vector<MPI_Count> big_sizes(sizes.begin(), sizes.end());
+        std::vector<MPI_Aint> big_displs(displs.begin(), displs.end());
+        std::fill(loc_pairwise_alltoallv.begin(), loc_pairwise_alltoallv.end(), 0);
+        MPIX_Alltoallv_c(local_data.data(), 
+                big_sizes.data(),
+                big_displs.data(),
+                MPI_INT, 
+                loc_pairwise_alltoallv.data(), 
+                big_sizes.data(),
+                big_displs.data(),
+                MPI_INT,
+                locality_comm);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoallv[j], loc_pairwise_alltoallv[j]);
+
+        std::fill(pairwise_alltoallv.begin(), pairwise_alltoallv.end(), 0);
+        alltoallv_pairwise_c(local_data.data(), 
+                big_sizes.data(),
+                big_displs.data(),
+                MPI_INT, 
+                pairwise_alltoallv.data(), 
+                big_sizes.data(),
+                big_displs.data(),
+                MPI_INT,
+                NULL,
+                NULL,
+                MPI_COMM_WORLD);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoallv[j], pairwise_alltoallv[j]);
+
+        // In-Place Alltoallv (pairwise swap)
+        std::copy(local_data.begin(), local_data.begin() + s*num_procs, 
+                loc_pairwise_alltoallv.begin());
+        MPIX_Alltoallv(MPI_IN_PLACE, 
+                NULL,
+                NULL,
+                MPI_DATATYPE_NULL, 
+                loc_pairwise_alltoallv.data(), 
+                sizes.data(),
+                displs.data(),
+                MPI_INT,
+                locality_comm);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoallv[j], loc_pairwise_alltoallv[j]);
     }
 
+    MPI_Comm_free(&sub_comm);
     MPIX_Comm_free(&locality_comm);
 }
 
 
+
+TEST(LocalityTest, TestsInTests)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+
+    int max_s = 64;
+
+    MPIX_Comm* locality_comm;
+    MPIX_Comm_init(&locality_comm, MPI_COMM_WORLD);
+    update_locality(locality_comm, 4);
+
+    // Two leaders per (4-process) node
+    MPIX_Info* xinfo;
+    MPIX_Info_init(&xinfo);
+    xinfo->leaders_per_node = 2;
+    MPIX_Comm* leader_comm;
+    MPIX_Comm_init(&leader_comm, MPI_COMM_WORLD);
+    update_locality(leader_comm, 4);
+    MPIX_Comm_leader_init(leader_comm, xinfo);
+
+    // Hybrid : blocks over 32 ints are sent directly
+    xinfo->aggregation_bytes = 32*sizeof(int);
+    MPIX_Comm_info_init(locality_comm, xinfo);
+    MPIX_Comm_info_init(leader_comm, xinfo);
+
+    std::vector<int> sendcounts(num_procs);
+    std::vector<int> sdispls(num_procs+1);
+    std::vector<int> recvcounts(num_procs);
+    std::vector<int> rdispls(num_procs+1);
+    std::vector<int> local_data(max_s*num_procs);
+    std::vector<int> std_alltoallv(max_s*num_procs);
+    std::vector<int> loc_alltoallv(max_s*num_procs);
+
+    for (int i = 0; i < 4; i++)
+    {
+        // Uneven (some empty) sizes : rank r sends (r + 3*j + i) % max_s to j
+        sdispls[0] = 0;
+        rdispls[0] = 0;
+        for (int j = 0; j < num_procs; j++)
+        {
+            sendcounts[j] = (rank + 3*j + i) % max_s;
+            recvcounts[j] = (j + 3*rank + i) % max_s;
+            sdispls[j+1] = sdispls[j] + sendcounts[j];
+            rdispls[j+1] = rdispls[j] + recvcounts[j];
+        }
+        for (int j = 0; j < sdispls[num_procs]; j++)
+            local_data[j] = rank*10000 + j;
+
+        PMPI_Alltoallv(local_data.data(), sendcounts.data(), sdispls.data(), MPI_INT,
+                std_alltoallv.data(), recvcounts.data(), rdispls.data(), MPI_INT,
+                MPI_COMM_WORLD);
+
+        std::fill(loc_alltoallv.begin(), loc_alltoallv.end(), 0);
+        alltoallv_pairwise_loc(local_data.data(), sendcounts.data(), sdispls.data(), MPI_INT,
+                loc_alltoallv.data(), recvcounts.data(), rdispls.data(), MPI_INT,
+                locality_comm);
+        for (int j = 0; j < rdispls[num_procs]; j++)
+            ASSERT_EQ(std_alltoallv[j], loc_alltoallv[j]);
+
+        std::fill(loc_alltoallv.begin(), loc_alltoallv.end(), 0);
+        alltoallv_pairwise_loc(local_data.data(), sendcounts.data(), sdispls.data(), MPI_INT,
+                loc_alltoallv.data(), recvcounts.data(), rdispls.data(), MPI_INT,
+                leader_comm);
+        for (int j = 0; j < rdispls[num_procs]; j++)
+            ASSERT_EQ(std_alltoallv[j], loc_alltoallv[j]);
+
+        std::fill(loc_alltoallv.begin(), loc_alltoallv.end(), 0);
+        alltoallv_hybrid_loc(local_data.data(), sendcounts.data(), sdispls.data(), MPI_INT,
+                loc_alltoallv.data(), recvcounts.data(), rdispls.data(), MPI_INT,
+                locality_comm);
+        for (int j = 0; j < rdispls[num_procs]; j++)
+            ASSERT_EQ(std_alltoallv[j], loc_alltoallv[j]);
+
+        std::fill(loc_alltoallv.begin(), loc_alltoallv.end(), 0);
+        alltoallv_hybrid_loc(local_data.data(), sendcounts.data(), sdispls.data(), MPI_INT,
+                loc_alltoallv.data(), recvcounts.data(), rdispls.data(), MPI_INT,
+                leader_comm);
+        for (int j = 0; j < rdispls[num_procs]; j++)
+            ASSERT_EQ(std_alltoallv[j], loc_alltoallv[j]);
+
+        // Persistent Load-Balanced Alltoallv (started twice)
+        MPIX_Request* xreq;
+        MPIX_Alltoallv_init(local_data.data(), sendcounts.data(), sdispls.data(), MPI_INT,
+                loc_alltoallv.data(), recvcounts.data(), rdispls.data(), MPI_INT,
+                locality_comm, MPI_INFO_NULL, &xreq);
+        for (int iter = 0; iter < 2; iter++)
+        {
+            std::fill(loc_alltoallv.begin(), loc_alltoallv.end(), 0);
+            MPIX_Start(xreq);
+            MPIX_Wait(xreq, MPI_STATUS_IGNORE);
+            for (int j = 0; j < rdispls[num_procs]; j++)
+                ASSERT_EQ(std_alltoallv[j], loc_alltoallv[j]);
+        }
+        MPIX_Request_free(&xreq);
+    }
+
+    MPIX_Info_free(&xinfo);
+    MPIX_Comm_free(&leader_comm);
+    MPIX_Comm_free(&locality_comm);
+}
+
+TEST(SparseTest, TestsInTests)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+
+    int max_s = 16;
+
+    MPIX_Comm* locality_comm;
+    MPIX_Comm_init(&locality_comm, MPI_COMM_WORLD);
+    update_locality(locality_comm, 4);
+
+    // Sparse selection is on by default
+    ASSERT_EQ(locality_comm->sparse_percent, 10);
+
+    std::vector<int> sendcounts(num_procs);
+    std::vector<int> sdispls(num_procs+1);
+    std::vector<int> recvcounts(num_procs);
+    std::vector<int> rdispls(num_procs+1);
+    std::vector<int> local_data(max_s*num_procs);
+    std::vector<int> std_alltoallv(max_s*num_procs);
+    std::vector<int> sparse_alltoallv(max_s*num_procs);
+
+    for (int i = 0; i < 4; i++)
+    {
+        // Each process only sends to rank + 1 + i (one non-zero count per process)
+        sdispls[0] = 0;
+        rdispls[0] = 0;
+        for (int j = 0; j < num_procs; j++)
+        {
+            int send_dist = (j - rank + num_procs) % num_procs;
+            int recv_dist = (rank - j + num_procs) % num_procs;
+            sendcounts[j] = (send_dist == 1 + i) ? 1 + (rank + j) % max_s : 0;
+            recvcounts[j] = (recv_dist == 1 + i) ? 1 + (rank + j) % max_s : 0;
+            sdispls[j+1] = sdispls[j] + sendcounts[j];
+            rdispls[j+1] = rdispls[j] + recvcounts[j];
+        }
+        for (int j = 0; j < sdispls[num_procs]; j++)
+            local_data[j] = rank*10000 + j;
+
+        PMPI_Alltoallv(local_data.data(), sendcounts.data(), sdispls.data(), MPI_INT,
+                std_alltoallv.data(), recvcounts.data(), rdispls.data(), MPI_INT,
+                MPI_COMM_WORLD);
+
+        std::fill(sparse_alltoallv.begin(), sparse_alltoallv.end(), 0);
+        alltoallv_sparse(local_data.data(), sendcounts.data(), sdispls.data(), MPI_INT,
+                sparse_alltoallv.data(), recvcounts.data(), rdispls.data(), MPI_INT,
+                MPI_COMM_WORLD);
+        for (int j = 0; j < rdispls[num_procs]; j++)
+            ASSERT_EQ(std_alltoallv[j], sparse_alltoallv[j]);
+
+        // Selected automatically (below sparse_percent non-zero counts)
+        std::fill(sparse_alltoallv.begin(), sparse_alltoallv.end(), 0);
+        MPIX_Alltoallv(local_data.data(), sendcounts.data(), sdispls.data(), MPI_INT,
+                sparse_alltoallv.data(), recvcounts.data(), rdispls.data(), MPI_INT,
+                locality_comm);
+        for (int j = 0; j < rdispls[num_procs]; j++)
+            ASSERT_EQ(std_alltoallv[j], sparse_alltoallv[j]);
+    }
+
+    MPIX_Comm_free(&locality_comm);
+}
+
+TEST(BruckTest, TestsInTests)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+
+    int max_s = 4;
+
+    MPIX_Comm* locality_comm;
+    MPIX_Comm_init(&locality_comm, MPI_COMM_WORLD);
+    update_locality(locality_comm, 4);
+
+    // Two leaders per (4-process) node
+    MPIX_Info* xinfo;
+    MPIX_Info_init(&xinfo);
+    xinfo->leaders_per_node = 2;
+    MPIX_Comm* leader_comm;
+    MPIX_Comm_init(&leader_comm, MPI_COMM_WORLD);
+    update_locality(leader_comm, 4);
+    MPIX_Comm_leader_init(leader_comm, xinfo);
+
+    // Communicator without the last process (not a power of two)
+    MPI_Comm sub_comm;
+    int sub_procs = num_procs - 1;
+    MPI_Comm_split(MPI_COMM_WORLD, rank < sub_procs, rank, &sub_comm);
+
+    std::vector<int> sendcounts(num_procs);
+    std::vector<int> sdispls(num_procs+1);
+    std::vector<int> recvcounts(num_procs);
+    std::vector<int> rdispls(num_procs+1);
+    std::vector<int> local_data(max_s*num_procs);
+    std::vector<int> std_alltoallv(max_s*num_procs);
+    std::vector<int> bruck_alltoallv(max_s*num_procs);
+
+    for (int i = 0; i < 4; i++)
+    {
+        // Tiny irregular blocks, including empty ones
+        sdispls[0] = 0;
+        rdispls[0] = 0;
+        for (int j = 0; j < num_procs; j++)
+        {
+            sendcounts[j] = (rank + 2*j + i) % max_s;
+            recvcounts[j] = (j + 2*rank + i) % max_s;
+            sdispls[j+1] = sdispls[j] + sendcounts[j];
+            rdispls[j+1] = rdispls[j] + recvcounts[j];
+        }
+        for (int j = 0; j < sdispls[num_procs]; j++)
+            local_data[j] = rank*10000 + j;
+
+        PMPI_Alltoallv(local_data.data(), sendcounts.data(), sdispls.data(), MPI_INT,
+                std_alltoallv.data(), recvcounts.data(), rdispls.data(), MPI_INT,
+                MPI_COMM_WORLD);
+
+        std::fill(bruck_alltoallv.begin(), bruck_alltoallv.end(), 0);
+        alltoallv_bruck(local_data.data(), sendcounts.data(), sdispls.data(), MPI_INT,
+                bruck_alltoallv.data(), recvcounts.data(), rdispls.data(), MPI_INT,
+                MPI_COMM_WORLD);
+        for (int j = 0; j < rdispls[num_procs]; j++)
+            ASSERT_EQ(std_alltoallv[j], bruck_alltoallv[j]);
+
+        std::fill(bruck_alltoallv.begin(), bruck_alltoallv.end(), 0);
+        alltoallv_bruck_loc(local_data.data(), sendcounts.data(), sdispls.data(), MPI_INT,
+                bruck_alltoallv.data(), recvcounts.data(), rdispls.data(), MPI_INT,
+                locality_comm);
+        for (int j = 0; j < rdispls[num_procs]; j++)
+            ASSERT_EQ(std_alltoallv[j], bruck_alltoallv[j]);
+
+        std::fill(bruck_alltoallv.begin(), bruck_alltoallv.end(), 0);
+        alltoallv_bruck_loc(local_data.data(), sendcounts.data(), sdispls.data(), MPI_INT,
+                bruck_alltoallv.data(), recvcounts.data(), rdispls.data(), MPI_INT,
+                leader_comm);
+        for (int j = 0; j < rdispls[num_procs]; j++)
+            ASSERT_EQ(std_alltoallv[j], bruck_alltoallv[j]);
+
+        // In place : counts are symmetric
+        for (int j = 0; j < num_procs; j++)
+        {
+            sendcounts[j] = (rank + j + i) % max_s;
+            sdispls[j+1] = sdispls[j] + sendcounts[j];
+        }
+        for (int j = 0; j < sdispls[num_procs]; j++)
+            local_data[j] = rank*10000 + j;
+        PMPI_Alltoallv(local_data.data(), sendcounts.data(), sdispls.data(), MPI_INT,
+                std_alltoallv.data(), sendcounts.data(), sdispls.data(), MPI_INT,
+                MPI_COMM_WORLD);
+
+        std::copy(local_data.begin(), local_data.end(), bruck_alltoallv.begin());
+        alltoallv_bruck(MPI_IN_PLACE, NULL, NULL, MPI_DATATYPE_NULL,
+                bruck_alltoallv.data(), sendcounts.data(), sdispls.data(), MPI_INT,
+                MPI_COMM_WORLD);
+        for (int j = 0; j < sdispls[num_procs]; j++)
+            ASSERT_EQ(std_alltoallv[j], bruck_alltoallv[j]);
+
+        std::copy(local_data.begin(), local_data.end(), bruck_alltoallv.begin());
+        alltoallv_bruck_loc(MPI_IN_PLACE, NULL, NULL, MPI_DATATYPE_NULL,
+                bruck_alltoallv.data(), sendcounts.data(), sdispls.data(), MPI_INT,
+                locality_comm);
+        for (int j = 0; j < sdispls[num_procs]; j++)
+            ASSERT_EQ(std_alltoallv[j], bruck_alltoallv[j]);
+
+        if (rank < sub_procs)
+        {
+            for (int j = 0; j < sub_procs; j++)
+            {
+                sendcounts[j] = (rank + 2*j + i) % max_s;
+                recvcounts[j] = (j + 2*rank + i) % max_s;
+                sdispls[j+1] = sdispls[j] + sendcounts[j];
+                rdispls[j+1] = rdispls[j] + recvcounts[j];
+            }
+            for (int j = 0; j < sdispls[sub_procs]; j++)
+                local_data[j] = rank*10000 + j;
+
+            PMPI_Alltoallv(local_data.data(), sendcounts.data(), sdispls.data(), MPI_INT,
+                    std_alltoallv.data(), recvcounts.data(), rdispls.data(), MPI_INT,
+                    sub_comm);
+            std::fill(bruck_alltoallv.begin(), bruck_alltoallv.end(), 0);
+            alltoallv_bruck(local_data.data(), sendcounts.data(), sdispls.data(), MPI_INT,
+                    bruck_alltoallv.data(), recvcounts.data(), rdispls.data(), MPI_INT,
+                    sub_comm);
+            for (int j = 0; j < rdispls[sub_procs]; j++)
+                ASSERT_EQ(std_alltoallv[j], bruck_alltoallv[j]);
+        }
+    }
+
+    MPI_Comm_free(&sub_comm);
+    MPIX_Info_free(&xinfo);
+    MPIX_Comm_free(&leader_comm);
+    MPIX_Comm_free(&locality_comm);
+}
+
+TEST(WindowTest, TestsInTests)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+
+    int max_i = 8;
+    int max_s = pow(2, max_i);
+
+    // Window set through MPIX_Info
+    MPIX_Info* xinfo;
+    MPIX_Info_init(&xinfo);
+    xinfo->nb_window = 3;
+    xinfo->adaptive_window = 1;
+    MPIX_Comm* locality_comm;
+    MPIX_Comm_init(&locality_comm, MPI_COMM_WORLD);
+    MPIX_Comm_info_init(locality_comm, xinfo);
+    ASSERT_EQ(locality_comm->nb_window.size, 3);
+    ASSERT_EQ(locality_comm->nb_window.adaptive, 1);
+
+    std::vector<int> local_data(max_s*num_procs);
+    std::vector<int> std_alltoallv(max_s*num_procs);
+    std::vector<int> new_alltoallv(max_s*num_procs);
+    std::vector<int> sizes(num_procs);
+    std::vector<int> displs(num_procs+1);
+
+    MPIX_Window fixed;
+    MPIX_Window_init(&fixed, 3, 0);
+
+    for (int i = 0; i < max_i; i++)
+    {
+        int s = pow(2, i);
+        displs[0] = 0;
+        for (int j = 0; j < num_procs; j++)
+        {
+            sizes[j] = s;
+            displs[j+1] = displs[j] + s;
+        }
+        for (int j = 0; j < s*num_procs; j++)
+            local_data[j] = rank*10000 + j;
+
+        PMPI_Alltoallv(local_data.data(), sizes.data(), displs.data(), MPI_INT,
+                std_alltoallv.data(), sizes.data(), displs.data(), MPI_INT,
+                MPI_COMM_WORLD);
+
+        // Fixed window is never changed
+        std::fill(new_alltoallv.begin(), new_alltoallv.end(), 0);
+        alltoallv_pairwise_nonblocking_window(local_data.data(), sizes.data(), displs.data(), 
+                MPI_INT, new_alltoallv.data(), sizes.data(), displs.data(), MPI_INT,
+                NULL, NULL, &fixed, MPI_COMM_WORLD);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoallv[j], new_alltoallv[j]);
+        ASSERT_EQ(fixed.size, 3);
+
+        // Adaptive window, kept across calls on locality_comm
+        std::fill(new_alltoallv.begin(), new_alltoallv.end(), 0);
+        alltoallv_pairwise_nonblocking_window(local_data.data(), sizes.data(), displs.data(), 
+                MPI_INT, new_alltoallv.data(), sizes.data(), displs.data(), MPI_INT,
+                NULL, NULL, &(locality_comm->nb_window), MPI_COMM_WORLD);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoallv[j], new_alltoallv[j]);
+
+        std::fill(new_alltoallv.begin(), new_alltoallv.end(), 0);
+        alltoallv_waitany_window(local_data.data(), sizes.data(), displs.data(), 
+                MPI_INT, new_alltoallv.data(), sizes.data(), displs.data(), MPI_INT,
+                NULL, NULL, &(locality_comm->nb_window), MPI_COMM_WORLD);
+        for (int j = 0; j < s*num_procs; j++)
+            ASSERT_EQ(std_alltoallv[j], new_alltoallv[j]);
+
+        // Statistics
+        MPIX_Window* window = &(locality_comm->nb_window);
+        ASSERT_EQ(window->n_calls, 2*(i+1));
+        ASSERT_GE(window->size, 1);
+        ASSERT_LE(window->size, num_procs - 1);
+        ASSERT_LE(window->last_min_size, window->size);
+        ASSERT_GE(window->last_max_size, window->size);
+    }
+
+    MPIX_Info_free(&xinfo);
+    MPIX_Comm_free(&locality_comm);
+}
+
+TEST(DatatypeTest, TestsInTests)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+
+    int max_i = 6;
+    int max_s = pow(2, max_i);
+
+    MPIX_Comm* locality_comm;
+    MPIX_Comm_init(&locality_comm, MPI_COMM_WORLD);
+    update_locality(locality_comm, 4);
+
+    // Every other int (extent of two ints)
+    MPI_Datatype strided_type;
+    MPI_Type_create_resized(MPI_INT, 0, 2*sizeof(int), &strided_type);
+    MPI_Type_commit(&strided_type);
+
+    alltoallv_ftn alltoallv_methods[ALLTOALLV_PAIRWISE_LOC] = {
+        alltoallv_pairwise,
+        alltoallv_nonblocking,
+        alltoallv_pairwise_nonblocking,
+        alltoallv_waitany,
+        alltoallv_pairwise_log2,
+        alltoallv_pairwise_nonblocking_log2,
+        alltoallv_sparse,
+        alltoallv_bruck
+    };
+
+    std::vector<int> local_data(2*max_s*num_procs);
+    std::vector<int> std_alltoallv(2*max_s*num_procs);
+    std::vector<int> new_alltoallv(2*max_s*num_procs);
+    std::vector<int> sizes(num_procs);
+    std::vector<int> displs(num_procs+1);
+
+    for (int i = 0; i < max_i; i++)
+    {
+        // Uneven sizes, with gaps between blocks
+        displs[0] = 0;
+        for (int j = 0; j < num_procs; j++)
+        {
+            sizes[j] = 1 + (rank + j + i) % max_s;
+            displs[j+1] = displs[j] + max_s;
+        }
+        for (int j = 0; j < 2*max_s*num_procs; j++)
+            local_data[j] = rank*10000 + j;
+
+        // Expected values computed directly (holes stay -1)
+        std::fill(std_alltoallv.begin(), std_alltoallv.end(), -1);
+        for (int j = 0; j < num_procs; j++)
+            for (int k = 0; k < sizes[j]; k++)
+                std_alltoallv[2*(displs[j] + k)] = j*10000 + 2*(displs[rank] + k);
+        for (int m = 0; m < ALLTOALLV_PAIRWISE_LOC; m++)
+        {
+            std::fill(new_alltoallv.begin(), new_alltoallv.end(), -1);
+            alltoallv_methods[m](local_data.data(), sizes.data(), displs.data(), strided_type,
+                    new_alltoallv.data(), sizes.data(), displs.data(), strided_type,
+                    MPI_COMM_WORLD);
+            for (int j = 0; j < 2*max_s*num_procs; j++)
+                ASSERT_EQ(std_alltoallv[j], new_alltoallv[j]);
+        }
+
+        std::fill(new_alltoallv.begin(), new_alltoallv.end(), -1);
+        alltoallv_pairwise_loc(local_data.data(), sizes.data(), displs.data(), strided_type,
+                new_alltoallv.data(), sizes.data(), displs.data(), strided_type,
+                locality_comm);
+        for (int j = 0; j < 2*max_s*num_procs; j++)
+            ASSERT_EQ(std_alltoallv[j], new_alltoallv[j]);
+
+        std::fill(new_alltoallv.begin(), new_alltoallv.end(), -1);
+        alltoallv_bruck_loc(local_data.data(), sizes.data(), displs.data(), strided_type,
+                new_alltoallv.data(), sizes.data(), displs.data(), strided_type,
+                locality_comm);
+        for (int j = 0; j < 2*max_s*num_procs; j++)
+            ASSERT_EQ(std_alltoallv[j], new_alltoallv[j]);
+
+        MPIX_Request* xreq;
+        std::fill(new_alltoallv.begin(), new_alltoallv.end(), -1);
+        MPIX_Ialltoallv(local_data.data(), sizes.data(), displs.data(), strided_type,
+                new_alltoallv.data(), sizes.data(), displs.data(), strided_type,
+                locality_comm, &xreq);
+        MPIX_Wait(xreq, MPI_STATUS_IGNORE);
+        MPIX_Request_free(&xreq);
+        for (int j = 0; j < 2*max_s*num_procs; j++)
+            ASSERT_EQ(std_alltoallv[j], new_alltoallv[j]);
+
+        // In place : holes keep their original values
+        std::copy(local_data.begin(), local_data.end(), new_alltoallv.begin());
+        MPIX_Alltoallv(MPI_IN_PLACE, NULL, NULL, MPI_DATATYPE_NULL,
+                new_alltoallv.data(), sizes.data(), displs.data(), strided_type,
+                locality_comm);
+        for (int j = 0; j < 2*max_s*num_procs; j++)
+        {
+            if (std_alltoallv[j] != -1)
+            {
+                ASSERT_EQ(std_alltoallv[j], new_alltoallv[j]);
+            }
+        }
+    }
+
+    // Struct with blocks out of memory order fills its extent, but is
+    // packed in type map order (not a single memcpy)
+    MPI_Datatype reorder_type;
+    int block_lens[3] = {1, 1, 1};
+    MPI_Aint block_displs[3] = {0, 2*sizeof(int), sizeof(int)};
+    MPI_Datatype block_types[3] = {MPI_INT, MPI_INT, MPI_INT};
+    MPI_Type_create_struct(3, block_lens, block_displs, block_types, &reorder_type);
+    MPI_Type_commit(&reorder_type);
+    ASSERT_EQ(MPIX_Type_is_contiguous(reorder_type), 0);
+    int reorder_vals[3] = {0, 1, 2};
+    int packed_vals[3];
+    MPIX_Type_pack(reorder_vals, 1, reorder_type, packed_vals);
+    ASSERT_EQ(packed_vals[0], 0);
+    ASSERT_EQ(packed_vals[1], 2);
+    ASSERT_EQ(packed_vals[2], 1);
+    MPI_Type_free(&reorder_type);
+
+    // More than INT_MAX elements (as passed by the big-count paths) :
+    // size is kept as an MPI_Count, and the type is one block
+    MPI_Datatype big_type;
+    MPI_Count big_count = (MPI_Count)INT_MAX + 8;
+    big_type_contiguous(big_count, MPI_CHAR, &big_type);
+    MPIX_Flat_type* big_flat;
+    MPIX_Type_flatten(big_type, &big_flat);
+    ASSERT_EQ(big_flat->size, big_count);
+    ASSERT_EQ(big_flat->n_blocks, 1);
+    ASSERT_EQ(big_flat->contiguous, 1);
+    MPI_Type_free(&big_type);
+
+    MPI_Type_free(&strided_type);
+    MPIX_Comm_free(&locality_comm);
+}
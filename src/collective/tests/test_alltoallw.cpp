@@ -0,0 +1,146 @@
+// EXPECT_EQ and ASSERT_EQ are macros
+// EXPECT_EQ test execution and continues even if there is a failure
+// ASSERT_EQ test execution and aborts if there is a failure
+// The ASSERT_* variants abort the program execution if an assertion fails
+// while EXPECT_* variants continue with the run.
+
+
+#include "gtest/gtest.h"
+#include "mpi_advance.h"
+#include <mpi.h>
+#include <math.h>
+#include <stdlib.h>
+#include <iostream>
+#include <assert.h>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+    MPI_Init(&argc, &argv);
+    ::testing::InitGoogleTest(&argc, argv);
+    int temp=RUN_ALL_TESTS();
+    MPI_Finalize();
+    return temp;
+} // end of main() //
+
+
+TEST(RandomCommTest, TestsInTests)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+
+    int max_i = 5;
+    int max_s = pow(2, max_i);
+
+    MPIX_Comm* locality_comm;
+    MPIX_Comm_init(&locality_comm, MPI_COMM_WORLD);
+    update_locality(locality_comm, 4);
+
+    // Two leaders per (4-process) node
+    MPIX_Info* xinfo;
+    MPIX_Info_init(&xinfo);
+    xinfo->leaders_per_node = 2;
+    MPIX_Comm* leader_comm;
+    MPIX_Comm_init(&leader_comm, MPI_COMM_WORLD);
+    update_locality(leader_comm, 4);
+    MPIX_Comm_leader_init(leader_comm, xinfo);
+
+    // One int per element, with extents of 1, 2 and 3 ints
+    MPI_Datatype types[3];
+    types[0] = MPI_INT;
+    MPI_Type_create_resized(MPI_INT, 0, 2*sizeof(int), &(types[1]));
+    MPI_Type_create_resized(MPI_INT, 0, 3*sizeof(int), &(types[2]));
+    MPI_Type_commit(&(types[1]));
+    MPI_Type_commit(&(types[2]));
+
+    // Each block has room for max_s elements of any type
+    int block_ints = 3*max_s;
+    std::vector<int> local_data(block_ints*num_procs);
+    std::vector<int> std_alltoallw(block_ints*num_procs);
+    std::vector<int> new_alltoallw(block_ints*num_procs);
+
+    std::vector<int> sendcounts(num_procs);
+    std::vector<int> recvcounts(num_procs);
+    std::vector<int> displs(num_procs);
+    std::vector<MPI_Datatype> sendtypes(num_procs);
+    std::vector<MPI_Datatype> recvtypes(num_procs);
+
+    for (int i = 0; i < max_i; i++)
+    {
+        for (int j = 0; j < num_procs; j++)
+        {
+            sendcounts[j] = (rank + 2*j + i) % max_s;
+            recvcounts[j] = (j + 2*rank + i) % max_s;
+            displs[j] = j * block_ints * sizeof(int);
+            sendtypes[j] = types[(rank + j + i) % 3];
+            recvtypes[j] = types[(rank + 2*j) % 3];
+        }
+        for (int j = 0; j < block_ints*num_procs; j++)
+            local_data[j] = rank*10000 + j;
+
+        std::fill(std_alltoallw.begin(), std_alltoallw.end(), -1);
+        PMPI_Alltoallw(local_data.data(), sendcounts.data(), displs.data(), sendtypes.data(),
+                std_alltoallw.data(), recvcounts.data(), displs.data(), recvtypes.data(),
+                MPI_COMM_WORLD);
+
+        std::fill(new_alltoallw.begin(), new_alltoallw.end(), -1);
+        alltoallw_pairwise(local_data.data(), sendcounts.data(), displs.data(), sendtypes.data(),
+                new_alltoallw.data(), recvcounts.data(), displs.data(), recvtypes.data(),
+                MPI_COMM_WORLD);
+        for (int j = 0; j < block_ints*num_procs; j++)
+            ASSERT_EQ(std_alltoallw[j], new_alltoallw[j]);
+
+        std::fill(new_alltoallw.begin(), new_alltoallw.end(), -1);
+        alltoallw_nonblocking(local_data.data(), sendcounts.data(), displs.data(), sendtypes.data(),
+                new_alltoallw.data(), recvcounts.data(), displs.data(), recvtypes.data(),
+                MPI_COMM_WORLD);
+        for (int j = 0; j < block_ints*num_procs; j++)
+            ASSERT_EQ(std_alltoallw[j], new_alltoallw[j]);
+
+        std::fill(new_alltoallw.begin(), new_alltoallw.end(), -1);
+        MPIX_Alltoallw(local_data.data(), sendcounts.data(), displs.data(), sendtypes.data(),
+                new_alltoallw.data(), recvcounts.data(), displs.data(), recvtypes.data(),
+                locality_comm);
+        for (int j = 0; j < block_ints*num_procs; j++)
+            ASSERT_EQ(std_alltoallw[j], new_alltoallw[j]);
+
+        std::fill(new_alltoallw.begin(), new_alltoallw.end(), -1);
+        alltoallw_pairwise_loc(local_data.data(), sendcounts.data(), displs.data(), sendtypes.data(),
+                new_alltoallw.data(), recvcounts.data(), displs.data(), recvtypes.data(),
+                leader_comm);
+        for (int j = 0; j < block_ints*num_procs; j++)
+            ASSERT_EQ(std_alltoallw[j], new_alltoallw[j]);
+
+        // In place : counts and types are symmetric
+        for (int j = 0; j < num_procs; j++)
+        {
+            recvcounts[j] = (rank + j + i) % max_s;
+            recvtypes[j] = types[(rank + j) % 3];
+        }
+        std::copy(local_data.begin(), local_data.end(), std_alltoallw.begin());
+        PMPI_Alltoallw(MPI_IN_PLACE, NULL, NULL, NULL,
+                std_alltoallw.data(), recvcounts.data(), displs.data(), recvtypes.data(),
+                MPI_COMM_WORLD);
+
+        std::copy(local_data.begin(), local_data.end(), new_alltoallw.begin());
+        MPIX_Alltoallw(MPI_IN_PLACE, NULL, NULL, NULL,
+                new_alltoallw.data(), recvcounts.data(), displs.data(), recvtypes.data(),
+                locality_comm);
+        for (int j = 0; j < block_ints*num_procs; j++)
+            ASSERT_EQ(std_alltoallw[j], new_alltoallw[j]);
+
+        std::copy(local_data.begin(), local_data.end(), new_alltoallw.begin());
+        alltoallw_pairwise(MPI_IN_PLACE, NULL, NULL, NULL,
+                new_alltoallw.data(), recvcounts.data(), displs.data(), recvtypes.data(),
+                MPI_COMM_WORLD);
+        for (int j = 0; j < block_ints*num_procs; j++)
+            ASSERT_EQ(std_alltoallw[j], new_alltoallw[j]);
+    }
+
+    MPI_Type_free(&(types[1]));
+    MPI_Type_free(&(types[2]));
+    MPIX_Info_free(&xinfo);
+    MPIX_Comm_free(&leader_comm);
+    MPIX_Comm_free(&locality_comm);
+}
@@ -0,0 +1,221 @@
+#include "tuning.h"
+#include <string.h>
+#include <math.h>
+
+const char* alltoall_method_names[ALLTOALL_NUM_METHODS] = {
+    "pairwise",
+    "nonblocking",
+    "bruck",
+    "pairwise_loc",
+    "nonblocking_loc",
+    "bruck_loc",
+    "pipelined_loc",
+    "nonblocking_window",
+    "threaded"
+};
+
+const char* alltoallv_method_names[ALLTOALLV_NUM_METHODS] = {
+    "pairwise",
+    "nonblocking",
+    "pairwise_nonblocking",
+    "waitany",
+    "pairwise_log2",
+    "pairwise_nonblocking_log2",
+    "sparse",
+    "bruck",
+    "pairwise_loc",
+    "hybrid_loc",
+    "bruck_loc",
+    "threaded"
+};
+
+static const char* tuned_collective_names[TUNED_NUM_COLLECTIVES] = {
+    "alltoall",
+    "alltoallv"
+};
+
+static int find_name(const char* name, const char** names, int n_names)
+{
+    for (int i = 0; i < n_names; i++)
+        if (strcmp(name, names[i]) == 0)
+            return i;
+    return -1;
+}
+
+// Parse tuning file on a single process
+// Each entry : collective, ppn, num_nodes, max_bytes, method
+static int read_tuning_file(const char* filename, int** entries_ptr)
+{
+    FILE* f = fopen(filename, "r");
+    if (f == NULL)
+    {
+        fprintf(stderr, "Could not open tuning file %s\n", filename);
+        *entries_ptr = NULL;
+        return 0;
+    }
+
+    int n_entries = 0;
+    int capacity = 16;
+    int* entries = (int*)malloc(5*capacity*sizeof(int));
+
+    char line[256];
+    char coll_name[64], method_name[64];
+    int ppn, num_nodes, max_bytes;
+    while (fgets(line, sizeof(line), f))
+    {
+        if (line[0] == '#')
+            continue;
+        if (sscanf(line, "%63s %d %d %d %63s", coll_name, &ppn,
+                    &num_nodes, &max_bytes, method_name) != 5)
+            continue;
+
+        int coll = find_name(coll_name, tuned_collective_names, TUNED_NUM_COLLECTIVES);
+        int method = -1;
+        if (coll == TUNED_ALLTOALL)
+            method = find_name(method_name, alltoall_method_names, ALLTOALL_NUM_METHODS);
+        else if (coll == TUNED_ALLTOALLV)
+            method = find_name(method_name, alltoallv_method_names, ALLTOALLV_NUM_METHODS);
+        if (method < 0 || ppn <= 0 || num_nodes <= 0)
+        {
+            fprintf(stderr, "Skipping tuning entry : %s", line);
+            continue;
+        }
+
+        if (n_entries == capacity)
+        {
+            capacity *= 2;
+            entries = (int*)realloc(entries, 5*capacity*sizeof(int));
+        }
+        entries[5*n_entries] = coll;
+        entries[5*n_entries+1] = ppn;
+        entries[5*n_entries+2] = num_nodes;
+        entries[5*n_entries+3] = max_bytes;
+        entries[5*n_entries+4] = method;
+        n_entries++;
+    }
+    fclose(f);
+
+    *entries_ptr = entries;
+    return n_entries;
+}
+
+int MPIX_Comm_tuning_init(MPIX_Comm* xcomm, MPIX_Info* xinfo)
+{
+    int rank, num_procs;
+    MPI_Comm_rank(xcomm->global_comm, &rank);
+    MPI_Comm_size(xcomm->global_comm, &num_procs);
+
+    MPIX_Comm_tuning_free(xcomm);
+    xcomm->n_tuning_entries = 0;
+
+    const char* filename = NULL;
+    if (xinfo != NULL)
+        filename = xinfo->tuning_file;
+    if (filename == NULL)
+        filename = getenv("MPIX_TUNING_FILE");
+    if (filename == NULL)
+        return MPI_SUCCESS;
+
+    // Rank 0 reads table, so all processes select the same methods
+    int n_entries = 0;
+    int* entries = NULL;
+    if (rank == 0)
+        n_entries = read_tuning_file(filename, &entries);
+    MPI_Bcast(&n_entries, 1, MPI_INT, 0, xcomm->global_comm);
+    if (n_entries == 0)
+    {
+        free(entries);
+        return MPI_SUCCESS;
+    }
+    if (rank != 0)
+        entries = (int*)malloc(5*n_entries*sizeof(int));
+    MPI_Bcast(entries, 5*n_entries, MPI_INT, 0, xcomm->global_comm);
+
+    if (xcomm->local_comm == MPI_COMM_NULL)
+        MPIX_Comm_topo_init(xcomm);
+    int ppn = xcomm->ppn;
+    MPI_Allreduce(MPI_IN_PLACE, &ppn, 1, MPI_INT, MPI_MAX, xcomm->global_comm);
+    int num_nodes = ((num_procs - 1) / ppn) + 1;
+
+    // Find closest (ppn, num_nodes) in table for each collective
+    double min_dist[TUNED_NUM_COLLECTIVES];
+    for (int i = 0; i < TUNED_NUM_COLLECTIVES; i++)
+        min_dist[i] = -1;
+    double* dist = (double*)malloc(n_entries*sizeof(double));
+    for (int i = 0; i < n_entries; i++)
+    {
+        int coll = entries[5*i];
+        dist[i] = fabs(log2((double)(entries[5*i+1]) / ppn))
+                + fabs(log2((double)(entries[5*i+2]) / num_nodes));
+        if (min_dist[coll] < 0 || dist[i] < min_dist[coll])
+            min_dist[coll] = dist[i];
+    }
+
+    // Keep (collective, max_bytes, method) of closest entries
+    xcomm->tuning_table = (int*)malloc(3*n_entries*sizeof(int));
+    for (int i = 0; i < n_entries; i++)
+    {
+        int coll = entries[5*i];
+        if (dist[i] > min_dist[coll] + 1e-10)
+            continue;
+        int idx = 3*xcomm->n_tuning_entries;
+        xcomm->tuning_table[idx] = coll;
+        xcomm->tuning_table[idx+1] = entries[5*i+3];
+        xcomm->tuning_table[idx+2] = entries[5*i+4];
+        xcomm->n_tuning_entries++;
+    }
+
+    free(dist);
+    free(entries);
+
+    return MPI_SUCCESS;
+}
+
+int MPIX_Comm_tuning_free(MPIX_Comm* xcomm)
+{
+    if (xcomm->tuning_table != NULL)
+        free(xcomm->tuning_table);
+    xcomm->tuning_table = NULL;
+    xcomm->n_tuning_entries = -1;
+
+    return MPI_SUCCESS;
+}
+
+static int select_method(MPIX_Comm* xcomm, int coll, int bytes, int default_method)
+{
+    if (xcomm->n_tuning_entries < 0)
+        MPIX_Comm_tuning_init(xcomm, NULL);
+
+    int method = default_method;
+    int best_bytes = -1;
+    int largest_bytes = -1;
+    for (int i = 0; i < xcomm->n_tuning_entries; i++)
+    {
+        if (xcomm->tuning_table[3*i] != coll)
+            continue;
+
+        int max_bytes = xcomm->tuning_table[3*i+1];
+        if (max_bytes >= bytes && (best_bytes < 0 || max_bytes < best_bytes))
+        {
+            best_bytes = max_bytes;
+            method = xcomm->tuning_table[3*i+2];
+        }
+        else if (best_bytes < 0 && max_bytes > largest_bytes)
+        {
+            largest_bytes = max_bytes;
+            method = xcomm->tuning_table[3*i+2];
+        }
+    }
+
+    return method;
+}
+
+int select_alltoall_method(MPIX_Comm* xcomm, int bytes)
+{
+    return select_method(xcomm, TUNED_ALLTOALL, bytes, ALLTOALL_PAIRWISE_LOC);
+}
+
+int select_alltoallv_method(MPIX_Comm* xcomm, int bytes)
+{
+    return select_method(xcomm, TUNED_ALLTOALLV, bytes, ALLTOALLV_PAIRWISE_LOC);
+}
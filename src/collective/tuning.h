@@ -0,0 +1,89 @@
+#ifndef MPI_ADVANCE_TUNING_H
+#define MPI_ADVANCE_TUNING_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <mpi.h>
+#include "utils/utils.h"
+#include "locality/topology.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**************************************************
+ * Tuning-Table Algorithm Selection
+ *  - Table is a text file, one entry per line
+ *      ('#' starts a comment) :
+ *      <collective> <ppn> <num_nodes> <max_bytes> <algorithm>
+ *      e.g. alltoall 32 16 1024 bruck_loc
+ *  - max_bytes : largest message size (bytes per process
+ *      pair, average for alltoallv) for which algorithm
+ *      is used
+ *  - Only entries whose (ppn, num_nodes) are closest to
+ *      those of the communicator are kept
+ *  - The entry with the smallest max_bytes >= message size
+ *      is selected (largest max_bytes if none)
+ *  - Without a table, MPIX_Alltoall and MPIX_Alltoallv
+ *      use pairwise_loc
+ *************************************************/
+
+// Algorithms available to MPIX_Alltoall
+enum AlltoallMethod
+{
+    ALLTOALL_PAIRWISE,
+    ALLTOALL_NONBLOCKING,
+    ALLTOALL_BRUCK,
+    ALLTOALL_PAIRWISE_LOC,
+    ALLTOALL_NONBLOCKING_LOC,
+    ALLTOALL_BRUCK_LOC,
+    ALLTOALL_PIPELINED_LOC,
+    ALLTOALL_NONBLOCKING_WINDOW,
+    ALLTOALL_THREADED,
+    ALLTOALL_NUM_METHODS
+};
+
+// Algorithms available to MPIX_Alltoallv
+enum AlltoallvMethod
+{
+    ALLTOALLV_PAIRWISE,
+    ALLTOALLV_NONBLOCKING,
+    ALLTOALLV_PAIRWISE_NONBLOCKING,
+    ALLTOALLV_WAITANY,
+    ALLTOALLV_PAIRWISE_LOG2,
+    ALLTOALLV_PAIRWISE_NONBLOCKING_LOG2,
+    ALLTOALLV_SPARSE,
+    ALLTOALLV_BRUCK,
+    ALLTOALLV_PAIRWISE_LOC,
+    ALLTOALLV_HYBRID_LOC,
+    ALLTOALLV_BRUCK_LOC,
+    ALLTOALLV_THREADED,
+    ALLTOALLV_NUM_METHODS
+};
+
+// Collectives in tuning table
+enum TunedCollective
+{
+    TUNED_ALLTOALL,
+    TUNED_ALLTOALLV,
+    TUNED_NUM_COLLECTIVES
+};
+
+extern const char* alltoall_method_names[ALLTOALL_NUM_METHODS];
+extern const char* alltoallv_method_names[ALLTOALLV_NUM_METHODS];
+
+// Load tuning table from xinfo->tuning_file (or MPIX_TUNING_FILE
+// if xinfo is NULL or has no file).  Collective over global_comm.
+int MPIX_Comm_tuning_init(MPIX_Comm* xcomm, MPIX_Info* xinfo);
+int MPIX_Comm_tuning_free(MPIX_Comm* xcomm);
+
+// Returns method for message of 'bytes' per process pair
+int select_alltoall_method(MPIX_Comm* xcomm, int bytes);
+int select_alltoallv_method(MPIX_Comm* xcomm, int bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
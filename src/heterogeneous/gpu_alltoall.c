@@ -72,8 +72,8 @@ int copy_to_cpu_alltoall(alltoall_ftn f,
     MPI_Type_size(sendtype, &send_bytes);
     MPI_Type_size(recvtype, &recv_bytes);
 
-    int total_bytes_s = sendcount * send_bytes * num_procs;
-    int total_bytes_r = recvcount * recv_bytes * num_procs;
+    size_t total_bytes_s = (size_t)sendcount * send_bytes * num_procs;
+    size_t total_bytes_r = (size_t)recvcount * recv_bytes * num_procs;
 
     char* cpu_sendbuf;
     char* cpu_recvbuf;
@@ -93,8 +93,8 @@ int copy_to_cpu_alltoall_init(alltoall_init_ftn f,
     MPI_Type_size(sendtype, &send_bytes);
     MPI_Type_size(recvtype, &recv_bytes);
     
-    int total_bytes_s = sendcount * send_bytes * num_procs;
-    int total_bytes_r = recvcount * recv_bytes * num_procs;
+    size_t total_bytes_s = (size_t)sendcount * send_bytes * num_procs;
+    size_t total_bytes_r = (size_t)recvcount * recv_bytes * num_procs;
 
     gpuMallocHost((void**)&(request->cpu_sendbuf), total_bytes_s);
     gpuMallocHost((void**)&(request->cpu_recvbuf), total_bytes_r);
@@ -198,8 +198,8 @@ int threaded_alltoall_pairwise(const void* sendbuf,
     MPI_Type_size(sendtype, &send_bytes);
     MPI_Type_size(recvtype, &recv_bytes);
     
-    int total_bytes_s = sendcount * send_bytes * num_procs;
-    int total_bytes_r = recvcount * recv_bytes * num_procs;
+    size_t total_bytes_s = (size_t)sendcount * send_bytes * num_procs;
+    size_t total_bytes_r = (size_t)recvcount * recv_bytes * num_procs;
     
     char* cpu_sendbuf;
     char* cpu_recvbuf;
@@ -209,16 +209,16 @@ int threaded_alltoall_pairwise(const void* sendbuf,
     // Copy from GPU to CPU
     ierr += gpuMemcpy(cpu_sendbuf, sendbuf, total_bytes_s, gpuMemcpyDeviceToHost);
 
-    memcpy(cpu_recvbuf + (rank * recvcount * recv_bytes),
-        cpu_sendbuf + (rank * sendcount * send_bytes),
-        sendcount * send_bytes);
+    memcpy(cpu_recvbuf + ((MPI_Aint)rank * recvcount * recv_bytes),
+        cpu_sendbuf + ((MPI_Aint)rank * sendcount * send_bytes),
+        (size_t)sendcount * send_bytes);
 
 #pragma omp parallel shared(cpu_sendbuf, cpu_recvbuf)
 {
     MPI_Status status;
     int tag = 102944;
     int send_proc, recv_proc;
-    int send_pos, recv_pos;
+    MPI_Aint send_pos, recv_pos;
 
     int n_msgs = num_procs - 1;
     int thread_id = omp_get_thread_num();
@@ -241,8 +241,8 @@ int threaded_alltoall_pairwise(const void* sendbuf,
             recv_proc = rank - idx;
             if (recv_proc < 0)
                 recv_proc += num_procs;
-            send_pos = send_proc * sendcount * send_bytes;
-            recv_pos = recv_proc * recvcount * recv_bytes;
+            send_pos = (MPI_Aint)send_proc * sendcount * send_bytes;
+            recv_pos = (MPI_Aint)recv_proc * recvcount * recv_bytes;
 
             MPI_Sendrecv(cpu_sendbuf + send_pos,
                     sendcount,
@@ -286,8 +286,8 @@ int threaded_alltoall_nonblocking(const void* sendbuf,
     MPI_Type_size(sendtype, &send_bytes);
     MPI_Type_size(recvtype, &recv_bytes);
    
-    int total_bytes_s = sendcount * send_bytes * num_procs;
-    int total_bytes_r = recvcount * recv_bytes * num_procs;
+    size_t total_bytes_s = (size_t)sendcount * send_bytes * num_procs;
+    size_t total_bytes_r = (size_t)recvcount * recv_bytes * num_procs;
 
     char* cpu_sendbuf;
     char* cpu_recvbuf;
@@ -297,15 +297,15 @@ int threaded_alltoall_nonblocking(const void* sendbuf,
     int ierr = 0;
     ierr += gpuMemcpy(cpu_sendbuf, sendbuf, total_bytes_s, gpuMemcpyDeviceToHost);
 
-    memcpy(cpu_recvbuf + (rank * recvcount * recv_bytes),
-        cpu_sendbuf + (rank * sendcount * send_bytes),
-        sendcount * send_bytes);
+    memcpy(cpu_recvbuf + ((MPI_Aint)rank * recvcount * recv_bytes),
+        cpu_sendbuf + ((MPI_Aint)rank * sendcount * send_bytes),
+        (size_t)sendcount * send_bytes);
 
 #pragma omp parallel shared(cpu_sendbuf, cpu_recvbuf)
 {
     int tag = 102944;
     int send_proc, recv_proc;
-    int send_pos, recv_pos;
+    MPI_Aint send_pos, recv_pos;
 
     int n_msgs = num_procs - 1;
     int thread_id = omp_get_thread_num();
@@ -330,8 +330,8 @@ int threaded_alltoall_nonblocking(const void* sendbuf,
             recv_proc = rank - idx;
             if (recv_proc < 0)
                 recv_proc += num_procs;
-            send_pos = send_proc * sendcount * send_bytes;
-            recv_pos = recv_proc * recvcount * recv_bytes;
+            send_pos = (MPI_Aint)send_proc * sendcount * send_bytes;
+            recv_pos = (MPI_Aint)recv_proc * recvcount * recv_bytes;
 
             MPI_Isend(cpu_sendbuf + send_pos,
                     sendcount,
@@ -84,16 +84,16 @@ int copy_to_cpu_alltoallv(alltoallv_ftn f,
     MPI_Type_size(sendtype, &send_bytes);
     MPI_Type_size(recvtype, &recv_bytes);
 
-    int sendcount = 0;
-    int recvcount = 0;
+    long sendcount = 0;
+    long recvcount = 0;
     for (int i = 0; i < num_procs; i++)
     {
         sendcount += sendcounts[i];
         recvcount += recvcounts[i];
     }
 
-    int total_bytes_s = sendcount * send_bytes;
-    int total_bytes_r = recvcount * recv_bytes;
+    size_t total_bytes_s = (size_t)sendcount * send_bytes;
+    size_t total_bytes_r = (size_t)recvcount * recv_bytes;
 
     char* cpu_sendbuf;
     char* cpu_recvbuf;
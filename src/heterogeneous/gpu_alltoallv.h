@@ -9,9 +9,6 @@ extern "C"
 {
 #endif
 
-typedef int (*alltoallv_ftn)(const void*, const int*, const int*, MPI_Datatype, 
-void*, const int*, const int*, MPI_Datatype, MPI_Comm);
-
 
 int gpu_aware_alltoallv(alltoallv_ftn f,
         const void* sendbuf,
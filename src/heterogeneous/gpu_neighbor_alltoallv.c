@@ -94,16 +94,16 @@ int copy_to_cpu_alltoallv(alltoallv_ftn f,
     MPI_Type_size(sendtype, &send_bytes);
     MPI_Type_size(recvtype, &recv_bytes);
 
-    int sendcount = 0;
-    int recvcount = 0;
+    long sendcount = 0;
+    long recvcount = 0;
     for (int i = 0; i < num_procs; i++)
     {
         sendcount += sendcounts[i];
         recvcount += recvcounts[i];
     }
 
-    int total_bytes_s = sendcount * send_bytes;
-    int total_bytes_r = recvcount * recv_bytes;
+    size_t total_bytes_s = (size_t)sendcount * send_bytes;
+    size_t total_bytes_r = (size_t)recvcount * recv_bytes;
 
     char* cpu_sendbuf;
     char* cpu_recvbuf;
@@ -191,16 +191,16 @@ int threaded_alltoallv_pairwise(const void* sendbuf,
     MPI_Type_size(sendtype, &send_bytes);
     MPI_Type_size(recvtype, &recv_bytes);
 
-    int sendcount = 0;
-    int recvcount = 0;
+    long sendcount = 0;
+    long recvcount = 0;
     for (int i = 0; i < num_procs; i++)
     {
         sendcount += sendcounts[i];
         recvcount += recvcounts[i];
     }
 
-    int total_bytes_s = sendcount * send_bytes;
-    int total_bytes_r = recvcount * recv_bytes;
+    size_t total_bytes_s = (size_t)sendcount * send_bytes;
+    size_t total_bytes_r = (size_t)recvcount * recv_bytes;
 
     char* cpu_sendbuf;
     char* cpu_recvbuf;
@@ -210,9 +210,9 @@ int threaded_alltoallv_pairwise(const void* sendbuf,
     // Copy from GPU to CPU
     ierr += gpuMemcpy(cpu_sendbuf, sendbuf, total_bytes_s, gpuMemcpyDeviceToHost);
 
-    memcpy(cpu_recvbuf + (rdispls[rank] * recv_bytes),
-        cpu_sendbuf + (sdispls[rank] * send_bytes),
-        sendcounts[rank] * send_bytes);
+    memcpy(cpu_recvbuf + ((MPI_Aint)rdispls[rank] * recv_bytes),
+        cpu_sendbuf + ((MPI_Aint)sdispls[rank] * send_bytes),
+        (size_t)sendcounts[rank] * send_bytes);
  
 /*
     int* ordered_sends = (int*)malloc(num_procs*sizeof(int));
@@ -225,7 +225,7 @@ int threaded_alltoallv_pairwise(const void* sendbuf,
     MPI_Status status;
     int tag = 102944;
     int send_proc, recv_proc;
-    int send_pos, recv_pos;
+    MPI_Aint send_pos, recv_pos;
 
     int n_msgs = num_procs - 1;
     int thread_id = omp_get_thread_num();
@@ -248,8 +248,8 @@ int threaded_alltoallv_pairwise(const void* sendbuf,
             recv_proc = rank - idx;
             if (recv_proc < 0)
                 recv_proc += num_procs;
-            send_pos = sdispls[send_proc] * send_bytes;
-            recv_pos = rdispls[recv_proc] * recv_bytes;
+            send_pos = (MPI_Aint)sdispls[send_proc] * send_bytes;
+            recv_pos = (MPI_Aint)rdispls[recv_proc] * recv_bytes;
 
             MPI_Sendrecv(cpu_sendbuf + send_pos,
                     sendcounts[send_proc],
@@ -302,16 +302,16 @@ int threaded_alltoallv_nonblocking(const void* sendbuf,
     MPI_Type_size(sendtype, &send_bytes);
     MPI_Type_size(recvtype, &recv_bytes);
 
-    int sendcount = 0;
-    int recvcount = 0;
+    long sendcount = 0;
+    long recvcount = 0;
     for (int i = 0; i < num_procs; i++)
     {
         sendcount += sendcounts[i];
         recvcount += recvcounts[i];
     }
 
-    int total_bytes_s = sendcount * send_bytes;
-    int total_bytes_r = recvcount * recv_bytes;
+    size_t total_bytes_s = (size_t)sendcount * send_bytes;
+    size_t total_bytes_r = (size_t)recvcount * recv_bytes;
 
     char* cpu_sendbuf;
     char* cpu_recvbuf;
@@ -321,9 +321,9 @@ int threaded_alltoallv_nonblocking(const void* sendbuf,
     // Copy from GPU to CPU
     ierr += gpuMemcpy(cpu_sendbuf, sendbuf, total_bytes_s, gpuMemcpyDeviceToHost);
 
-    memcpy(cpu_recvbuf + (rdispls[rank] * recv_bytes),
-        cpu_sendbuf + (sdispls[rank] * send_bytes),
-        sendcounts[rank] * send_bytes);
+    memcpy(cpu_recvbuf + ((MPI_Aint)rdispls[rank] * recv_bytes),
+        cpu_sendbuf + ((MPI_Aint)sdispls[rank] * send_bytes),
+        (size_t)sendcounts[rank] * send_bytes);
  
 /*
     int* ordered_sends = (int*)malloc(num_procs*sizeof(int));
@@ -335,7 +335,7 @@ int threaded_alltoallv_nonblocking(const void* sendbuf,
 {
     int tag = 102944;
     int send_proc, recv_proc;
-    int send_pos, recv_pos;
+    MPI_Aint send_pos, recv_pos;
 
     int n_msgs = num_procs - 1;
     int thread_id = omp_get_thread_num();
@@ -360,8 +360,8 @@ int threaded_alltoallv_nonblocking(const void* sendbuf,
             recv_proc = rank - idx;
             if (recv_proc < 0)
                 recv_proc += num_procs;
-            send_pos = sdispls[send_proc] * send_bytes;
-            recv_pos = rdispls[recv_proc] * recv_bytes;
+            send_pos = (MPI_Aint)sdispls[send_proc] * send_bytes;
+            recv_pos = (MPI_Aint)rdispls[recv_proc] * recv_bytes;
 
             MPI_Isend(cpu_sendbuf + send_pos,
                     sendcounts[send_proc],
@@ -12,6 +12,11 @@ void init_locality_comm(LocalityComm** locality_ptr, const MPIX_Comm* mpix_comm,
 
     locality->communicators = mpix_comm;
 
+    locality->global_to_R_ptr = NULL;
+    locality->global_to_R_pos = NULL;
+
+    locality->shm = NULL;
+
     *locality_ptr = locality;
 }
 
@@ -30,9 +35,34 @@ void destroy_locality_comm(LocalityComm* locality)
     destroy_comm_pkg(locality->local_R_comm);
     destroy_comm_pkg(locality->global_comm);
 
+    free(locality->global_to_R_ptr);
+    free(locality->global_to_R_pos);
+
+    if (locality->shm)
+        destroy_locality_shm(locality->shm);
+
     free(locality);
 }
 
+// Collective over local_comm (frees the shared window)
+void destroy_locality_shm(LocalityShm* shm)
+{
+    MPI_Win_unlock_all(shm->win);
+    MPI_Win_free(&(shm->win));
+
+    free(shm->flags);
+    free(shm->L_src);
+    free(shm->R_src);
+    free(shm->G_src);
+    free(shm->R_slice_ptr);
+    free(shm->R_slice_start);
+    free(shm->R_slice_count);
+    free(shm->R_slice_msg);
+    free(shm->R_slice_epoch);
+    free(shm->R_idx);
+    free(shm);
+}
+
 void get_local_comm_data(LocalityComm* locality,
        int* max_local_num, 
        int* max_local_size,
@@ -13,6 +13,51 @@ extern "C"
 #endif
     
 
+// Node-shared segments of one locality-aware request (see
+// init_neighbor_shm).  Each local rank packs its on-node sends
+// into its own segment and raises a ready flag, and destinations
+// unpack straight from the sender's segment, then acknowledge.
+// Flags hold the epoch (start count) of the request, so no phase
+// needs a barrier
+typedef struct _LocalityShm
+{
+    MPI_Win win;
+    MPI_Comm local_comm;
+    int epoch;
+    volatile int** flags; // flags of each local rank
+    char* L_data; // my segment : local_L, local_S, local_R sends
+    char* S_data;
+    char* R_data;
+
+    // My local_R sends are forwarded from global messages, and
+    // flagged per global message.  Values of each destination are
+    // stored by global message (R_slot : slot of each value)
+    int* R_slot;
+
+    // Source of each local_L and local_R recv message, and of each
+    // value of the global send buffer (in local_S senders' segments)
+    char** L_src;
+    char** R_src;
+    char** G_src;
+
+    // Slices of local_R recv messages, one per global message of the
+    // sender (CSR by recv message) : first slot, count, sender's
+    // global message, and epoch unpacked.  R_idx holds local_R recv
+    // indices in slot order
+    int* R_slice_ptr;
+    int* R_slice_start;
+    int* R_slice_count;
+    int* R_slice_msg;
+    int* R_slice_epoch;
+    int* R_idx;
+    int R_n_read;
+
+    // Progress of the current epoch
+    int L_read;
+    int R_read;
+    int R_posted;
+} LocalityShm;
+
 typedef struct _LocalityComm
 {
     CommPkg* local_L_comm;
@@ -21,12 +66,23 @@ typedef struct _LocalityComm
     CommPkg* global_comm;
     
     const MPIX_Comm* communicators;
+
+    // Dataflow dependencies (CSR, built by init_locality, NULL if not
+    // formed) : positions in local_R_comm->send_data of the values
+    // taken from each global recv message, forwarded as soon as that
+    // message arrives
+    int* global_to_R_ptr;
+    int* global_to_R_pos;
+
+    // Node-shared segments (NULL unless on-node phases use them)
+    LocalityShm* shm;
 } LocalityComm;
 
 void init_locality_comm(LocalityComm** locality_ptr, const MPIX_Comm* comm,
         MPI_Datatype sendtype, MPI_Datatype recvtype);
 void finalize_locality_comm(LocalityComm* locality);
 void destroy_locality_comm(LocalityComm* locality);
+void destroy_locality_shm(LocalityShm* shm);
 
 void get_local_comm_data(LocalityComm* locality,
        int* max_local_num, 
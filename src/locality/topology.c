@@ -12,15 +12,39 @@ int MPIX_Comm_init(MPIX_Comm** xcomm_ptr, MPI_Comm global_comm)
     xcomm->local_comm = MPI_COMM_NULL;
     xcomm->group_comm = MPI_COMM_NULL;
 
+    xcomm->leader_comm = MPI_COMM_NULL;
+    xcomm->leader_group_comm = MPI_COMM_NULL;
+    xcomm->leaders_per_node = 1;
+    xcomm->local_uniform = 0;
+    xcomm->leader_uniform = 0;
+
     xcomm->neighbor_comm = MPI_COMM_NULL;
 
     xcomm->win = MPI_WIN_NULL;
     xcomm->win_array = NULL;
     xcomm->win_bytes = 0;
 
+    xcomm->shm_win = MPI_WIN_NULL;
+    xcomm->shm_array = NULL;
+    xcomm->shm_bytes = 0;
+
     xcomm->requests = NULL;
     xcomm->n_requests = 0;
 
+    xcomm->tuning_table = NULL;
+    xcomm->n_tuning_entries = -1;
+
+    xcomm->pipeline_bytes = 65536;
+    xcomm->window_size = 32;
+    xcomm->aggregation_bytes = 4096;
+    xcomm->sparse_percent = 10;
+    xcomm->peer_schedule = PEER_SCHEDULE_SHIFT;
+    MPIX_Window_init(&(xcomm->nb_window), 5, 0);
+    xcomm->nb_tag = 0;
+
+    xcomm->send_schedule = NULL;
+    xcomm->recv_schedule = NULL;
+
 #ifdef GPU
     xcomm->gpus_per_node = 0;
 #endif
@@ -31,6 +55,27 @@ int MPIX_Comm_init(MPIX_Comm** xcomm_ptr, MPI_Comm global_comm)
 }
 
 
+// Checks a split of global_comm into local groups (local_comm, with
+// group_comm joining equal local ranks), once : every process must
+// agree on the local size, it must divide num_procs, and rank must
+// be group rank * local size + local rank (SMP order)
+static int uniform_split(MPI_Comm global_comm, MPI_Comm local_comm,
+        MPI_Comm group_comm)
+{
+    int rank, num_procs, local_rank, ppn, rank_node;
+    MPI_Comm_rank(global_comm, &rank);
+    MPI_Comm_size(global_comm, &num_procs);
+    MPI_Comm_rank(local_comm, &local_rank);
+    MPI_Comm_size(local_comm, &ppn);
+    MPI_Comm_rank(group_comm, &rank_node);
+
+    // min and max of ppn are equal, and every process in SMP order
+    int ppn_range[3] = {ppn, -ppn, rank == rank_node * ppn + local_rank};
+    MPI_Allreduce(MPI_IN_PLACE, ppn_range, 3, MPI_INT, MPI_MIN, global_comm);
+
+    return ppn_range[0] == -ppn_range[1] && ppn_range[2] && num_procs % ppn == 0;
+}
+
 int MPIX_Comm_topo_init(MPIX_Comm* xcomm)
 {
     int rank, num_procs;
@@ -55,6 +100,9 @@ int MPIX_Comm_topo_init(MPIX_Comm* xcomm)
             rank,
             &(xcomm->group_comm));
 
+    xcomm->local_uniform = uniform_split(xcomm->global_comm,
+            xcomm->local_comm, xcomm->group_comm);
+
     return MPI_SUCCESS;
 }
 
@@ -79,6 +127,453 @@ int MPIX_Comm_device_init(MPIX_Comm* xcomm)
     return MPI_SUCCESS;
 }
 
+// Copy collective algorithm parameters from xinfo
+int MPIX_Comm_info_init(MPIX_Comm* xcomm, MPIX_Info* xinfo)
+{
+    xcomm->pipeline_bytes = xinfo->pipeline_bytes;
+    xcomm->window_size = xinfo->window_size;
+    xcomm->aggregation_bytes = xinfo->aggregation_bytes;
+    xcomm->sparse_percent = xinfo->sparse_percent;
+    MPIX_Window_init(&(xcomm->nb_window), xinfo->nb_window, xinfo->adaptive_window);
+
+    if (xinfo->peer_schedule != xcomm->peer_schedule)
+        MPIX_Comm_schedule_free(xcomm);
+    xcomm->peer_schedule = xinfo->peer_schedule;
+
+    return MPI_SUCCESS;
+}
+
+/**************************************************
+ * In-Flight Window
+ *  - Fixed : size messages in flight each way
+ *  - Adaptive : after each batch of messages
+ *      completes, MPIX_Window_update compares its 
+ *      completion rate with that of the previous 
+ *      batch, doubling (or halving) size while the
+ *      rate improves and reversing direction once
+ *      it drops, within [1, max_size]
+ *  - Rates are only compared within a call (message
+ *      sizes differ between calls), while size and
+ *      direction carry over to the next call
+ *  - Windows are local : processes may use different
+ *      sizes, as every message of a step is posted
+ *      once both sides reach that step
+ *************************************************/
+void MPIX_Window_init(MPIX_Window* window, int size, int adaptive)
+{
+    window->size = size > 0 ? size : 1;
+    window->adaptive = adaptive;
+    window->direction = 1;
+    window->rate = 0;
+    window->n_calls = 0;
+    window->n_adjustments = 0;
+    window->last_min_size = window->size;
+    window->last_max_size = window->size;
+}
+
+// Start of a call using the window
+void MPIX_Window_start(MPIX_Window* window)
+{
+    window->rate = 0;
+    window->n_calls++;
+    window->last_min_size = window->size;
+    window->last_max_size = window->size;
+}
+
+// A batch of 'bytes' (sent and received) completed in 'time' seconds
+void MPIX_Window_update(MPIX_Window* window, long bytes, double time,
+        int max_size)
+{
+    if (!window->adaptive || time <= 0)
+        return;
+
+    double rate = bytes / time;
+    if (window->rate > 0 && rate < window->rate)
+        window->direction = -window->direction;
+    window->rate = rate;
+
+    int size = window->direction > 0 ? 2*window->size : window->size / 2;
+    if (size > max_size)
+        size = max_size;
+    if (size < 1)
+        size = 1;
+
+    // At a bound : turn back on the next update
+    if (size == window->size)
+    {
+        window->direction = -window->direction;
+        return;
+    }
+
+    window->size = size;
+    window->n_adjustments++;
+    if (size < window->last_min_size)
+        window->last_min_size = size;
+    if (size > window->last_max_size)
+        window->last_max_size = size;
+}
+
+// Per-request tag of nonblocking collectives (see topology.h)
+int MPIX_Comm_tag(MPIX_Comm* xcomm, int* tag)
+{
+    *tag = MPIX_NB_TAG_BASE + xcomm->nb_tag;
+    xcomm->nb_tag = (xcomm->nb_tag + 1) % MPIX_NB_TAG_RANGE;
+
+    return MPI_SUCCESS;
+}
+
+// Offset (in nodes) of destination at step (a, b) for local rank l
+// b == 0 : same local rank, offsets 1..num_nodes-1 staggered by l
+//      (a == 0 is self)
+// b > 0 : offsets 0..num_nodes-1 staggered by l
+static int node_offset(int a, int b, int l, int num_nodes)
+{
+    if (b == 0)
+        return (a == 0) ? 0 : ((a - 1 + l) % (num_nodes - 1)) + 1;
+    return (a + l) % num_nodes;
+}
+
+/**************************************************
+ * Pairwise Exchange Schedule
+ *  - At step i, sends to send_procs[i] and receives
+ *      from recv_procs[i] (step 0 is self).  Each 
+ *      step is a permutation, so a process receives
+ *      from every process that sends to it at that step
+ *  - PEER_SCHEDULE_SHIFT : rank + i / rank - i.  With
+ *      SMP ordering, all processes on a node send to
+ *      the same remote node at each step (incast)
+ *  - PEER_SCHEDULE_NODE_SHIFT : step i = a*ppn + b, 
+ *      local rank l of node n sends to local rank l + b
+ *      of node n + a + l, so the processes of a node 
+ *      target distinct nodes at each step
+ *  - PEER_SCHEDULE_NODE_XOR : same, but pairs node n 
+ *      with node n ^ (a + l), so node pairs exchange 
+ *      in both directions at once
+ *  - Node schedules require SMP ordering and equal 
+ *      ppn on every node (XOR also a power-of-two
+ *      number of nodes), otherwise fall back to
+ *      NODE_SHIFT / SHIFT
+ *  - Computed on first use (collective over 
+ *      global_comm) and cached on xcomm
+ *************************************************/
+int MPIX_Comm_peer_schedule(MPIX_Comm* xcomm, const int** send_procs,
+        const int** recv_procs)
+{
+    if (xcomm->send_schedule == NULL)
+    {
+        int rank, num_procs;
+        MPI_Comm_rank(xcomm->global_comm, &rank);
+        MPI_Comm_size(xcomm->global_comm, &num_procs);
+
+        int schedule = xcomm->peer_schedule;
+        int ppn = 1;
+        int num_nodes = num_procs;
+        if (schedule != PEER_SCHEDULE_SHIFT)
+        {
+            if (xcomm->local_comm == MPI_COMM_NULL)
+                MPIX_Comm_topo_init(xcomm);
+
+            int ppn_range[2] = {xcomm->ppn, -xcomm->ppn};
+            MPI_Allreduce(MPI_IN_PLACE, ppn_range, 2, MPI_INT, MPI_MIN, 
+                    xcomm->global_comm);
+            ppn = xcomm->ppn;
+            num_nodes = xcomm->num_nodes;
+            if (ppn_range[0] != -ppn_range[1] || num_nodes * ppn != num_procs)
+                schedule = PEER_SCHEDULE_SHIFT;
+            else if (schedule == PEER_SCHEDULE_NODE_XOR 
+                    && (num_nodes & (num_nodes - 1)))
+                schedule = PEER_SCHEDULE_NODE_SHIFT;
+        }
+
+        xcomm->send_schedule = (int*)malloc(num_procs*sizeof(int));
+        xcomm->recv_schedule = (int*)malloc(num_procs*sizeof(int));
+
+        if (schedule == PEER_SCHEDULE_SHIFT)
+        {
+            for (int i = 0; i < num_procs; i++)
+            {
+                xcomm->send_schedule[i] = (rank + i) % num_procs;
+                xcomm->recv_schedule[i] = (rank - i + num_procs) % num_procs;
+            }
+        }
+        else
+        {
+            int node = get_node(xcomm, rank);
+            int local = get_local_proc(xcomm, rank);
+            for (int i = 0; i < num_procs; i++)
+            {
+                int a = i / ppn;
+                int b = i % ppn;
+                int send_local = (local + b) % ppn;
+                int recv_local = (local - b + ppn) % ppn;
+                int send_offset = node_offset(a, b, local, num_nodes);
+                int recv_offset = node_offset(a, b, recv_local, num_nodes);
+
+                int send_node, recv_node;
+                if (schedule == PEER_SCHEDULE_NODE_XOR)
+                {
+                    send_node = node ^ send_offset;
+                    recv_node = node ^ recv_offset;
+                }
+                else
+                {
+                    send_node = (node + send_offset) % num_nodes;
+                    recv_node = (node - recv_offset + num_nodes) % num_nodes;
+                }
+                xcomm->send_schedule[i] = get_global_proc(xcomm, send_node, send_local);
+                xcomm->recv_schedule[i] = get_global_proc(xcomm, recv_node, recv_local);
+            }
+        }
+    }
+
+    *send_procs = xcomm->send_schedule;
+    *recv_procs = xcomm->recv_schedule;
+
+    return MPI_SUCCESS;
+}
+
+int MPIX_Comm_schedule_free(MPIX_Comm* xcomm)
+{
+    if (xcomm->send_schedule != NULL)
+        free(xcomm->send_schedule);
+    if (xcomm->recv_schedule != NULL)
+        free(xcomm->recv_schedule);
+    xcomm->send_schedule = NULL;
+    xcomm->recv_schedule = NULL;
+
+    return MPI_SUCCESS;
+}
+
+// Split each node into multiple aggregation groups, each with its own 
+// leader, so inter-node communication is spread across several processes
+//  - xinfo->leader_by_socket : one leader per socket (Open MPI only, 
+//      otherwise uses xinfo->leaders_per_node)
+//  - xinfo->leaders_per_node : evenly spaced leaders on each node
+int MPIX_Comm_leader_init(MPIX_Comm* xcomm, MPIX_Info* xinfo)
+{
+    if (xcomm->local_comm == MPI_COMM_NULL)
+        MPIX_Comm_topo_init(xcomm);
+
+    int rank, local_rank;
+    MPI_Comm_rank(xcomm->global_comm, &rank);
+    MPI_Comm_rank(xcomm->local_comm, &local_rank);
+
+#ifdef OPEN_MPI
+    if (xinfo->leader_by_socket)
+    {
+        MPIX_Comm_leader_free(xcomm);
+
+        MPI_Comm_split_type(xcomm->local_comm,
+                OMPI_COMM_TYPE_SOCKET,
+                local_rank,
+                MPI_INFO_NULL,
+                &(xcomm->leader_comm));
+
+        int leader_rank, leader_size;
+        MPI_Comm_rank(xcomm->leader_comm, &leader_rank);
+        MPI_Comm_size(xcomm->leader_comm, &leader_size);
+        xcomm->leaders_per_node = xcomm->ppn / leader_size;
+
+        MPI_Comm_split(xcomm->global_comm,
+                leader_rank,
+                rank,
+                &(xcomm->leader_group_comm));
+        xcomm->leader_uniform = uniform_split(xcomm->global_comm,
+                xcomm->leader_comm, xcomm->leader_group_comm);
+
+        return MPI_SUCCESS;
+    }
+#endif
+
+    int leaders_per_node = xinfo->leaders_per_node;
+    if (leaders_per_node < 1)
+        leaders_per_node = 1;
+    if (leaders_per_node > xcomm->ppn)
+        leaders_per_node = xcomm->ppn;
+
+    update_leaders(xcomm, (xcomm->ppn + leaders_per_node - 1) / leaders_per_node);
+
+    return MPI_SUCCESS;
+}
+
+// Node-shared memory for on-node exchanges
+// Each local rank owns a segment of the node window :
+//      [offset and size for each local rank][data]
+// Ranks write data for all local ranks into their own segment,
+// and each local rank copies its portion directly from its peers
+// Collective over local_comm : grows the window if any local rank
+// needs more than 'bytes' of data
+int MPIX_Comm_shm_init(MPIX_Comm* xcomm, int bytes)
+{
+    if (xcomm->local_comm == MPI_COMM_NULL)
+        MPIX_Comm_topo_init(xcomm);
+
+    int ppn;
+    MPI_Comm_size(xcomm->local_comm, &ppn);
+
+    int max_bytes = bytes;
+    MPI_Allreduce(MPI_IN_PLACE, &max_bytes, 1, MPI_INT, MPI_MAX, xcomm->local_comm);
+    if (xcomm->shm_win != MPI_WIN_NULL && max_bytes <= xcomm->shm_bytes)
+        return MPI_SUCCESS;
+
+    MPIX_Comm_shm_free(xcomm);
+
+    // Keep segments 8-byte aligned
+    xcomm->shm_bytes = ((max_bytes + 7) / 8) * 8;
+    if (xcomm->shm_bytes == 0)
+        xcomm->shm_bytes = 8;
+
+    char* local_array;
+    MPI_Aint seg_bytes = 2*ppn*sizeof(int) + xcomm->shm_bytes;
+    MPI_Win_allocate_shared(seg_bytes, 1, MPI_INFO_NULL, xcomm->local_comm,
+            &local_array, &(xcomm->shm_win));
+
+    // Segments are contiguous across the node, starting at local rank 0
+    MPI_Aint size;
+    int disp_unit;
+    MPI_Win_shared_query(xcomm->shm_win, 0, &size, &disp_unit, &(xcomm->shm_array));
+
+    // Passive target epoch for lifetime of window (synchronized with 
+    // MPI_Win_sync and barriers in post/read)
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, xcomm->shm_win);
+
+    return MPI_SUCCESS;
+}
+
+int MPIX_Comm_shm_free(MPIX_Comm* xcomm)
+{
+    if (xcomm->shm_win != MPI_WIN_NULL)
+    {
+        MPI_Win_unlock_all(xcomm->shm_win);
+        MPI_Win_free(&(xcomm->shm_win));
+    }
+    xcomm->shm_array = NULL;
+    xcomm->shm_bytes = 0;
+
+    return MPI_SUCCESS;
+}
+
+static char* shm_segment(const MPIX_Comm* xcomm, int local_proc, int ppn)
+{
+    long seg_bytes = 2*ppn*sizeof(int) + xcomm->shm_bytes;
+    return xcomm->shm_array + local_proc * seg_bytes;
+}
+
+// Data portion of my own segment : pack into this buffer directly and
+// pass it as sendbuf to MPIX_Comm_shm_post to avoid an extra copy
+char* MPIX_Comm_shm_buffer(const MPIX_Comm* xcomm)
+{
+    int local_rank, ppn;
+    MPI_Comm_rank(xcomm->local_comm, &local_rank);
+    MPI_Comm_size(xcomm->local_comm, &ppn);
+
+    return shm_segment(xcomm, local_rank, ppn) + 2*ppn*sizeof(int);
+}
+
+// Write send_sizes[i] bytes from sendbuf+send_displs[i] for each local
+// rank i into my segment, and synchronize with all local ranks
+int MPIX_Comm_shm_post(const MPIX_Comm* xcomm, const char* sendbuf,
+        const int* send_sizes, const int* send_displs)
+{
+    int local_rank, ppn;
+    MPI_Comm_rank(xcomm->local_comm, &local_rank);
+    MPI_Comm_size(xcomm->local_comm, &ppn);
+
+    char* segment = shm_segment(xcomm, local_rank, ppn);
+    int* header = (int*)segment;
+    char* data = segment + 2*ppn*sizeof(int);
+
+    if (sendbuf == data)
+    {
+        for (int i = 0; i < ppn; i++)
+        {
+            header[2*i] = send_displs[i];
+            header[2*i+1] = send_sizes[i];
+        }
+    }
+    else
+    {
+        int pos = 0;
+        for (int i = 0; i < ppn; i++)
+        {
+            header[2*i] = pos;
+            header[2*i+1] = send_sizes[i];
+            memcpy(data + pos, sendbuf + send_displs[i], send_sizes[i]);
+            pos += send_sizes[i];
+        }
+    }
+
+    MPI_Win_sync(xcomm->shm_win);
+    MPI_Barrier(xcomm->local_comm);
+    MPI_Win_sync(xcomm->shm_win);
+
+    return MPI_SUCCESS;
+}
+
+// Number of bytes each local rank posted for me
+int MPIX_Comm_shm_recv_sizes(const MPIX_Comm* xcomm, int* recv_sizes)
+{
+    int local_rank, ppn;
+    MPI_Comm_rank(xcomm->local_comm, &local_rank);
+    MPI_Comm_size(xcomm->local_comm, &ppn);
+
+    for (int i = 0; i < ppn; i++)
+    {
+        int* header = (int*)shm_segment(xcomm, i, ppn);
+        recv_sizes[i] = header[2*local_rank+1];
+    }
+
+    return MPI_SUCCESS;
+}
+
+// Data (and its size) posted for me by local rank local_proc, to be
+// read in place : unpack straight from it rather than copying it
+// out first.  Call MPIX_Comm_shm_release once done with all of it
+const char* MPIX_Comm_shm_peer(const MPIX_Comm* xcomm, int local_proc, int* size)
+{
+    int local_rank, ppn;
+    MPI_Comm_rank(xcomm->local_comm, &local_rank);
+    MPI_Comm_size(xcomm->local_comm, &ppn);
+
+    char* segment = shm_segment(xcomm, local_proc, ppn);
+    int* header = (int*)segment;
+    *size = header[2*local_rank+1];
+
+    return segment + 2*ppn*sizeof(int) + header[2*local_rank];
+}
+
+// Done reading posted data : segments may be reused once all local
+// ranks return
+int MPIX_Comm_shm_release(const MPIX_Comm* xcomm)
+{
+    MPI_Barrier(xcomm->local_comm);
+
+    return MPI_SUCCESS;
+}
+
+// Copy data posted for me by each local rank into recvbuf
+// (at recv_displs[i], or consecutively in local rank order if NULL)
+// Segments may be reused once all local ranks return
+int MPIX_Comm_shm_read(const MPIX_Comm* xcomm, char* recvbuf,
+        const int* recv_displs)
+{
+    int ppn;
+    MPI_Comm_size(xcomm->local_comm, &ppn);
+
+    int pos = 0;
+    int size;
+    for (int i = 0; i < ppn; i++)
+    {
+        const char* data = MPIX_Comm_shm_peer(xcomm, i, &size);
+        if (recv_displs)
+            pos = recv_displs[i];
+        memcpy(recvbuf + pos, data, size);
+        pos += size;
+    }
+
+    return MPIX_Comm_shm_release(xcomm);
+}
+
 int MPIX_Comm_win_init(MPIX_Comm* xcomm, int bytes, int type_bytes)
 {
     int rank, num_procs;
@@ -113,6 +608,9 @@ int MPIX_Comm_free(MPIX_Comm** xcomm_ptr)
     if (xcomm->n_requests > 0)
         free(xcomm->requests);
 
+    if (xcomm->tuning_table != NULL)
+        free(xcomm->tuning_table);
+
     if (xcomm->neighbor_comm != MPI_COMM_NULL)
         MPI_Comm_free(&(xcomm->neighbor_comm));
 
@@ -132,6 +630,22 @@ int MPIX_Comm_topo_free(MPIX_Comm* xcomm)
    if (xcomm->group_comm != MPI_COMM_NULL)
        MPI_Comm_free(&(xcomm->group_comm));
 
+   MPIX_Comm_leader_free(xcomm);
+   MPIX_Comm_shm_free(xcomm);
+   MPIX_Comm_schedule_free(xcomm);
+
+    return MPI_SUCCESS;
+}
+
+int MPIX_Comm_leader_free(MPIX_Comm* xcomm)
+{
+   if (xcomm->leader_comm != MPI_COMM_NULL)
+      MPI_Comm_free(&(xcomm->leader_comm));
+   if (xcomm->leader_group_comm != MPI_COMM_NULL)
+       MPI_Comm_free(&(xcomm->leader_group_comm));
+   xcomm->leaders_per_node = 1;
+   xcomm->leader_uniform = 0;
+
     return MPI_SUCCESS;
 }
 
@@ -182,6 +696,25 @@ int get_global_proc(const MPIX_Comm* data, const int node, const int local_proc)
     return local_proc + (node * data->ppn);
 }
 
+void get_step_peers(const int rank, const int num_procs, const int i,
+        const int* send_procs, const int* recv_procs,
+        int* send_proc, int* recv_proc)
+{
+    if (send_procs != NULL)
+    {
+        *send_proc = send_procs[i];
+        *recv_proc = recv_procs[i];
+        return;
+    }
+
+    *send_proc = rank + i;
+    if (*send_proc >= num_procs)
+        *send_proc -= num_procs;
+    *recv_proc = rank - i;
+    if (*recv_proc < 0)
+        *recv_proc += num_procs;
+}
+
 // For testing purposes
 // Manually update aggregation size (ppn)
 void update_locality(MPIX_Comm* xcomm, int ppn)
@@ -194,6 +727,9 @@ void update_locality(MPIX_Comm* xcomm, int ppn)
         MPI_Comm_free(&(xcomm->local_comm));
     if (xcomm->group_comm != MPI_COMM_NULL)
         MPI_Comm_free(&(xcomm->group_comm));
+    MPIX_Comm_leader_free(xcomm);
+    MPIX_Comm_shm_free(xcomm);
+    MPIX_Comm_schedule_free(xcomm);
 
     MPI_Comm_split(xcomm->global_comm,
         rank / ppn,
@@ -210,5 +746,62 @@ void update_locality(MPIX_Comm* xcomm, int ppn)
         local_rank,
         rank,
         &(xcomm->group_comm));
+
+    xcomm->local_uniform = uniform_split(xcomm->global_comm,
+            xcomm->local_comm, xcomm->group_comm);
 }
 
+// Manually update number of processes per leader
+// Splits each node into groups of procs_per_leader processes
+void update_leaders(MPIX_Comm* xcomm, int procs_per_leader)
+{
+    if (xcomm->local_comm == MPI_COMM_NULL)
+        MPIX_Comm_topo_init(xcomm);
+
+    int rank, local_rank;
+    MPI_Comm_rank(xcomm->global_comm, &rank);
+    MPI_Comm_rank(xcomm->local_comm, &local_rank);
+
+    MPIX_Comm_leader_free(xcomm);
+
+    // Single leader per node : use local_comm and group_comm
+    if (procs_per_leader >= xcomm->ppn)
+        return;
+
+    MPI_Comm_split(xcomm->local_comm,
+        local_rank / procs_per_leader,
+        local_rank,
+        &(xcomm->leader_comm));
+    xcomm->leaders_per_node = ((xcomm->ppn - 1) / procs_per_leader) + 1;
+
+    int leader_rank;
+    MPI_Comm_rank(xcomm->leader_comm, &leader_rank);
+    MPI_Comm_split(xcomm->global_comm,
+        leader_rank,
+        rank,
+        &(xcomm->leader_group_comm));
+    xcomm->leader_uniform = uniform_split(xcomm->global_comm,
+            xcomm->leader_comm, xcomm->leader_group_comm);
+}
+
+void get_aggregation_comms(const MPIX_Comm* xcomm, MPI_Comm* local_comm,
+        MPI_Comm* group_comm)
+{
+    if (xcomm->leader_comm != MPI_COMM_NULL)
+    {
+        *local_comm = xcomm->leader_comm;
+        *group_comm = xcomm->leader_group_comm;
+    }
+    else
+    {
+        *local_comm = xcomm->local_comm;
+        *group_comm = xcomm->group_comm;
+    }
+}
+
+int MPIX_Comm_uniform(const MPIX_Comm* xcomm)
+{
+    if (xcomm->leader_comm != MPI_COMM_NULL)
+        return xcomm->leader_uniform;
+    return xcomm->local_uniform;
+}
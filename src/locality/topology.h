@@ -7,6 +7,7 @@
 #include <mpi.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "utils/utils.h"
 
@@ -15,6 +16,38 @@ extern "C"
 {
 #endif
 
+// Order in which pairwise algorithms visit peers 
+// (see MPIX_Comm_peer_schedule)
+enum PeerSchedule
+{
+    PEER_SCHEDULE_SHIFT,
+    PEER_SCHEDULE_NODE_SHIFT,
+    PEER_SCHEDULE_NODE_XOR,
+    PEER_SCHEDULE_NUM
+};
+
+// Messages in flight (each way) for alltoallv_pairwise_nonblocking 
+// and alltoallv_waitany (see MPIX_Window_update)
+typedef struct _MPIX_Window
+{
+    int size;
+    int adaptive;
+
+    // Adaptive : direction of next change (+1 : grow, -1 : shrink),
+    // and completion rate (bytes per second) of the last batch
+    // within the current call (0 : none yet)
+    int direction;
+    double rate;
+
+    // Statistics : calls using the window, size changes, and 
+    // smallest / largest size used during the last call
+    // (size itself is the window chosen for the next call)
+    long n_calls;
+    long n_adjustments;
+    int last_min_size;
+    int last_max_size;
+} MPIX_Window;
+
 typedef struct _MPIX_Comm
 {
     MPI_Comm global_comm;
@@ -22,6 +55,20 @@ typedef struct _MPIX_Comm
     MPI_Comm neighbor_comm;
     MPI_Comm group_comm;
 
+    // Multi-leader aggregation (optional)
+    // leader_comm : processes aggregated by a single leader
+    // leader_group_comm : processes with same rank in leader_comm
+    MPI_Comm leader_comm;
+    MPI_Comm leader_group_comm;
+    int leaders_per_node;
+
+    // Checked once when each split is formed (see uniform_split) :
+    // 1 if every process agrees on the number of processes per node
+    // (local_comm) or per leader (leader_comm), it divides num_procs,
+    // and ranks are in SMP order
+    int local_uniform;
+    int leader_uniform;
+
     int num_nodes;
     int rank_node;
     int ppn;
@@ -31,9 +78,41 @@ typedef struct _MPIX_Comm
     int win_bytes;
     int win_type_bytes;
 
+    // Node-shared memory for on-node exchanges
+    // shm_array : start of node segment (local rank 0)
+    // shm_bytes : data bytes per local rank
+    MPI_Win shm_win;
+    char* shm_array;
+    int shm_bytes;
+
     MPI_Request* requests;
     int n_requests;
 
+    // Algorithm parameters (see MPIX_Comm_info_init)
+    int pipeline_bytes;
+    int window_size;
+    int aggregation_bytes;
+    int sparse_percent;
+    int peer_schedule;
+
+    // Window of alltoallv_pairwise_nonblocking / alltoallv_waitany
+    // in MPIX_Alltoallv (kept across calls when adaptive).  Separate
+    // from window_size, the fixed window of the alltoall methods
+    // (see MPIX_Info in utils.h)
+    MPIX_Window nb_window;
+
+    // Next tag offset of nonblocking collectives (see MPIX_Comm_tag)
+    int nb_tag;
+
+    // Cached pairwise exchange order (NULL until first use)
+    int* send_schedule;
+    int* recv_schedule;
+
+    // Algorithm selection table (see collective/tuning.h)
+    // n_tuning_entries < 0 : not yet loaded
+    int* tuning_table;
+    int n_tuning_entries;
+
 #ifdef GPU
    int gpus_per_node;
    int rank_gpu;
@@ -47,6 +126,39 @@ int MPIX_Comm_free(MPIX_Comm** xcomm_ptr);
 int MPIX_Comm_topo_init(MPIX_Comm* xcomm);
 int MPIX_Comm_topo_free(MPIX_Comm* xcomm);
 
+int MPIX_Comm_info_init(MPIX_Comm* xcomm, MPIX_Info* xinfo);
+
+void MPIX_Window_init(MPIX_Window* window, int size, int adaptive);
+void MPIX_Window_start(MPIX_Window* window);
+void MPIX_Window_update(MPIX_Window* window, long bytes, double time,
+        int max_size);
+
+int MPIX_Comm_peer_schedule(MPIX_Comm* xcomm, const int** send_procs,
+        const int** recv_procs);
+
+// Tag for a new nonblocking collective on xcomm : cycles through
+// MPIX_NB_TAG_RANGE tags from MPIX_NB_TAG_BASE, so outstanding
+// requests (started in the same order on every process) never
+// match each other's messages
+#define MPIX_NB_TAG_BASE 110000
+#define MPIX_NB_TAG_RANGE 4096
+int MPIX_Comm_tag(MPIX_Comm* xcomm, int* tag);
+int MPIX_Comm_schedule_free(MPIX_Comm* xcomm);
+
+int MPIX_Comm_leader_init(MPIX_Comm* xcomm, MPIX_Info* xinfo);
+int MPIX_Comm_leader_free(MPIX_Comm* xcomm);
+
+int MPIX_Comm_shm_init(MPIX_Comm* xcomm, int bytes);
+int MPIX_Comm_shm_free(MPIX_Comm* xcomm);
+char* MPIX_Comm_shm_buffer(const MPIX_Comm* xcomm);
+int MPIX_Comm_shm_post(const MPIX_Comm* xcomm, const char* sendbuf,
+        const int* send_sizes, const int* send_displs);
+int MPIX_Comm_shm_recv_sizes(const MPIX_Comm* xcomm, int* recv_sizes);
+int MPIX_Comm_shm_read(const MPIX_Comm* xcomm, char* recvbuf,
+        const int* recv_displs);
+const char* MPIX_Comm_shm_peer(const MPIX_Comm* xcomm, int local_proc, int* size);
+int MPIX_Comm_shm_release(const MPIX_Comm* xcomm);
+
 int MPIX_Comm_win_init(MPIX_Comm* xcomm, int bytes, int type_bytes);
 int MPIX_Comm_win_free(MPIX_Comm* xcomm);
 
@@ -59,9 +171,28 @@ int get_node(const MPIX_Comm* data, const int proc);
 int get_local_proc(const MPIX_Comm* data, const int proc);
 int get_global_proc(const MPIX_Comm* data, const int node, const int local_proc);
 
+// Peers at step i of a pairwise exchange : send_procs[i] / recv_procs[i]
+// (see MPIX_Comm_peer_schedule), or rank + i / rank - i if NULL
+void get_step_peers(const int rank, const int num_procs, const int i,
+        const int* send_procs, const int* recv_procs,
+        int* send_proc, int* recv_proc);
+
 // For testing purposes (manually set PPN)
 void update_locality(MPIX_Comm* xcomm, int ppn);
 
+// Manually set number of processes aggregated per leader
+void update_leaders(MPIX_Comm* xcomm, int procs_per_leader);
+
+// Communicators over which locality-aware collectives aggregate
+// (leader_comm/leader_group_comm if initialized, otherwise 
+// local_comm/group_comm)
+void get_aggregation_comms(const MPIX_Comm* xcomm, MPI_Comm* local_comm,
+        MPI_Comm* group_comm);
+
+// 1 if the aggregation comms (see get_aggregation_comms) split every
+// node evenly in SMP order (cached, no communication)
+int MPIX_Comm_uniform(const MPIX_Comm* xcomm);
+
 #ifdef __cplusplus
 }
 #endif
@@ -9,10 +9,16 @@
 #include "locality/topology.h"
 
 #include "persistent/persistent.h"
+#include "persistent/progress.h"
 
 #include "collective/collective.h"
 #include "collective/alltoall.h"
 #include "collective/alltoallv.h"
+#include "collective/alltoallw.h"
+#include "collective/alltoall_init.h"
+#include "collective/alltoallv_init.h"
+#include "collective/ialltoall.h"
+#include "collective/tuning.h"
 
 #include "neighborhood/dist_graph.h"
 #include "neighborhood/dist_topo.h"
@@ -94,13 +94,12 @@ int MPIX_Neighbor_alltoallv(
     const char* send_buffer = (char*) sendbuffer;
     char* recv_buffer = (char*) recvbuffer;
 
-    int send_size, recv_size;
-    MPI_Type_size(sendtype, &send_size);
-    MPI_Type_size(recvtype, &recv_size);
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
 
     for (int i = 0; i < indegree; i++)
     {
-        MPI_Irecv(&(recv_buffer[rdispls[i]*recv_size]), 
+        MPI_Irecv(&(recv_buffer[rdispls[i]*recv_extent]), 
                 recvcounts[i],
                 recvtype, 
                 sources[i],
@@ -111,7 +110,7 @@ int MPIX_Neighbor_alltoallv(
 
     for (int i = 0; i < outdegree; i++)
     {
-        MPI_Isend(&(send_buffer[sdispls[i]*send_size]),
+        MPI_Isend(&(send_buffer[sdispls[i]*send_extent]),
                 sendcounts[i],
                 sendtype,
                 destinations[i],
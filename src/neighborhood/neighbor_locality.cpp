@@ -165,6 +165,9 @@ void init_locality(const int n_sends,
     // Initialize final variable (MPI_Request arrays, etc.)
     finalize_locality_comm(locality_comm);
 
+    // Which local_R values each global message feeds (dataflow)
+    form_locality_deps(locality_comm);
+
     // Copy to pointer for return
     request->locality = locality_comm;
     request->tag = locality_comm->global_comm->tag;
@@ -718,3 +721,34 @@ void update_indices(LocalityComm* locality,
     }
 }
 
+
+// For each global recv message, positions j of local_R sends whose
+// value (send_data->indices[j], an offset into the global recv buffer)
+// lies in that message
+void form_locality_deps(LocalityComm* locality)
+{
+    CommData* global_recv = locality->global_comm->recv_data;
+    CommData* R_send = locality->local_R_comm->send_data;
+    int n_msgs = global_recv->num_msgs;
+
+    int* ptr = (int*)calloc(n_msgs+1, sizeof(int));
+    int* pos = (int*)malloc((R_send->size_msgs+1)*sizeof(int));
+    std::vector<int> msgs(R_send->size_msgs);
+
+    for (int j = 0; j < R_send->size_msgs; j++)
+    {
+        msgs[j] = std::upper_bound(global_recv->indptr, 
+                global_recv->indptr + n_msgs + 1,
+                R_send->indices[j]) - global_recv->indptr - 1;
+        ptr[msgs[j]+1]++;
+    }
+    for (int i = 0; i < n_msgs; i++)
+        ptr[i+1] += ptr[i];
+
+    std::vector<int> ctr(ptr, ptr + n_msgs);
+    for (int j = 0; j < R_send->size_msgs; j++)
+        pos[ctr[msgs[j]]++] = j;
+
+    locality->global_to_R_ptr = ptr;
+    locality->global_to_R_pos = pos;
+}
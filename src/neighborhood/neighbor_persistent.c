@@ -1,139 +1,589 @@
 #include "neighbor.h"
 #include "neighbor_persistent.h"
+#include <sched.h>
 
-// Starting locality-aware requests
-// 1. Start Local_L
-// 2. Start and wait for local_S
-// 3. Start global
+// Starting standard neighbor requests : start global messages
+// (locality-aware requests use neighbor_shm_start)
 int neighbor_start(MPIX_Request* request)
 {
     if (request == NULL)
         return 0;
 
     int ierr = 0;
-    int idx;
+    if (request->global_n_msgs)
+        ierr += MPI_Startall(request->global_n_msgs, request->global_requests);
+    request->phase = MPIX_PHASE_GLOBAL;
 
-    char* send_buffer = NULL;
-    int recv_size = 0;
-    if (request->recv_size)
-    {
-        send_buffer = (char*)(request->sendbuf);
-        recv_size = request->recv_size;
-    }
+    return ierr;
+}
+
+
+// Wait for standard neighbor requests
+// TODO : Currently ignores the status!
+int neighbor_wait(MPIX_Request* request, MPI_Status* status)
+{
+    (void)status;
+    if (request == NULL)
+        return 0;
+
+    int ierr = 0;
+    if (request->global_n_msgs)
+        ierr += MPI_Waitall(request->global_n_msgs, request->global_requests,
+                MPI_STATUSES_IGNORE);
+
+    return ierr;
+}
+
+// Poll standard neighbor requests without blocking
+int neighbor_test(MPIX_Request* request, int* flag, MPI_Status* status)
+{
+    (void)status;
+    *flag = 1;
+    if (request == NULL)
+        return 0;
+
+    int ierr = 0;
+    if (request->global_n_msgs)
+        ierr += MPI_Testall(request->global_n_msgs, request->global_requests,
+                flag, MPI_STATUSES_IGNORE);
+
+    return ierr;
+}
+
+
+// Flags of each node-shared segment (ints) : ready epochs of my
+// local_L and local_S sends, my acknowledgements (epoch read) of
+// each local rank's local_L, local_S and local_R sends, then ready
+// epochs of the local_R values forwarded from each global message
+#define SHM_L_READY 0
+#define SHM_S_READY 1
+#define SHM_ACK(phase, proc, ppn) (2 + (phase)*(ppn) + (proc))
+#define SHM_MSG(msg, ppn) (2 + 3*(ppn) + (msg))
+
+// Raise flag 'idx' of my segment to the current epoch, once the
+// data it covers is written
+static void shm_raise(LocalityShm* shm, int idx)
+{
+    int local_rank;
+    MPI_Comm_rank(shm->local_comm, &local_rank);
+
+    MPI_Win_sync(shm->win);
+    shm->flags[local_rank][idx] = shm->epoch;
+}
 
-    // Local L sends sendbuf
-    if (request->local_L_n_msgs)
+// Returns 1 if flag 'idx' of every local rank in procs holds the
+// current epoch (then their data may be read)
+static int shm_check(LocalityShm* shm, int n, const int* procs, int idx)
+{
+    for (int i = 0; i < n; i++)
+        if (shm->flags[procs[i]][idx] != shm->epoch)
+            return 0;
+
+    MPI_Win_sync(shm->win);
+    return 1;
+}
+
+// Acknowledge that data of 'phase' from each local rank in procs
+// is read (so they may complete, and reuse their segment)
+static void shm_ack(LocalityShm* shm, int phase, int n, const int* procs)
+{
+    int local_rank, ppn;
+    MPI_Comm_rank(shm->local_comm, &local_rank);
+    MPI_Comm_size(shm->local_comm, &ppn);
+
+    MPI_Win_sync(shm->win);
+    for (int i = 0; i < n; i++)
+        shm->flags[local_rank][SHM_ACK(phase, procs[i], ppn)] = shm->epoch;
+}
+
+// Returns 1 once every local rank in procs acknowledged my data of 'phase'
+static int shm_acked(LocalityShm* shm, int phase, int n, const int* procs)
+{
+    int local_rank, ppn;
+    MPI_Comm_rank(shm->local_comm, &local_rank);
+    MPI_Comm_size(shm->local_comm, &ppn);
+
+    return shm_check(shm, n, procs, SHM_ACK(phase, local_rank, ppn));
+}
+
+// Forward global messages into my local_R sends as they arrive
+// (MPI_Testsome), each copying only the local_R values it feeds
+// (locality->global_to_R_ptr) into their slots, then raising its
+// flag so destinations unpack that slice right away.  Completed
+// persistent requests become inactive, so later calls continue with
+// the remaining messages.  Returns 1 once all global messages are
+// complete
+static int neighbor_shm_forward(MPIX_Request* request, int* ierr)
+{
+    LocalityComm* locality = request->locality;
+    LocalityShm* shm = locality->shm;
+    CommData* global_recv = locality->global_comm->recv_data;
+    CommData* R_send = locality->local_R_comm->send_data;
+    int n_recvs = global_recv->num_msgs;
+    int n_sends = request->global_n_msgs - n_recvs;
+    int size = request->recv_size;
+    int done = 1;
+
+    int local_rank, ppn;
+    MPI_Comm_rank(shm->local_comm, &local_rank);
+    MPI_Comm_size(shm->local_comm, &ppn);
+
+    int n_done, msg, j;
+    int* done_msgs = (int*)malloc((n_recvs+1)*sizeof(int));
+    while (!shm->R_posted)
     {
-        for (int i = 0; i < request->locality->local_L_comm->send_data->size_msgs; i++)
+        *ierr += MPI_Testsome(n_recvs, request->global_requests, &n_done,
+                done_msgs, MPI_STATUSES_IGNORE);
+
+        // All global recvs complete
+        if (n_done == MPI_UNDEFINED)
         {
-            idx = request->locality->local_L_comm->send_data->indices[i];
-            for (int j = 0; j < recv_size; j++)
-                request->locality->local_L_comm->send_data->buffer[i*recv_size+j] = send_buffer[idx*recv_size+j];
+            shm->R_posted = 1;
+            break;
         }
-        ierr += MPI_Startall(request->local_L_n_msgs, request->local_L_requests);
+
+        // None arrived since last test
+        if (n_done == 0)
+        {
+            done = 0;
+            break;
+        }
+
+        for (int i = 0; i < n_done; i++)
+        {
+            msg = done_msgs[i];
+            for (int k = locality->global_to_R_ptr[msg];
+                    k < locality->global_to_R_ptr[msg+1]; k++)
+            {
+                j = locality->global_to_R_pos[k];
+                memcpy(shm->R_data + (MPI_Aint)(shm->R_slot[j])*size,
+                        global_recv->buffer + (MPI_Aint)(R_send->indices[j])*size,
+                        size);
+            }
+        }
+
+        MPI_Win_sync(shm->win);
+        for (int i = 0; i < n_done; i++)
+            shm->flags[local_rank][SHM_MSG(done_msgs[i], ppn)] = shm->epoch;
     }
+    free(done_msgs);
 
+    if (done && n_sends)
+        *ierr += MPI_Testall(n_sends, &(request->global_requests[n_recvs]),
+                &done, MPI_STATUSES_IGNORE);
+
+    return done;
+}
+
+// Unpack each slice of my local_R recvs whose global message has
+// arrived at the sender, straight from the sender's segment.
+// Returns 1 once all slices are read
+static int neighbor_shm_read_R(MPIX_Request* request)
+{
+    LocalityComm* locality = request->locality;
+    LocalityShm* shm = locality->shm;
+    CommData* R_recv = locality->local_R_comm->recv_data;
+    char* recv_buffer = (char*)(request->recvbuf);
+    int size = request->recv_size;
+    int synced = 0;
 
+    int ppn;
+    MPI_Comm_size(shm->local_comm, &ppn);
 
-    // Local S sends sendbuf
-    if (request->local_S_n_msgs)
+    for (int i = 0; i < R_recv->num_msgs; i++)
     {
-        for (int i = 0; i < request->locality->local_S_comm->send_data->size_msgs; i++)
+        volatile int* src_flags = shm->flags[R_recv->procs[i]];
+        for (int k = shm->R_slice_ptr[i]; k < shm->R_slice_ptr[i+1]; k++)
         {
-            idx = request->locality->local_S_comm->send_data->indices[i];
+            if (shm->R_slice_epoch[k] == shm->epoch
+                    || src_flags[SHM_MSG(shm->R_slice_msg[k], ppn)] != shm->epoch)
+                continue;
 
-            for (int j = 0; j < recv_size; j++)
-                request->locality->local_S_comm->send_data->buffer[i*recv_size+j] = send_buffer[idx*recv_size+j];
+            if (!synced)
+            {
+                MPI_Win_sync(shm->win);
+                synced = 1;
+            }
+            MPIX_Type_unpack_indexed(shm->R_src[i]
+                        + (MPI_Aint)(shm->R_slice_start[k] - R_recv->indptr[i])*size,
+                    recv_buffer, request->recvtype, shm->R_slice_count[k],
+                    &(shm->R_idx[shm->R_slice_start[k]]));
+            shm->R_slice_epoch[k] = shm->epoch;
+            shm->R_n_read++;
         }
+    }
 
-        ierr += MPI_Startall(request->local_S_n_msgs, request->local_S_requests);
-        ierr += MPI_Waitall(request->local_S_n_msgs, request->local_S_requests, MPI_STATUSES_IGNORE);
+    return shm->R_n_read == shm->R_slice_ptr[R_recv->num_msgs];
+}
 
+// Advance locality-aware request (shared-memory on-node phases) as
+// far as its data has arrived, without blocking
+//  - local_S : once every local_S sender is ready, pack the global
+//      send buffer straight from their segments and start global
+//  - global : forward global messages into my local_R sends
+//  - local_R : unpack straight from each sender's segment into
+//      recvbuf, slice by slice as its global messages arrive
+//  - local_L : unpack straight from each sender's segment into
+//      recvbuf, once it is ready
+// request->phase is the first step not yet complete, and the request
+// completes once local ranks acknowledged all of my on-node sends
+static int neighbor_shm_progress(MPIX_Request* request, int* flag)
+{
+    int ierr = 0;
 
-        // Copy into global->send_data->buffer
-        for (int i = 0; i < request->locality->global_comm->send_data->size_msgs; i++)
-        {
-            idx = request->locality->global_comm->send_data->indices[i];
-            for (int j = 0; j < recv_size; j++)
-                request->locality->global_comm->send_data->buffer[i*recv_size+j] = request->locality->local_S_comm->recv_data->buffer[idx*recv_size+j];
-        }
+    char* recv_buffer = (char*)(request->recvbuf);
+    int size = request->recv_size;
+    LocalityComm* locality = request->locality;
+    LocalityShm* shm = locality->shm;
+    CommData* L_send = locality->local_L_comm->send_data;
+    CommData* L_recv = locality->local_L_comm->recv_data;
+    CommData* S_send = locality->local_S_comm->send_data;
+    CommData* S_recv = locality->local_S_comm->recv_data;
+    CommData* R_send = locality->local_R_comm->send_data;
+    CommData* R_recv = locality->local_R_comm->recv_data;
+    CommData* G_send = locality->global_comm->send_data;
+
+    if (request->phase == MPIX_PHASE_LOCAL_S
+            && shm_check(shm, S_recv->num_msgs, S_recv->procs, SHM_S_READY))
+    {
+        for (int i = 0; i < G_send->size_msgs; i++)
+            memcpy(G_send->buffer + (MPI_Aint)i*size, shm->G_src[i], size);
+        shm_ack(shm, 1, S_recv->num_msgs, S_recv->procs);
+
+        if (request->global_n_msgs)
+            ierr += MPI_Startall(request->global_n_msgs, request->global_requests);
+        request->phase = MPIX_PHASE_GLOBAL;
     }
 
-    // Global sends buffer in locality, sendbuf in standard
-    if (request->global_n_msgs)
-        ierr += MPI_Startall(request->global_n_msgs, request->global_requests);
+    if (request->phase == MPIX_PHASE_GLOBAL && neighbor_shm_forward(request, &ierr))
+        request->phase = MPIX_PHASE_LOCAL_R;
+
+    if (!shm->R_read && neighbor_shm_read_R(request))
+    {
+        shm_ack(shm, 2, R_recv->num_msgs, R_recv->procs);
+        shm->R_read = 1;
+    }
+
+    if (!shm->L_read
+            && shm_check(shm, L_recv->num_msgs, L_recv->procs, SHM_L_READY))
+    {
+        for (int i = 0; i < L_recv->num_msgs; i++)
+            MPIX_Type_unpack_indexed(shm->L_src[i], recv_buffer, request->recvtype,
+                    L_recv->indptr[i+1] - L_recv->indptr[i],
+                    &(L_recv->indices[L_recv->indptr[i]]));
+        shm_ack(shm, 0, L_recv->num_msgs, L_recv->procs);
+        shm->L_read = 1;
+    }
+
+    if (request->phase == MPIX_PHASE_LOCAL_R && shm->R_read)
+        request->phase = MPIX_PHASE_LOCAL_L;
+
+    if (request->phase == MPIX_PHASE_LOCAL_L && shm->L_read
+            && shm_acked(shm, 0, L_send->num_msgs, L_send->procs)
+            && shm_acked(shm, 1, S_send->num_msgs, S_send->procs)
+            && shm_acked(shm, 2, R_send->num_msgs, R_send->procs))
+        request->phase = MPIX_PHASE_COMPLETE;
 
+    *flag = (request->phase == MPIX_PHASE_COMPLETE);
     return ierr;
 }
 
+// Starting locality-aware requests (shared-memory on-node phases)
+// 1. Pack local_L and local_S sends into my segment, raise their flags
+// 2. Start global, if every local_S sender is already ready
+// Local ranks acknowledged the previous epoch before it completed,
+// so the segment is free to reuse
+int neighbor_shm_start(MPIX_Request* request)
+{
+    if (request == NULL)
+        return 0;
 
-// Wait for locality-aware requests
-// 1. Wait for global
-// 2. Start and wait for local_R
-// 3. Wait for local_L
-// TODO : Currently ignores the status!
-int neighbor_wait(MPIX_Request* request, MPI_Status* status)
+    int flag;
+
+    const char* send_buffer = (const char*)(request->sendbuf);
+    LocalityComm* locality = request->locality;
+    LocalityShm* shm = locality->shm;
+    CommData* L_send = locality->local_L_comm->send_data;
+    CommData* S_send = locality->local_S_comm->send_data;
+
+    shm->epoch++;
+    shm->L_read = 0;
+    shm->R_read = 0;
+    shm->R_posted = 0;
+    shm->R_n_read = 0;
+
+    MPIX_Type_pack_indexed(send_buffer, request->sendtype,
+            L_send->size_msgs, L_send->indices, shm->L_data);
+    MPIX_Type_pack_indexed(send_buffer, request->sendtype,
+            S_send->size_msgs, S_send->indices, shm->S_data);
+    shm_raise(shm, SHM_L_READY);
+    shm_raise(shm, SHM_S_READY);
+
+    request->phase = MPIX_PHASE_LOCAL_S;
+    return neighbor_shm_progress(request, &flag);
+}
+
+// Wait for locality-aware requests (shared-memory on-node phases) :
+// poll until complete
+int neighbor_shm_wait(MPIX_Request* request, MPI_Status* status)
 {
+    (void)status;
     if (request == NULL)
         return 0;
 
     int ierr = 0;
-    int idx;
+    int flag;
 
-    char* recv_buffer = NULL;
-    int recv_size = 0;
-    if (request->recv_size)
+    ierr += neighbor_shm_progress(request, &flag);
+    while (!flag)
     {
-        recv_buffer = (char*)(request->recvbuf); 
-        recv_size = request->recv_size;
+        sched_yield();
+        ierr += neighbor_shm_progress(request, &flag);
     }
 
+    return ierr;
+}
 
-    // Global waits for recvs
-    if (request->global_n_msgs)
-    {
-        ierr += MPI_Waitall(request->global_n_msgs, request->global_requests, MPI_STATUSES_IGNORE);
+// Poll locality-aware requests (shared-memory on-node phases) :
+// only checks flags of local ranks and tests global messages, so
+// requests may be tested in any order
+int neighbor_shm_test(MPIX_Request* request, int* flag, MPI_Status* status)
+{
+    (void)status;
+    *flag = 1;
+    if (request == NULL)
+        return 0;
 
-        if (request->local_R_n_msgs)
-        {
-            for (int i = 0; i < request->locality->local_R_comm->send_data->size_msgs; i++)
-            {
-                idx = request->locality->local_R_comm->send_data->indices[i];
-                for (int j = 0; j < recv_size; j++)
-                    request->locality->local_R_comm->send_data->buffer[i*recv_size+j] = request->locality->global_comm->recv_data->buffer[idx*recv_size+j];
-            }
-        }
-    }
+    return neighbor_shm_progress(request, flag);
+}
+
+static MPI_Aint shm_align(MPI_Aint bytes)
+{
+    return ((bytes + 7) / 8) * 8;
+}
 
-    // Wait for local_R recvs
-    if (request->local_R_n_msgs)
+// Local recv message of indptr (n messages) holding position pos
+static int find_msg(int n, const int* indptr, int pos)
+{
+    int lo = 0;
+    int hi = n - 1;
+    while (lo < hi)
     {
-        ierr += MPI_Startall(request->local_R_n_msgs, request->local_R_requests);
-        ierr += MPI_Waitall(request->local_R_n_msgs, request->local_R_requests, MPI_STATUSES_IGNORE);
+        int mid = (lo + hi + 1) / 2;
+        if (indptr[mid] <= pos)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    return lo;
+}
 
-        for (int i = 0; i < request->locality->local_R_comm->recv_data->size_msgs; i++)
+/**************************************************
+ * Shared-Memory On-Node Phases
+ *  - Each request allocates its own node-shared 
+ *      segments : [flags][local_L][local_S][local_R]
+ *      sends of each local rank, with local_R values
+ *      of each destination stored by global message
+ *      (slot tables follow), so destinations unpack
+ *      each global message's slice as it arrives
+ *  - Data is packed once into the sender's segment,
+ *      and unpacked by the destination straight from
+ *      it (into recvbuf, or the global send buffer)
+ *  - Ready flags and acknowledgements hold the epoch
+ *      of the request, so no phase synchronizes the
+ *      node, and requests may progress in any order
+ *  - Global messages get a tag of their own 
+ *      (MPIX_Comm_tag), so requests started in 
+ *      different orders never match
+ *  - Collective over comm (as is freeing the request)
+ *************************************************/
+int init_neighbor_shm(MPIX_Request* request, MPIX_Comm* comm)
+{
+    LocalityComm* locality = request->locality;
+    CommData* L_send = locality->local_L_comm->send_data;
+    CommData* L_recv = locality->local_L_comm->recv_data;
+    CommData* S_send = locality->local_S_comm->send_data;
+    CommData* S_recv = locality->local_S_comm->recv_data;
+    CommData* R_send = locality->local_R_comm->send_data;
+    CommData* R_recv = locality->local_R_comm->recv_data;
+    CommData* G_send = locality->global_comm->send_data;
+    CommData* G_recv = locality->global_comm->recv_data;
+    int size = request->recv_size;
+
+    if (comm->local_comm == MPI_COMM_NULL)
+        MPIX_Comm_topo_init(comm);
+    if (locality->global_to_R_ptr == NULL)
+        form_locality_deps(locality);
+
+    int local_rank, ppn;
+    MPI_Comm_rank(comm->local_comm, &local_rank);
+    MPI_Comm_size(comm->local_comm, &ppn);
+
+    LocalityShm* shm = (LocalityShm*)calloc(1, sizeof(LocalityShm));
+    shm->local_comm = comm->local_comm;
+
+    // Start of my local_L, local_S and local_R areas, of the local_R
+    // slot tables (slot of each value, global message of each slot),
+    // and segment size
+    int n_flags = SHM_MSG(G_recv->num_msgs, ppn);
+    MPI_Aint areas[6];
+    areas[0] = shm_align(n_flags*sizeof(int));
+    areas[1] = areas[0] + shm_align((MPI_Aint)L_send->size_msgs*size);
+    areas[2] = areas[1] + shm_align((MPI_Aint)S_send->size_msgs*size);
+    areas[3] = areas[2] + shm_align((MPI_Aint)R_send->size_msgs*size);
+    areas[4] = areas[3] + shm_align((MPI_Aint)R_send->size_msgs*sizeof(int));
+    areas[5] = areas[4] + shm_align((MPI_Aint)R_send->size_msgs*sizeof(int));
+
+    char* segment;
+    MPI_Win_allocate_shared(areas[5], 1, MPI_INFO_NULL, comm->local_comm,
+            &segment, &(shm->win));
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, shm->win);
+
+    int* my_flags = (int*)segment;
+    for (int i = 0; i < n_flags; i++)
+        my_flags[i] = 0;
+    shm->L_data = segment + areas[0];
+    shm->S_data = segment + areas[1];
+    shm->R_data = segment + areas[2];
+    shm->R_slot = (int*)(segment + areas[3]);
+
+    // Values of each local_R destination, ordered by the global
+    // message they are forwarded from (each from exactly one)
+    int* slot_msg = (int*)(segment + areas[4]);
+    int* R_dest = (int*)malloc((R_send->size_msgs+1)*sizeof(int));
+    int* R_next = (int*)malloc((R_send->num_msgs+1)*sizeof(int));
+    for (int i = 0; i < R_send->num_msgs; i++)
+    {
+        R_next[i] = R_send->indptr[i];
+        for (int j = R_send->indptr[i]; j < R_send->indptr[i+1]; j++)
+            R_dest[j] = i;
+    }
+    for (int msg = 0; msg < G_recv->num_msgs; msg++)
+    {
+        for (int k = locality->global_to_R_ptr[msg];
+                k < locality->global_to_R_ptr[msg+1]; k++)
         {
-            idx = request->locality->local_R_comm->recv_data->indices[i];
-            for (int j = 0; j < recv_size; j++)
-                recv_buffer[idx*recv_size+j] = request->locality->local_R_comm->recv_data->buffer[i*recv_size+j];
+            int j = locality->global_to_R_pos[k];
+            int slot = R_next[R_dest[j]]++;
+            shm->R_slot[j] = slot;
+            slot_msg[slot] = msg;
         }
     }
-
-    // Wait for local_L recvs
-    if (request->local_L_n_msgs)
+    free(R_dest);
+    free(R_next);
+
+    // Areas of each local rank, and position of my values in each
+    MPI_Aint* peer_areas = (MPI_Aint*)malloc(5*ppn*sizeof(MPI_Aint));
+    MPI_Allgather(areas, 5, MPI_AINT, peer_areas, 5, MPI_AINT, comm->local_comm);
+
+    int* displs = (int*)calloc(3*ppn, sizeof(int));
+    int* peer_displs = (int*)malloc(3*ppn*sizeof(int));
+    for (int i = 0; i < L_send->num_msgs; i++)
+        displs[3*L_send->procs[i]] = L_send->indptr[i];
+    for (int i = 0; i < S_send->num_msgs; i++)
+        displs[3*S_send->procs[i]+1] = S_send->indptr[i];
+    for (int i = 0; i < R_send->num_msgs; i++)
+        displs[3*R_send->procs[i]+2] = R_send->indptr[i];
+    MPI_Alltoall(displs, 3, MPI_INT, peer_displs, 3, MPI_INT, comm->local_comm);
+
+    MPI_Aint seg_size;
+    int disp_unit;
+    char** bases = (char**)malloc(ppn*sizeof(char*));
+    shm->flags = (volatile int**)malloc(ppn*sizeof(volatile int*));
+    for (int i = 0; i < ppn; i++)
     {
-        ierr += MPI_Waitall(request->local_L_n_msgs, request->local_L_requests, MPI_STATUSES_IGNORE);
+        MPI_Win_shared_query(shm->win, i, &seg_size, &disp_unit, &(bases[i]));
+        shm->flags[i] = (volatile int*)(bases[i]);
+    }
 
-        for (int i = 0; i < request->locality->local_L_comm->recv_data->size_msgs; i++)
+#define PEER_DATA(proc, phase) (bases[proc] + peer_areas[5*(proc)+(phase)] \
+        + (MPI_Aint)peer_displs[3*(proc)+(phase)]*size)
+    shm->L_src = (char**)malloc((L_recv->num_msgs+1)*sizeof(char*));
+    for (int i = 0; i < L_recv->num_msgs; i++)
+        shm->L_src[i] = PEER_DATA(L_recv->procs[i], 0);
+    shm->R_src = (char**)malloc((R_recv->num_msgs+1)*sizeof(char*));
+    for (int i = 0; i < R_recv->num_msgs; i++)
+        shm->R_src[i] = PEER_DATA(R_recv->procs[i], 2);
+
+    // Global send values come from the local_S recv buffer (positions
+    // G_send->indices, contiguous by local_S recv message)
+    shm->G_src = (char**)malloc((G_send->size_msgs+1)*sizeof(char*));
+    for (int i = 0; i < G_send->size_msgs; i++)
+    {
+        int pos = G_send->indices[i];
+        int msg = find_msg(S_recv->num_msgs, S_recv->indptr, pos);
+        shm->G_src[i] = PEER_DATA(S_recv->procs[msg], 1)
+                + (MPI_Aint)(pos - S_recv->indptr[msg])*size;
+    }
+#undef PEER_DATA
+
+    // Flags are zero and slot tables written on every local rank
+    // before any request starts
+    MPI_Win_sync(shm->win);
+    MPI_Barrier(comm->local_comm);
+    MPI_Win_sync(shm->win);
+
+    // Slices of my local_R recvs, one per run of the sender's slots
+    // forwarded from the same global message
+    shm->R_idx = (int*)malloc((R_recv->size_msgs+1)*sizeof(int));
+    shm->R_slice_ptr = (int*)malloc((R_recv->num_msgs+1)*sizeof(int));
+    shm->R_slice_start = (int*)malloc((R_recv->size_msgs+1)*sizeof(int));
+    shm->R_slice_count = (int*)malloc((R_recv->size_msgs+1)*sizeof(int));
+    shm->R_slice_msg = (int*)malloc((R_recv->size_msgs+1)*sizeof(int));
+    shm->R_slice_epoch = (int*)calloc(R_recv->size_msgs+1, sizeof(int));
+    int n_slices = 0;
+    shm->R_slice_ptr[0] = 0;
+    for (int i = 0; i < R_recv->num_msgs; i++)
+    {
+        int proc = R_recv->procs[i];
+        int first = peer_displs[3*proc+2];
+        const int* src_slot = (const int*)(bases[proc] + peer_areas[5*proc+3]);
+        const int* src_msg = (const int*)(bases[proc] + peer_areas[5*proc+4]);
+        for (int j = R_recv->indptr[i]; j < R_recv->indptr[i+1]; j++)
         {
-            idx = request->locality->local_L_comm->recv_data->indices[i];
-            for (int j = 0; j < recv_size; j++)
-                recv_buffer[idx*recv_size+j] = request->locality->local_L_comm->recv_data->buffer[i*recv_size+j];
+            int p = j - R_recv->indptr[i];
+            shm->R_idx[R_recv->indptr[i] + src_slot[first+p] - first] = R_recv->indices[j];
+            if (p == 0 || src_msg[first+p] != src_msg[first+p-1])
+            {
+                shm->R_slice_start[n_slices] = j;
+                shm->R_slice_count[n_slices] = 0;
+                shm->R_slice_msg[n_slices] = src_msg[first+p];
+                n_slices++;
+            }
+            shm->R_slice_count[n_slices-1]++;
         }
+        shm->R_slice_ptr[i+1] = n_slices;
     }
 
+    free(peer_areas);
+    free(displs);
+    free(peer_displs);
+    free(bases);
 
-    return ierr;
+    locality->shm = shm;
+
+    MPIX_Comm_tag(comm, &(locality->global_comm->tag));
+    request->tag = locality->global_comm->tag;
+
+    request->start_function = (void*) neighbor_shm_start;
+    request->wait_function = (void*) neighbor_shm_wait;
+    request->test_function = (void*) neighbor_shm_test;
+
+    // Global Communication
+    return init_communication(G_send->buffer,
+            G_send->num_msgs,
+            G_send->procs,
+            G_send->indptr,
+            request->packed_type,
+            locality->global_comm->recv_data->buffer,
+            locality->global_comm->recv_data->num_msgs,
+            locality->global_comm->recv_data->procs,
+            locality->global_comm->recv_data->indptr,
+            request->packed_type,
+            locality->global_comm->tag,
+            comm->global_comm,
+            &(request->global_n_msgs),
+            &(request->global_requests));
 }
 
 
@@ -144,6 +594,7 @@ void init_neighbor_request(MPIX_Request** request_ptr)
 
     request->start_function = (void*) neighbor_start;
     request->wait_function = (void*) neighbor_wait;
+    request->test_function = (void*) neighbor_test;
 }
 
 int init_communication(const void* sendbuffer,
@@ -163,12 +614,11 @@ int init_communication(const void* sendbuffer,
 {
     int ierr = 0;
     int start, size;
-    int send_size, recv_size;
 
     char* send_buffer = (char*) sendbuffer;
     char* recv_buffer = (char*) recvbuffer;
-    MPI_Type_size(sendtype, &send_size);
-    MPI_Type_size(recvtype, &recv_size);
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
 
     MPI_Request* requests;
     *n_request_ptr = n_recvs+n_sends;
@@ -179,7 +629,7 @@ int init_communication(const void* sendbuffer,
         start = recv_ptr[i];
         size = recv_ptr[i+1] - start;
 
-        ierr += MPI_Recv_init(&(recv_buffer[start*recv_size]), 
+        ierr += MPI_Recv_init(&(recv_buffer[start*recv_extent]), 
                 size, 
                 recvtype, 
                 recv_procs[i],
@@ -193,7 +643,7 @@ int init_communication(const void* sendbuffer,
         start = send_ptr[i];
         size = send_ptr[i+1] - start;
 
-        ierr += MPI_Send_init(&(send_buffer[start*send_size]),
+        ierr += MPI_Send_init(&(send_buffer[start*send_extent]),
                 size,
                 sendtype,
                 send_procs[i],
@@ -256,13 +706,12 @@ int MPIX_Neighbor_alltoallv_init(
 
     const char* send_buffer = (const char*)(sendbuffer);
     char* recv_buffer = (char*)(recvbuffer);
-    int send_size, recv_size;
-    MPI_Type_size(sendtype, &send_size);
-    MPI_Type_size(recvtype, &recv_size);
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
 
     for (int i = 0; i < indegree; i++)
     {
-        ierr += MPI_Recv_init(&(recv_buffer[rdispls[i]*recv_size]), 
+        ierr += MPI_Recv_init(&(recv_buffer[rdispls[i]*recv_extent]), 
                 recvcounts[i], 
                 recvtype, 
                 sources[i],
@@ -273,7 +722,7 @@ int MPIX_Neighbor_alltoallv_init(
 
     for (int i = 0; i < outdegree; i++)
     {
-        ierr += MPI_Send_init(&(send_buffer[sdispls[i]*send_size]),
+        ierr += MPI_Send_init(&(send_buffer[sdispls[i]*send_extent]),
                 sendcounts[i],
                 sendtype,
                 destinations[i],
@@ -287,6 +736,7 @@ int MPIX_Neighbor_alltoallv_init(
     free(destinations);
     free(destweights);
 
+    request->progress_thread = info->progress_thread;
     *request_ptr = request;
 
     return ierr;
@@ -368,6 +818,7 @@ int MPIX_Neighbor_alltoallw_init(
     free(destinations);
     free(destweights);
 
+    request->progress_thread = info->progress_thread;
     *request_ptr = request;
 
     return ierr;
@@ -439,79 +890,25 @@ int MPIX_Neighbor_locality_alltoallv_init(
 
     request->sendbuf = sendbuffer;
     request->recvbuf = recvbuffer;
+    request->sendtype = sendtype;
+    request->recvtype = recvtype;
     MPI_Type_size(recvtype, &(request->recv_size));
 
-    // Local L Communication
-    //init_communication(sendbuffer,
-    init_communication(request->locality->local_L_comm->send_data->buffer,
-            request->locality->local_L_comm->send_data->num_msgs,
-            request->locality->local_L_comm->send_data->procs,
-            request->locality->local_L_comm->send_data->indptr,
-            sendtype,
-            request->locality->local_L_comm->recv_data->buffer,
-            request->locality->local_L_comm->recv_data->num_msgs,
-            request->locality->local_L_comm->recv_data->procs,
-            request->locality->local_L_comm->recv_data->indptr,
-            recvtype,
-            request->locality->local_L_comm->tag,
-            comm->local_comm,
-            &(request->local_L_n_msgs),
-            &(request->local_L_requests));
-
-    // Local S Communication
-    init_communication(request->locality->local_S_comm->send_data->buffer,
-            //sendbuffer,
-            request->locality->local_S_comm->send_data->num_msgs,
-            request->locality->local_S_comm->send_data->procs,
-            request->locality->local_S_comm->send_data->indptr,
-            sendtype,
-            request->locality->local_S_comm->recv_data->buffer,
-            request->locality->local_S_comm->recv_data->num_msgs,
-            request->locality->local_S_comm->recv_data->procs,
-            request->locality->local_S_comm->recv_data->indptr,
-            recvtype,
-            request->locality->local_S_comm->tag,
-            comm->local_comm,
-            &(request->local_S_n_msgs),
-            &(request->local_S_requests));
+    // Internal buffers hold values packed by the datatype engine,
+    // exchanged as blocks of recv_size bytes
+    MPI_Type_contiguous(request->recv_size, MPI_BYTE, &(request->packed_type));
+    MPI_Type_commit(&(request->packed_type));
 
-    // Global Communication
-    init_communication(request->locality->global_comm->send_data->buffer,
-            request->locality->global_comm->send_data->num_msgs,
-            request->locality->global_comm->send_data->procs,
-            request->locality->global_comm->send_data->indptr,
-            sendtype,
-            request->locality->global_comm->recv_data->buffer,
-            request->locality->global_comm->recv_data->num_msgs,
-            request->locality->global_comm->recv_data->procs,
-            request->locality->global_comm->recv_data->indptr,
-            recvtype,
-            request->locality->global_comm->tag,
-            comm->global_comm,
-            &(request->global_n_msgs),
-            &(request->global_requests));
-
-    // Local R Communication
-    init_communication(request->locality->local_R_comm->send_data->buffer,
-            request->locality->local_R_comm->send_data->num_msgs,
-            request->locality->local_R_comm->send_data->procs,
-            request->locality->local_R_comm->send_data->indptr,
-            sendtype,
-            request->locality->local_R_comm->recv_data->buffer,
-            request->locality->local_R_comm->recv_data->num_msgs,
-            request->locality->local_R_comm->recv_data->procs,
-            request->locality->local_R_comm->recv_data->indptr,
-            recvtype,
-            request->locality->local_R_comm->tag,
-            comm->local_comm,
-            &(request->local_R_n_msgs),
-            &(request->local_R_requests));
+    // On-node phases (local_L, local_S, local_R) exchange through
+    // node-shared memory rather than point-to-point messages
+    init_neighbor_shm(request, comm);
 
     free(sources);
     free(sourceweights);
     free(destinations);
     free(destweights);
 
+    request->progress_thread = info->progress_thread;
     *request_ptr = request;
 
     return 0;
@@ -10,22 +10,40 @@ extern "C"
 {
 #endif
 
-// Starting locality-aware requests
-// 1. Start Local_L
-// 2. Start and wait for local_S
-// 3. Start global
+// Standard neighbor requests (global messages only)
 int neighbor_start(MPIX_Request* request);
+int neighbor_wait(MPIX_Request* request, MPI_Status* status);
+int neighbor_test(MPIX_Request* request, int* flag, MPI_Status* status);
 
 
-// Wait for locality-aware requests
-// 1. Wait for global
-// 2. Start and wait for local_R
-// 3. Wait for local_L
-int neighbor_wait(MPIX_Request* request, MPI_Status* status);
+// Locality-aware requests with on-node phases in per-request
+// node-shared segments (see init_neighbor_shm)
+int neighbor_shm_start(MPIX_Request* request);
+int neighbor_shm_wait(MPIX_Request* request, MPI_Status* status);
+int neighbor_shm_test(MPIX_Request* request, int* flag, MPI_Status* status);
+int init_neighbor_shm(MPIX_Request* request, MPIX_Comm* comm);
 
+// Dataflow dependencies of global messages (locality->global_to_R_*)
+void form_locality_deps(LocalityComm* locality);
 
 void init_neighbor_request(MPIX_Request** request_ptr);
 
+// Persistent sends/recvs of messages in CSR form (procs, indptr)
+int init_communication(const void* sendbuffer,
+        int n_sends,
+        const int* send_procs,
+        const int* send_ptr, 
+        MPI_Datatype sendtype,
+        void* recvbuffer, 
+        int n_recvs,
+        const int* recv_procs,
+        const int* recv_ptr,
+        MPI_Datatype recvtype,
+        int tag,
+        MPI_Comm comm,
+        int* n_request_ptr,
+        MPI_Request** request_ptr);
+
 
 // Standard Persistent Neighbor Alltoallv
 // Extension takes array of requests instead of single request
@@ -62,6 +62,8 @@ int alltoall_crs_rma(int send_nnz, int* dest, int sendcount,
     int send_bytes, recv_bytes;
     MPI_Type_size(sendtype, &send_bytes);
     MPI_Type_size(recvtype, &recv_bytes);
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
     int bytes = num_procs * recvcount * recv_bytes;
 
     if (comm->win_bytes != bytes
@@ -79,11 +81,12 @@ int alltoall_crs_rma(int send_nnz, int* dest, int sendcount,
     send_bytes *= sendcount;
     recv_bytes *= recvcount;
 
+    // Window holds packed values (MPI packs the origin type)
     MPI_Barrier(MPI_COMM_WORLD);
     MPI_Win_fence(MPI_MODE_NOSTORE|MPI_MODE_NOPRECEDE, comm->win);
     for (int i = 0; i < send_nnz; i++)
     {
-         MPI_Put(&(send_buffer[i*send_bytes]), send_bytes, MPI_CHAR,
+         MPI_Put(&(send_buffer[i*sendcount*send_extent]), sendcount, sendtype,
                  dest[i], rank*recv_bytes, recv_bytes, MPI_CHAR, comm->win);
     }
     MPI_Barrier(MPI_COMM_WORLD);
@@ -105,7 +108,8 @@ int alltoall_crs_rma(int send_nnz, int* dest, int sendcount,
         {
             char* recv_buffer = (char*)recvvals;
             src[ctr] = i;
-            memcpy(&(recv_buffer[ctr*recv_bytes]), &(comm->win_array[i*recv_bytes]), recv_bytes);
+            MPIX_Type_unpack(&(comm->win_array[i*recv_bytes]),
+                    &(recv_buffer[ctr*recvcount*recv_extent]), recvcount, recvtype);
             ctr++;
         }
     }
@@ -132,11 +136,8 @@ int alltoall_crs_personalized(int send_nnz, int* dest, int sendcount,
     char* send_buffer;
     if (send_nnz)
         send_buffer = (char*)(sendvals);
-    int send_bytes, recv_bytes;
-    MPI_Type_size(sendtype, &send_bytes);
-    MPI_Type_size(recvtype, &recv_bytes);
-    send_bytes *= sendcount;
-    recv_bytes *= recvcount;
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
 
     if (!(xinfo->crs_num_initialized))
     {
@@ -156,8 +157,8 @@ int alltoall_crs_personalized(int send_nnz, int* dest, int sendcount,
     for (int i = 0; i < send_nnz; i++)
     {
         proc = dest[i];
-        MPI_Isend(&(send_buffer[i*send_bytes]), send_bytes, MPI_BYTE, proc, tag, comm->global_comm,
-                &(comm->requests[i]));
+        MPI_Isend(&(send_buffer[i*sendcount*send_extent]), sendcount, sendtype, proc, tag, 
+                comm->global_comm, &(comm->requests[i]));
     }
 
     ctr = 0;
@@ -167,7 +168,7 @@ int alltoall_crs_personalized(int send_nnz, int* dest, int sendcount,
         MPI_Probe(MPI_ANY_SOURCE, tag, comm->global_comm, &recv_status);
         proc = recv_status.MPI_SOURCE;
         src[ctr] = proc;
-        MPI_Recv(&(recv_buffer[ctr*send_bytes]), send_bytes, MPI_BYTE, proc, tag,
+        MPI_Recv(&(recv_buffer[ctr*recvcount*recv_extent]), recvcount, recvtype, proc, tag,
                 comm->global_comm, &recv_status);
         ctr++;
     }
@@ -191,11 +192,8 @@ int alltoall_crs_nonblocking(int send_nnz, int* dest, int sendcount,
     char* send_buffer;
     if (send_nnz)
         send_buffer = (char*)(sendvals);
-    int send_bytes, recv_bytes;
-    MPI_Type_size(sendtype, &send_bytes);
-    MPI_Type_size(recvtype, &recv_bytes);
-    send_bytes *= sendcount;
-    recv_bytes *= recvcount;
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
 
     int proc, ctr, flag, ibar;
     MPI_Status recv_status;
@@ -209,7 +207,7 @@ int alltoall_crs_nonblocking(int send_nnz, int* dest, int sendcount,
     for (int i = 0; i < send_nnz; i++)
     {
         proc = dest[i];
-        MPI_Issend(&(send_buffer[i*send_bytes]), send_bytes, MPI_BYTE, proc, tag,
+        MPI_Issend(&(send_buffer[i*sendcount*send_extent]), sendcount, sendtype, proc, tag,
                 comm->global_comm, &(comm->requests[i]));
     }
 
@@ -223,7 +221,7 @@ int alltoall_crs_nonblocking(int send_nnz, int* dest, int sendcount,
             char* recv_buffer = (char*)recvvals;
             proc = recv_status.MPI_SOURCE;
             src[ctr] = proc;
-            MPI_Recv(&(recv_buffer[ctr*recv_bytes]), recv_bytes, MPI_BYTE, proc, tag,
+            MPI_Recv(&(recv_buffer[ctr*recvcount*recv_extent]), recvcount, recvtype, proc, tag,
                     comm->global_comm, &recv_status);
             ctr++;
         }
@@ -273,6 +271,8 @@ int alltoallv_crs_personalized(int send_nnz, int send_size, int* dest, int* send
     int send_bytes, recv_bytes;
     MPI_Type_size(sendtype, &send_bytes);
     MPI_Type_size(recvtype, &recv_bytes);
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
 
     if (!(xinfo->crs_num_initialized) && !(xinfo->crs_size_initialized))
     {
@@ -299,23 +299,22 @@ int alltoallv_crs_personalized(int send_nnz, int send_size, int* dest, int* send
     for (int i = 0; i < send_nnz; i++)
     {
         proc = dest[i];
-        MPI_Isend(&(send_buffer[sdispls[i]*send_bytes]), sendcounts[i]*send_bytes, MPI_BYTE, 
+        MPI_Isend(&(send_buffer[sdispls[i]*send_extent]), sendcounts[i], sendtype, 
                 proc, tag, comm->global_comm, &(comm->requests[i]));
     }
 
     ctr = 0;
     idx = 0;
     rdispls[0] = 0;
-    int bytes = *recv_size * recv_bytes;
-    while (ctr < bytes)
+    while (ctr < *recv_size)
     {
         MPI_Probe(MPI_ANY_SOURCE, tag, comm->global_comm, &recv_status);
-        MPI_Get_count(&recv_status, MPI_BYTE, &count);
+        MPI_Get_count(&recv_status, recvtype, &count);
         proc = recv_status.MPI_SOURCE;
         src[idx] = proc;
-        recvcounts[idx] = count / recv_bytes;
+        recvcounts[idx] = count;
         rdispls[idx+1] = rdispls[idx] + recvcounts[idx];
-        MPI_Recv(&(recv_buffer[ctr]), count, MPI_BYTE, proc, tag,
+        MPI_Recv(&(recv_buffer[rdispls[idx]*recv_extent]), count, recvtype, proc, tag,
                 comm->global_comm, &recv_status);
         ctr += count;
         idx++;
@@ -341,9 +340,8 @@ int alltoallv_crs_nonblocking(int send_nnz, int send_size, int* dest, int* sendc
 
     char* send_buffer = (char*)sendvals;
     char* recv_buffer = (char*)recvvals;
-    int send_bytes, recv_bytes;
-    MPI_Type_size(sendtype, &send_bytes);
-    MPI_Type_size(recvtype, &recv_bytes);
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
 
     int proc, ctr, flag, ibar, idx, count;
     MPI_Status recv_status;
@@ -357,7 +355,7 @@ int alltoallv_crs_nonblocking(int send_nnz, int send_size, int* dest, int* sendc
     for (int i = 0; i < send_nnz; i++)
     {
         proc = dest[i];
-        MPI_Issend(&(send_buffer[sdispls[i]*send_bytes]), sendcounts[i]*send_bytes, MPI_BYTE, 
+        MPI_Issend(&(send_buffer[sdispls[i]*send_extent]), sendcounts[i], sendtype, 
                 proc, tag, comm->global_comm, &(comm->requests[i]));
     }
 
@@ -370,12 +368,12 @@ int alltoallv_crs_nonblocking(int send_nnz, int send_size, int* dest, int* sendc
         if (flag)
         {
             MPI_Probe(MPI_ANY_SOURCE, tag, comm->global_comm, &recv_status);
-            MPI_Get_count(&recv_status, MPI_BYTE, &count);
+            MPI_Get_count(&recv_status, recvtype, &count);
             proc = recv_status.MPI_SOURCE;
             src[idx] = proc;
-            recvcounts[idx] = count / recv_bytes;
+            recvcounts[idx] = count;
             rdispls[idx+1] = rdispls[idx] + recvcounts[idx];
-            MPI_Recv(&(recv_buffer[ctr]), count, MPI_BYTE, proc, tag,
+            MPI_Recv(&(recv_buffer[rdispls[idx]*recv_extent]), count, recvtype, proc, tag,
                     comm->global_comm, &recv_status);
             ctr += count;
             idx++;
@@ -397,7 +395,7 @@ int alltoallv_crs_nonblocking(int send_nnz, int send_size, int* dest, int* sendc
         }
     }
     *recv_nnz = idx;
-    *recv_size = ctr / recv_bytes;
+    *recv_size = ctr;
 
     return MPI_SUCCESS;
 }
@@ -25,6 +25,8 @@ int alltoall_crs_personalized_loc(int send_nnz, int* dest, int sendcount,
     MPI_Type_size(sendtype, &send_bytes);
     MPI_Type_size(recvtype, &recv_bytes);
     MPI_Type_size(MPI_INT, &int_bytes);
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
     send_bytes *= sendcount;
     recv_bytes *= recvcount;
 
@@ -38,8 +40,6 @@ int alltoall_crs_personalized_loc(int send_nnz, int* dest, int sendcount,
     MPIX_Info_tag(xinfo, &tag);
 
     std::vector<char> node_send_buffer;
-    std::vector<char> local_send_buffer;
-    std::vector<char> local_recv_buffer;
 
     count = send_nnz * (send_bytes + int_bytes);
     if (count)
@@ -72,7 +72,7 @@ int alltoall_crs_personalized_loc(int send_nnz, int* dest, int sendcount,
         }
         MPI_Pack(&proc, 1, MPI_INT, node_send_buffer.data(), node_send_buffer.size(), 
                 &(msg_displs[node]), comm->group_comm);
-        MPI_Pack(&(send_buffer[i*send_bytes]), sendcount, sendtype, node_send_buffer.data(),
+        MPI_Pack(&(send_buffer[i*sendcount*send_extent]), sendcount, sendtype, node_send_buffer.data(),
                 node_send_buffer.size(), &(msg_displs[node]), comm->group_comm);
     }
     msg_displs[0] = 0;
@@ -141,9 +141,10 @@ int alltoall_crs_personalized_loc(int send_nnz, int* dest, int sendcount,
     for (int i = 0; i < PPN; i++)
         displs[i+1] = displs[i] + msg_counts[i];
     
-    count = recv_buf.size();
-    if (count)
-        local_send_buffer.resize(count);
+    // On-node redistribution through node-shared memory
+    // Pack directly into my segment, local ranks copy their portions out
+    MPIX_Comm_shm_init(comm, displs[PPN]);
+    char* local_send_buffer = MPIX_Comm_shm_buffer(comm);
 
     ctr = 0;
     idx = 0;
@@ -152,71 +153,37 @@ int alltoall_crs_personalized_loc(int send_nnz, int* dest, int sendcount,
         MPI_Unpack(recv_buf.data(), node_recv_size, &ctr, &proc, 1, MPI_INT, comm->group_comm);
         proc -= (comm->rank_node * PPN);
 
-        MPI_Pack(&(origins[idx++]), 1, MPI_INT, local_send_buffer.data(),
-                local_send_buffer.size(), &(displs[proc]), comm->local_comm);
-        MPI_Pack(&(recv_buf[ctr]), recv_bytes, MPI_PACKED, local_send_buffer.data(),
-                local_send_buffer.size(), &(displs[proc]), comm->local_comm);
+        MPI_Pack(&(origins[idx++]), 1, MPI_INT, local_send_buffer,
+                comm->shm_bytes, &(displs[proc]), comm->local_comm);
+        MPI_Pack(&(recv_buf[ctr]), recv_bytes, MPI_PACKED, local_send_buffer,
+                comm->shm_bytes, &(displs[proc]), comm->local_comm);
         ctr += recv_bytes;
     }
     displs[0] = 0;
     for (int i = 0; i < PPN; i++)
         displs[i+1] = displs[i] + msg_counts[i];
 
-    MPIX_Info_tag(xinfo, &tag);
-
-    MPI_Allreduce(MPI_IN_PLACE, msg_counts.data(), PPN, MPI_INT, MPI_SUM, comm->local_comm);
-    int recv_count = msg_counts[local_rank];
-    if (PPN > comm->n_requests)
-        MPIX_Comm_req_resize(comm, PPN);
-
-    // Send a message to every process that I will need data from
-    // Tell them which global indices I need from them
-    n_sends = 0;
-    for (int i = 0; i < PPN; i++)
-    {
-        if (displs[i+1] == displs[i])
-            continue;
+    MPIX_Comm_shm_post(comm, local_send_buffer, msg_counts.data(), displs.data());
 
-        MPI_Isend(&(local_send_buffer[displs[i]]), displs[i+1] - displs[i], MPI_PACKED, i, tag,
-                comm->local_comm, &(comm->requests[n_sends++]));
-    }
-
-    count = recv_count * (recv_bytes + int_bytes);
-    if (count)
-        local_recv_buffer.resize(count);
-
-    // Wait to receive values
-    // until I have received fewer than the number of global indices I am waiting on
-    ctr = 0;
-    while(ctr < recv_count)
-    {
-        // Wait for a message
-        MPI_Probe(MPI_ANY_SOURCE, tag, comm->local_comm, &recv_status);
-
-        // Get the source process and message size
-        proc = recv_status.MPI_SOURCE;
-        MPI_Get_count(&recv_status, MPI_PACKED, &count);
-
-        // Receive the message, and add local indices to send_comm
-        MPI_Recv(&(local_recv_buffer[ctr]), count, MPI_PACKED, proc, tag, 
-                comm->local_comm, MPI_STATUS_IGNORE);
-        ctr += count;
-    }
-    if (n_sends) MPI_Waitall(n_sends, comm->requests, MPI_STATUSES_IGNORE);
-
-    // Last Step : Step through recvbuf to find proc of origin, size, and indices
-    idx = 0;
+    // Last Step : Step through each local rank's posted data (in
+    // place) to find proc of origin, size, and indices
     new_idx = 0;
     n_recvs = 0;
-    while (idx < ctr)
+    for (int i = 0; i < PPN; i++)
     {
-        MPI_Unpack(local_recv_buffer.data(), local_recv_buffer.size(), &idx,
-                &proc, 1, MPI_INT, comm->local_comm);
-        MPI_Unpack(local_recv_buffer.data(), local_recv_buffer.size(), &idx,
-                &(recv_buffer[new_idx]), recv_bytes, MPI_BYTE, comm->local_comm);
-        src[n_recvs++] = proc;
-        new_idx += recv_bytes;
+        const char* local_data = MPIX_Comm_shm_peer(comm, i, &ctr);
+        idx = 0;
+        while (idx < ctr)
+        {
+            MPI_Unpack(local_data, ctr, &idx,
+                    &proc, 1, MPI_INT, comm->local_comm);
+            MPI_Unpack(local_data, ctr, &idx,
+                    &(recv_buffer[new_idx]), recvcount, recvtype, comm->local_comm);
+            src[n_recvs++] = proc;
+            new_idx += recvcount*recv_extent;
+        }
     }
+    MPIX_Comm_shm_release(comm);
     *recv_nnz = n_recvs;
 
     return MPI_SUCCESS;
@@ -246,6 +213,8 @@ int alltoall_crs_nonblocking_loc(int send_nnz, int* dest, int sendcount,
     MPI_Type_size(sendtype, &send_bytes);
     MPI_Type_size(recvtype, &recv_bytes);
     MPI_Type_size(MPI_INT, &int_bytes);
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
     send_bytes *= sendcount;
     recv_bytes *= recvcount;
 
@@ -260,8 +229,6 @@ int alltoall_crs_nonblocking_loc(int send_nnz, int* dest, int sendcount,
     MPIX_Info_tag(xinfo, &tag);
 
     std::vector<char> node_send_buffer;
-    std::vector<char> local_send_buffer;
-    std::vector<char> local_recv_buffer;
 
     count = send_nnz * (send_bytes + int_bytes);
     if (count)
@@ -294,7 +261,7 @@ int alltoall_crs_nonblocking_loc(int send_nnz, int* dest, int sendcount,
         }
         MPI_Pack(&proc, 1, MPI_INT, node_send_buffer.data(), node_send_buffer.size(), 
                 &(msg_displs[node]), comm->group_comm);
-        MPI_Pack(&(send_buffer[i*send_bytes]), sendcount, sendtype, node_send_buffer.data(),
+        MPI_Pack(&(send_buffer[i*sendcount*send_extent]), sendcount, sendtype, node_send_buffer.data(),
                 node_send_buffer.size(), &(msg_displs[node]), comm->group_comm);
     }
     msg_displs[0] = 0;
@@ -383,10 +350,10 @@ int alltoall_crs_nonblocking_loc(int send_nnz, int* dest, int sendcount,
     for (int i = 0; i < PPN; i++)
         displs[i+1] = displs[i] + msg_counts[i];
     
-    count = recv_buf.size();
-    if (count)
-        local_send_buffer.resize(count);
-
+    // On-node redistribution through node-shared memory
+    // Pack directly into my segment, local ranks copy their portions out
+    MPIX_Comm_shm_init(comm, displs[PPN]);
+    char* local_send_buffer = MPIX_Comm_shm_buffer(comm);
 
     ctr = 0;
     idx = 0;
@@ -395,71 +362,37 @@ int alltoall_crs_nonblocking_loc(int send_nnz, int* dest, int sendcount,
         MPI_Unpack(recv_buf.data(), node_recv_size, &ctr, &proc, 1, MPI_INT, comm->group_comm);
         proc -= (comm->rank_node * PPN);
 
-        MPI_Pack(&(origins[idx++]), 1, MPI_INT, local_send_buffer.data(),
-               local_send_buffer.size(), &(displs[proc]), comm->local_comm);
-        MPI_Pack(&(recv_buf[ctr]), recv_bytes, MPI_PACKED, local_send_buffer.data(),
-               local_send_buffer.size(), &(displs[proc]), comm->local_comm);
+        MPI_Pack(&(origins[idx++]), 1, MPI_INT, local_send_buffer,
+                comm->shm_bytes, &(displs[proc]), comm->local_comm);
+        MPI_Pack(&(recv_buf[ctr]), recv_bytes, MPI_PACKED, local_send_buffer,
+                comm->shm_bytes, &(displs[proc]), comm->local_comm);
         ctr += recv_bytes;
     }
     displs[0] = 0;
     for (int i = 0; i < PPN; i++)
         displs[i+1] = displs[i] + msg_counts[i];
 
-    MPIX_Info_tag(xinfo, &tag);
-
-    MPI_Allreduce(MPI_IN_PLACE, msg_counts.data(), PPN, MPI_INT, MPI_SUM, comm->local_comm);
-    int recv_count = msg_counts[local_rank];
-    if (PPN > comm->n_requests)
-        MPIX_Comm_req_resize(comm, PPN);
-
-    // Send a message to every process that I will need data from
-    // Tell them which global indices I need from them
-    n_sends = 0;
-    for (int i = 0; i < PPN; i++)
-    {
-        if (displs[i+1] == displs[i])
-            continue;
-
-        MPI_Isend(&(local_send_buffer[displs[i]]), displs[i+1] - displs[i], MPI_PACKED, i, tag,
-                comm->local_comm, &(comm->requests[n_sends++]));
-    }
-
-    count = recv_count * (recv_bytes + int_bytes);
-    if (count)
-        local_recv_buffer.resize(count);
-
-    // Wait to receive values
-    // until I have received fewer than the number of global indices I am waiting on
-    ctr = 0;
-    while(ctr < recv_count)
-    {
-        // Wait for a message
-        MPI_Probe(MPI_ANY_SOURCE, tag, comm->local_comm, &recv_status);
-
-        // Get the source process and message size
-        proc = recv_status.MPI_SOURCE;
-        MPI_Get_count(&recv_status, MPI_PACKED, &count);
-
-        // Receive the message, and add local indices to send_comm
-        MPI_Recv(&(local_recv_buffer[ctr]), count, MPI_PACKED, proc, tag, 
-                comm->local_comm, MPI_STATUS_IGNORE);
-        ctr += count;
-    }
-    if (n_sends) MPI_Waitall(n_sends, comm->requests, MPI_STATUSES_IGNORE);
+    MPIX_Comm_shm_post(comm, local_send_buffer, msg_counts.data(), displs.data());
 
-    // Last Step : Step through recvbuf to find proc of origin, size, and indices
-    idx = 0;
+    // Last Step : Step through each local rank's posted data (in
+    // place) to find proc of origin, size, and indices
     new_idx = 0;
     n_recvs = 0;
-    while (idx < ctr)
+    for (int i = 0; i < PPN; i++)
     {
-        MPI_Unpack(local_recv_buffer.data(), local_recv_buffer.size(), &idx, 
-                &proc, 1, MPI_INT, comm->local_comm);
-        MPI_Unpack(local_recv_buffer.data(), local_recv_buffer.size(), &idx,
-                &(recv_buffer[new_idx]), recv_bytes, MPI_PACKED, comm->local_comm);
-        src[n_recvs++] = proc;
-        new_idx += recv_bytes;
+        const char* local_data = MPIX_Comm_shm_peer(comm, i, &ctr);
+        idx = 0;
+        while (idx < ctr)
+        {
+            MPI_Unpack(local_data, ctr, &idx,
+                    &proc, 1, MPI_INT, comm->local_comm);
+            MPI_Unpack(local_data, ctr, &idx,
+                    &(recv_buffer[new_idx]), recvcount, recvtype, comm->local_comm);
+            src[n_recvs++] = proc;
+            new_idx += recvcount*recv_extent;
+        }
     }
+    MPIX_Comm_shm_release(comm);
     *recv_nnz = n_recvs;
 
     return MPI_SUCCESS;
@@ -493,6 +426,8 @@ int alltoallv_crs_personalized_loc(int send_nnz, int send_size, int* dest, int*
     MPI_Type_size(sendtype, &send_bytes);
     MPI_Type_size(recvtype, &recv_bytes);
     MPI_Type_size(MPI_INT, &int_bytes);
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
 
     std::vector<char> node_send_buffer(send_size*send_bytes + 2*send_nnz*int_bytes);
     std::vector<int> sizes(PPN, 0);
@@ -527,7 +462,7 @@ int alltoallv_crs_personalized_loc(int send_nnz, int send_size, int* dest, int*
         }
         MPI_Pack(&proc, 1, MPI_INT, node_send_buffer.data(), node_send_buffer.size(), &(msg_displs[node]), comm->group_comm);
         MPI_Pack(&(s), 1, MPI_INT, node_send_buffer.data(), node_send_buffer.size(), &(msg_displs[node]), comm->group_comm);
-        MPI_Pack(&(send_buffer[sdispls[i]*send_bytes]), sendcounts[i], sendtype, node_send_buffer.data(), node_send_buffer.size(), &(msg_displs[node]), comm->group_comm);
+        MPI_Pack(&(send_buffer[sdispls[i]*send_extent]), sendcounts[i], sendtype, node_send_buffer.data(), node_send_buffer.size(), &(msg_displs[node]), comm->group_comm);
     }
     msg_displs[0] = 0;
     for (int i = 0; i < group_procs; i++)
@@ -587,9 +522,9 @@ int alltoallv_crs_personalized_loc(int send_nnz, int send_size, int* dest, int*
     std::vector<int> recv_sizes(PPN, 0);
     std::vector<int> recv_displs(PPN+1);
 
-    std::vector<char> local_buf;
-    if (origin_displs[n_recvs])
-        local_buf.resize(origin_displs[n_recvs]);
+    // Pack on-node messages directly into my node-shared segment
+    MPIX_Comm_shm_init(comm, origin_displs[n_recvs]);
+    char* local_buf = MPIX_Comm_shm_buffer(comm);
 
     int idx = 0;
     std::vector<char> recv_byte_buf;
@@ -624,10 +559,10 @@ int alltoallv_crs_personalized_loc(int send_nnz, int send_size, int* dest, int*
             MPI_Unpack(recv_byte_buf.data(), recv_byte_buf.size(), &idx, &count, 1, MPI_INT, comm->local_comm);
             proc -= (comm->rank_node*PPN);
 
-            MPI_Pack(&origin, 1, MPI_INT, local_buf.data(), local_buf.size(), &(recv_displs[proc]), comm->local_comm);
-            MPI_Pack(&count, 1, MPI_INT, local_buf.data(), local_buf.size(), &(recv_displs[proc]), comm->local_comm);
+            MPI_Pack(&origin, 1, MPI_INT, local_buf, comm->shm_bytes, &(recv_displs[proc]), comm->local_comm);
+            MPI_Pack(&count, 1, MPI_INT, local_buf, comm->shm_bytes, &(recv_displs[proc]), comm->local_comm);
             
-            MPI_Pack(&(recv_byte_buf[idx]), count, MPI_PACKED, local_buf.data(), local_buf.size(), &(recv_displs[proc]), comm->local_comm);
+            MPI_Pack(&(recv_byte_buf[idx]), count, MPI_PACKED, local_buf, comm->shm_bytes, &(recv_displs[proc]), comm->local_comm);
             idx += count;
         }
     }
@@ -636,64 +571,32 @@ int alltoallv_crs_personalized_loc(int send_nnz, int send_size, int* dest, int*
     for (int i = 0; i < PPN; i++)
         recv_displs[i+1] = recv_displs[i] + recv_sizes[i];
 
-    // STEP 2 : Local Communication
-    MPI_Allreduce(MPI_IN_PLACE, recv_sizes.data(), PPN, MPI_INT, MPI_SUM, comm->local_comm);
-    int local_size_msgs = recv_sizes[local_rank];
+    // STEP 2 : Local Communication (through node-shared memory)
+    MPIX_Comm_shm_post(comm, local_buf, recv_sizes.data(), recv_displs.data());
 
-    // Send a message to every process that I will need data from
-    // Tell them which global indices I need from them
-    std::vector<MPI_Request> local_req(PPN);
-
-    MPIX_Info_tag(xinfo, &tag);
-
-    n_sends = 0;
-    for (int i = 0; i < PPN; i++)
-    {
-        int s = recv_displs[i+1] - recv_displs[i];
-        if (s)
-        {
-            MPI_Isend(&(local_buf[recv_displs[i]]), s, MPI_PACKED, i, tag,
-                    comm->local_comm, &(local_req[n_sends++]));
-        }
-    }
-
-    // Wait to receive values
-    // until I have received fewer than the number of global indices I am waiting on
-    std::vector<char> local_recv_buffer(local_size_msgs);
-
-    ctr = 0;
-    while (ctr < local_size_msgs)
-    {
-        // Wait for a message
-        MPI_Probe(MPI_ANY_SOURCE, tag, comm->local_comm, &recv_status);
-
-        // Get the source process and message size
-        proc = recv_status.MPI_SOURCE;
-        MPI_Get_count(&recv_status, MPI_PACKED, &count);
-
-        // Receive the message, and add local indices to send_comm
-        MPI_Recv(&(local_recv_buffer[ctr]), count, MPI_PACKED, proc, tag, comm->local_comm, &recv_status);
-        ctr += count;
-    }
-    if (n_sends) MPI_Waitall(n_sends, local_req.data(), MPI_STATUSES_IGNORE);
-
-
-// Last Step : Step through recvbuf to find proc of origin, size, and indices
+    // Last Step : Step through each local rank's posted data (in
+    // place) to find proc of origin, size, and indices
     rdispls[0] = 0;
     n_recvs = 0;
-    int byte_ctr = 0;
-    while (byte_ctr < local_size_msgs)
+    for (int i = 0; i < PPN; i++)
     {
-        MPI_Unpack(local_recv_buffer.data(), local_recv_buffer.size(), &byte_ctr, &(src[n_recvs]), 1, MPI_INT, comm->local_comm);
-        MPI_Unpack(local_recv_buffer.data(), local_recv_buffer.size(), &byte_ctr, &count, 1, MPI_INT, comm->local_comm);
-        count = count / recv_bytes;
+        int local_size;
+        const char* local_data = MPIX_Comm_shm_peer(comm, i, &local_size);
+        int byte_ctr = 0;
+        while (byte_ctr < local_size)
+        {
+            MPI_Unpack(local_data, local_size, &byte_ctr, &(src[n_recvs]), 1, MPI_INT, comm->local_comm);
+            MPI_Unpack(local_data, local_size, &byte_ctr, &count, 1, MPI_INT, comm->local_comm);
+            count = count / recv_bytes;
 
-        MPI_Unpack(local_recv_buffer.data(), local_recv_buffer.size(), &byte_ctr, &(recv_buffer[rdispls[n_recvs]*recv_bytes]), count, recvtype, comm->local_comm);
+            MPI_Unpack(local_data, local_size, &byte_ctr, &(recv_buffer[rdispls[n_recvs]*recv_extent]), count, recvtype, comm->local_comm);
 
-        recvcounts[n_recvs] = count;
-        rdispls[n_recvs+1] = rdispls[n_recvs] + count;
-        n_recvs++;
+            recvcounts[n_recvs] = count;
+            rdispls[n_recvs+1] = rdispls[n_recvs] + count;
+            n_recvs++;
+        }
     }
+    MPIX_Comm_shm_release(comm);
     // Set send sizes
     *recv_nnz = n_recvs;
     *recv_size = rdispls[n_recvs];
@@ -728,6 +631,8 @@ int alltoallv_crs_nonblocking_loc(int send_nnz, int send_size, int* dest, int* s
     MPI_Type_size(sendtype, &send_bytes);
     MPI_Type_size(recvtype, &recv_bytes);
     MPI_Type_size(MPI_INT, &int_bytes);
+    MPI_Aint send_extent = MPIX_Type_extent(sendtype);
+    MPI_Aint recv_extent = MPIX_Type_extent(recvtype);
 
     std::vector<char> node_send_buffer(send_size*send_bytes + 2*send_nnz*int_bytes);
     std::vector<int> sizes(PPN, 0);
@@ -764,7 +669,7 @@ int alltoallv_crs_nonblocking_loc(int send_nnz, int send_size, int* dest, int* s
         }
         MPI_Pack(&proc, 1, MPI_INT, node_send_buffer.data(), node_send_buffer.size(), &(msg_displs[node]), comm->group_comm);
         MPI_Pack(&(s), 1, MPI_INT, node_send_buffer.data(), node_send_buffer.size(), &(msg_displs[node]), comm->group_comm);
-        MPI_Pack(&(send_buffer[sdispls[i]*send_bytes]), sendcounts[i], sendtype, node_send_buffer.data(), node_send_buffer.size(), &(msg_displs[node]), comm->group_comm);
+        MPI_Pack(&(send_buffer[sdispls[i]*send_extent]), sendcounts[i], sendtype, node_send_buffer.data(), node_send_buffer.size(), &(msg_displs[node]), comm->group_comm);
     }
     msg_displs[0] = 0;
     for (int i = 0; i < group_procs; i++)
@@ -843,9 +748,9 @@ int alltoallv_crs_nonblocking_loc(int send_nnz, int send_size, int* dest, int* s
     std::vector<int> recv_sizes(PPN, 0);
     std::vector<int> recv_displs(PPN+1);
 
-    std::vector<char> local_buf;
-    if (origin_displs[n_recvs])
-        local_buf.resize(origin_displs[n_recvs]);
+    // Pack on-node messages directly into my node-shared segment
+    MPIX_Comm_shm_init(comm, origin_displs[n_recvs]);
+    char* local_buf = MPIX_Comm_shm_buffer(comm);
 
     int idx = 0;
     std::vector<char> recv_byte_buf;
@@ -880,10 +785,10 @@ int alltoallv_crs_nonblocking_loc(int send_nnz, int send_size, int* dest, int* s
             MPI_Unpack(recv_byte_buf.data(), recv_byte_buf.size(), &idx, &count, 1, MPI_INT, comm->local_comm);
             proc -= (comm->rank_node*PPN);
 
-            MPI_Pack(&origin, 1, MPI_INT, local_buf.data(), local_buf.size(), &(recv_displs[proc]), comm->local_comm);
-            MPI_Pack(&count, 1, MPI_INT, local_buf.data(), local_buf.size(), &(recv_displs[proc]), comm->local_comm);
+            MPI_Pack(&origin, 1, MPI_INT, local_buf, comm->shm_bytes, &(recv_displs[proc]), comm->local_comm);
+            MPI_Pack(&count, 1, MPI_INT, local_buf, comm->shm_bytes, &(recv_displs[proc]), comm->local_comm);
             
-            MPI_Pack(&(recv_byte_buf[idx]), count, MPI_PACKED, local_buf.data(), local_buf.size(), &(recv_displs[proc]), comm->local_comm);
+            MPI_Pack(&(recv_byte_buf[idx]), count, MPI_PACKED, local_buf, comm->shm_bytes, &(recv_displs[proc]), comm->local_comm);
             idx += count;
         }
     }
@@ -892,64 +797,32 @@ int alltoallv_crs_nonblocking_loc(int send_nnz, int send_size, int* dest, int* s
     for (int i = 0; i < PPN; i++)
         recv_displs[i+1] = recv_displs[i] + recv_sizes[i];
 
-    // STEP 2 : Local Communication
-    MPI_Allreduce(MPI_IN_PLACE, recv_sizes.data(), PPN, MPI_INT, MPI_SUM, comm->local_comm);
-    int local_size_msgs = recv_sizes[local_rank];
-
-    // Send a message to every process that I will need data from
-    // Tell them which global indices I need from them
-    std::vector<MPI_Request> local_req(PPN);
-
-    MPIX_Info_tag(xinfo, &tag);
-
-    n_sends = 0;
-    for (int i = 0; i < PPN; i++)
-    {
-        int s = recv_displs[i+1] - recv_displs[i];
-        if (s)
-        {
-            MPI_Isend(&(local_buf[recv_displs[i]]), s, MPI_PACKED, i, tag,
-                    comm->local_comm, &(local_req[n_sends++]));
-        }
-    }
-
-    // Wait to receive values
-    // until I have received fewer than the number of global indices I am waiting on
-    std::vector<char> local_recv_buffer(local_size_msgs);
-
-    ctr = 0;
-    while (ctr < local_size_msgs)
-    {
-        // Wait for a message
-        MPI_Probe(MPI_ANY_SOURCE, tag, comm->local_comm, &recv_status);
-
-        // Get the source process and message size
-        proc = recv_status.MPI_SOURCE;
-        MPI_Get_count(&recv_status, MPI_PACKED, &count);
-
-        // Receive the message, and add local indices to send_comm
-        MPI_Recv(&(local_recv_buffer[ctr]), count, MPI_PACKED, proc, tag, comm->local_comm, &recv_status);
-        ctr += count;
-    }
-    if (n_sends) MPI_Waitall(n_sends, local_req.data(), MPI_STATUSES_IGNORE);
+    // STEP 2 : Local Communication (through node-shared memory)
+    MPIX_Comm_shm_post(comm, local_buf, recv_sizes.data(), recv_displs.data());
 
-
-// Last Step : Step through recvbuf to find proc of origin, size, and indices
+    // Last Step : Step through each local rank's posted data (in
+    // place) to find proc of origin, size, and indices
     rdispls[0] = 0;
     n_recvs = 0;
-    int byte_ctr = 0;
-    while (byte_ctr < local_size_msgs)
+    for (int i = 0; i < PPN; i++)
     {
-        MPI_Unpack(local_recv_buffer.data(), local_recv_buffer.size(), &byte_ctr, &(src[n_recvs]), 1, MPI_INT, comm->local_comm);
-        MPI_Unpack(local_recv_buffer.data(), local_recv_buffer.size(), &byte_ctr, &count, 1, MPI_INT, comm->local_comm);
-        count = count / recv_bytes;
+        int local_size;
+        const char* local_data = MPIX_Comm_shm_peer(comm, i, &local_size);
+        int byte_ctr = 0;
+        while (byte_ctr < local_size)
+        {
+            MPI_Unpack(local_data, local_size, &byte_ctr, &(src[n_recvs]), 1, MPI_INT, comm->local_comm);
+            MPI_Unpack(local_data, local_size, &byte_ctr, &count, 1, MPI_INT, comm->local_comm);
+            count = count / recv_bytes;
 
-        MPI_Unpack(local_recv_buffer.data(), local_recv_buffer.size(), &byte_ctr, &(recv_buffer[rdispls[n_recvs]*recv_bytes]), count, recvtype, comm->local_comm);
+            MPI_Unpack(local_data, local_size, &byte_ctr, &(recv_buffer[rdispls[n_recvs]*recv_extent]), count, recvtype, comm->local_comm);
 
-        recvcounts[n_recvs] = count;
-        rdispls[n_recvs+1] = rdispls[n_recvs] + count;
-        n_recvs++;
+            recvcounts[n_recvs] = count;
+            rdispls[n_recvs+1] = rdispls[n_recvs] + count;
+            n_recvs++;
+        }
     }
+    MPIX_Comm_shm_release(comm);
     // Set send sizes
     *recv_nnz = n_recvs;
     *recv_size = rdispls[n_recvs];
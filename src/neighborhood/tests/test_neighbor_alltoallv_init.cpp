@@ -158,6 +158,139 @@ TEST(RandomCommTest, TestsInTests)
         ASSERT_EQ(std_recv_vals[i], loc_recv_vals[i]);
     }
 
+    // Polling : MPIX_Test advances the locality-aware phases, and
+    // MPIX_Testall / MPIX_Waitall complete several requests
+    MPIX_Request* requests[2];
+    MPIX_Neighbor_alltoallv_init(alltoallv_send_vals.data(), 
+            send_data.counts.data(),
+            send_data.indptr.data(), 
+            MPI_INT,
+            persistent_recv_vals.data(), 
+            recv_data.counts.data(),
+            recv_data.indptr.data(), 
+            MPI_INT,
+            neighbor_comm, 
+            xinfo,
+            &(requests[0]));
+    MPIX_Neighbor_locality_alltoallv_init(alltoallv_send_vals.data(), 
+            send_data.counts.data(),
+            send_data.indptr.data(), 
+            global_send_idx.data(),
+            MPI_INT,
+            loc_recv_vals.data(), 
+            recv_data.counts.data(),
+            recv_data.indptr.data(), 
+            global_recv_idx.data(),
+            MPI_INT,
+            neighbor_comm, 
+            xinfo,
+            &(requests[1]));
+
+    // Each forwarded local_R value depends on one global message
+    LocalityComm* locality = requests[1]->locality;
+    ASSERT_EQ(locality->global_to_R_ptr[locality->global_comm->recv_data->num_msgs],
+            locality->local_R_comm->send_data->size_msgs);
+
+    int flag = 0;
+    for (int i = 0; i < recv_data.size_msgs; i++)
+        loc_recv_vals[i] = -1;
+    MPIX_Start(requests[1]);
+    while (!flag)
+        MPIX_Test(requests[1], &flag, &status);
+    ASSERT_EQ(requests[1]->phase, MPIX_PHASE_COMPLETE);
+    MPIX_Test(requests[1], &flag, &status);
+    ASSERT_EQ(flag, 1);
+    for (int i = 0; i < recv_data.size_msgs; i++)
+    {
+        ASSERT_EQ(std_recv_vals[i], loc_recv_vals[i]);
+    }
+
+    for (int i = 0; i < recv_data.size_msgs; i++)
+    {
+        persistent_recv_vals[i] = -1;
+        loc_recv_vals[i] = -1;
+    }
+    flag = 0;
+    MPIX_Start(requests[0]);
+    MPIX_Start(requests[1]);
+    while (!flag)
+        MPIX_Testall(2, requests, &flag, MPI_STATUSES_IGNORE);
+    for (int i = 0; i < recv_data.size_msgs; i++)
+    {
+        ASSERT_EQ(std_recv_vals[i], persistent_recv_vals[i]);
+        ASSERT_EQ(std_recv_vals[i], loc_recv_vals[i]);
+    }
+
+    for (int i = 0; i < recv_data.size_msgs; i++)
+    {
+        persistent_recv_vals[i] = -1;
+        loc_recv_vals[i] = -1;
+    }
+    MPIX_Start(requests[0]);
+    MPIX_Start(requests[1]);
+    MPIX_Waitall(2, requests, MPI_STATUSES_IGNORE);
+    for (int i = 0; i < recv_data.size_msgs; i++)
+    {
+        ASSERT_EQ(std_recv_vals[i], persistent_recv_vals[i]);
+        ASSERT_EQ(std_recv_vals[i], loc_recv_vals[i]);
+    }
+    MPIX_Request_free(&(requests[0]));
+    MPIX_Request_free(&(requests[1]));
+
+    // Two outstanding locality-aware requests, started in a different
+    // order on each rank and polled together : on-node phases never
+    // synchronize the node, so neither may block the other
+    std::vector<int> alltoallv_send_vals2(send_data.size_msgs);
+    std::vector<int> loc_recv_vals2(recv_data.size_msgs);
+    for (int i = 0; i < send_data.size_msgs; i++)
+        alltoallv_send_vals2[i] = 2*alltoallv_send_vals[i];
+    MPIX_Neighbor_locality_alltoallv_init(alltoallv_send_vals.data(), 
+            send_data.counts.data(),
+            send_data.indptr.data(), 
+            global_send_idx.data(),
+            MPI_INT,
+            loc_recv_vals.data(), 
+            recv_data.counts.data(),
+            recv_data.indptr.data(), 
+            global_recv_idx.data(),
+            MPI_INT,
+            neighbor_comm, 
+            xinfo,
+            &(requests[0]));
+    MPIX_Neighbor_locality_alltoallv_init(alltoallv_send_vals2.data(), 
+            send_data.counts.data(),
+            send_data.indptr.data(), 
+            global_send_idx.data(),
+            MPI_INT,
+            loc_recv_vals2.data(), 
+            recv_data.counts.data(),
+            recv_data.indptr.data(), 
+            global_recv_idx.data(),
+            MPI_INT,
+            neighbor_comm, 
+            xinfo,
+            &(requests[1]));
+    for (int iter = 0; iter < 2; iter++)
+    {
+        for (int i = 0; i < recv_data.size_msgs; i++)
+        {
+            loc_recv_vals[i] = -1;
+            loc_recv_vals2[i] = -1;
+        }
+        MPIX_Start(requests[rank % 2]);
+        MPIX_Start(requests[(rank + 1) % 2]);
+        flag = 0;
+        while (!flag)
+            MPIX_Testall(2, requests, &flag, MPI_STATUSES_IGNORE);
+        for (int i = 0; i < recv_data.size_msgs; i++)
+        {
+            ASSERT_EQ(std_recv_vals[i], loc_recv_vals[i]);
+            ASSERT_EQ(2*std_recv_vals[i], loc_recv_vals2[i]);
+        }
+    }
+    MPIX_Request_free(&(requests[0]));
+    MPIX_Request_free(&(requests[1]));
+
     // Partial Locality-Aware MPI Advance Implementation
     MPIX_Neighbor_part_locality_alltoallv_init(alltoallv_send_vals.data(), 
             send_data.counts.data(),
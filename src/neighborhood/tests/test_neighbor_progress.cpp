@@ -0,0 +1,279 @@
+// EXPECT_EQ and ASSERT_EQ are macros
+// EXPECT_EQ test execution and continues even if there is a failure
+// ASSERT_EQ test execution and aborts if there is a failure
+// The ASSERT_* variants abort the program execution if an assertion fails
+// while EXPECT_* variants continue with the run.
+
+
+#include "gtest/gtest.h"
+#include "mpi_advance.h"
+#include <mpi.h>
+#include <math.h>
+#include <stdlib.h>
+#include <iostream>
+#include <assert.h>
+#include <vector>
+#include <set>
+
+#include "neighbor_data.hpp"
+
+int main(int argc, char** argv)
+{
+    // Progress thread needs MPI_THREAD_MULTIPLE
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+    ::testing::InitGoogleTest(&argc, argv);
+    int temp=RUN_ALL_TESTS();
+    MPI_Finalize();
+    return temp;
+} // end of main() //
+
+
+TEST(ProgressThreadTest, TestsInTests)
+{
+    // Get MPI Information
+    int rank, num_procs;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+
+    // Initial communication info (standard)
+    int local_size = 10000; // Number of variables each rank stores
+    MPIX_Data<int> send_data;
+    MPIX_Data<int> recv_data;
+    form_initial_communicator(local_size, &send_data, &recv_data);
+    std::vector<long> global_send_idx(send_data.size_msgs);
+    std::vector<long> global_recv_idx(recv_data.size_msgs);
+    form_global_indices(local_size, send_data, recv_data, global_send_idx, global_recv_idx);
+
+    // Test correctness of communication
+    std::vector<int> std_recv_vals(recv_data.size_msgs);
+    std::vector<int> persistent_recv_vals(recv_data.size_msgs);
+    std::vector<int> loc_recv_vals(recv_data.size_msgs);
+
+    std::vector<int> send_vals(local_size);
+    int val = local_size*rank;
+    for (int i = 0; i < local_size; i++)
+    {
+        send_vals[i] = val++;
+    }
+
+    std::vector<int> alltoallv_send_vals(send_data.size_msgs);
+    for (int i = 0; i < send_data.size_msgs; i++)
+        alltoallv_send_vals[i] = send_vals[send_data.indices[i]];
+
+    MPI_Comm std_comm;
+    MPIX_Comm* neighbor_comm;
+
+    MPIX_Info* xinfo;
+    MPIX_Info_init(&xinfo);
+    xinfo->progress_thread = 1;
+
+    // Standard MPI Dist Graph Create
+    MPI_Dist_graph_create_adjacent(MPI_COMM_WORLD,
+            recv_data.num_msgs,
+            recv_data.procs.data(), 
+            recv_data.counts.data(),
+            send_data.num_msgs, 
+            send_data.procs.data(),
+            send_data.counts.data(),
+            MPI_INFO_NULL, 
+            0, 
+            &std_comm);
+
+    // MPI Advance Dist Graph Create
+    MPIX_Dist_graph_create_adjacent(MPI_COMM_WORLD,
+            recv_data.num_msgs, 
+            recv_data.procs.data(), 
+            recv_data.counts.data(),
+            send_data.num_msgs, 
+            send_data.procs.data(),
+            send_data.counts.data(),
+            MPI_INFO_NULL, 
+            0, 
+            &neighbor_comm);
+
+    // Update Locality : 4 PPN (for single-node tests)
+    update_locality(neighbor_comm, 4);
+
+    // Standard MPI Implementation of Alltoallv
+    int* send_counts = send_data.counts.data();
+    if (send_data.counts.data() == NULL)
+        send_counts = new int[1];
+    int* recv_counts = recv_data.counts.data();
+    if (recv_data.counts.data() == NULL)
+        recv_counts = new int[1];
+    MPI_Neighbor_alltoallv(alltoallv_send_vals.data(), 
+            send_counts,
+            send_data.indptr.data(), 
+            MPI_INT,
+            std_recv_vals.data(), 
+            recv_counts,
+            recv_data.indptr.data(), 
+            MPI_INT,
+            std_comm);
+    if (send_data.counts.data() == NULL)
+        delete[] send_counts;
+    if (recv_data.counts.data() == NULL)
+        delete[] recv_counts;
+
+    // Standard and locality-aware requests, both driven by the
+    // progress thread (if MPI_THREAD_MULTIPLE is provided)
+    MPIX_Request* requests[2];
+    MPIX_Neighbor_alltoallv_init(alltoallv_send_vals.data(), 
+            send_data.counts.data(),
+            send_data.indptr.data(), 
+            MPI_INT,
+            persistent_recv_vals.data(), 
+            recv_data.counts.data(),
+            recv_data.indptr.data(), 
+            MPI_INT,
+            neighbor_comm, 
+            xinfo,
+            &(requests[0]));
+    MPIX_Neighbor_locality_alltoallv_init(alltoallv_send_vals.data(), 
+            send_data.counts.data(),
+            send_data.indptr.data(), 
+            global_send_idx.data(),
+            MPI_INT,
+            loc_recv_vals.data(), 
+            recv_data.counts.data(),
+            recv_data.indptr.data(), 
+            global_recv_idx.data(),
+            MPI_INT,
+            neighbor_comm, 
+            xinfo,
+            &(requests[1]));
+    ASSERT_EQ(requests[0]->progress_thread, 1);
+    ASSERT_EQ(requests[1]->progress_thread, 1);
+
+    // Repeated exchanges : wait, then poll
+    int flag;
+    for (int iter = 0; iter < 3; iter++)
+    {
+        for (int i = 0; i < recv_data.size_msgs; i++)
+        {
+            persistent_recv_vals[i] = -1;
+            loc_recv_vals[i] = -1;
+        }
+
+        MPIX_Start(requests[0]);
+        MPIX_Start(requests[1]);
+        if (MPIX_Progress_available())
+        {
+            ASSERT_EQ(requests[0]->progress_posted, 1);
+            ASSERT_EQ(requests[1]->progress_posted, 1);
+        }
+
+        if (iter % 2 == 0)
+            MPIX_Waitall(2, requests, MPI_STATUSES_IGNORE);
+        else
+        {
+            flag = 0;
+            while (!flag)
+                MPIX_Testall(2, requests, &flag, MPI_STATUSES_IGNORE);
+        }
+        ASSERT_EQ(requests[0]->progress_posted, 0);
+        ASSERT_EQ(requests[1]->progress_posted, 0);
+
+        for (int i = 0; i < recv_data.size_msgs; i++)
+        {
+            ASSERT_EQ(std_recv_vals[i], persistent_recv_vals[i]);
+            ASSERT_EQ(std_recv_vals[i], loc_recv_vals[i]);
+        }
+    }
+
+    // Requests started in different orders on neighboring ranks :
+    // the progress thread starts both before completing either
+    std::vector<int> second_recv_vals(recv_data.size_msgs);
+    MPIX_Request* order_requests[2];
+    order_requests[0] = requests[0];
+    MPIX_Neighbor_alltoallv_init(alltoallv_send_vals.data(), 
+            send_data.counts.data(),
+            send_data.indptr.data(), 
+            MPI_INT,
+            second_recv_vals.data(), 
+            recv_data.counts.data(),
+            recv_data.indptr.data(), 
+            MPI_INT,
+            neighbor_comm, 
+            xinfo,
+            &(order_requests[1]));
+    for (int i = 0; i < recv_data.size_msgs; i++)
+    {
+        persistent_recv_vals[i] = -1;
+        second_recv_vals[i] = -1;
+    }
+    MPIX_Start(order_requests[rank % 2]);
+    MPIX_Start(order_requests[(rank + 1) % 2]);
+    MPIX_Wait(order_requests[rank % 2], MPI_STATUS_IGNORE);
+    MPIX_Wait(order_requests[(rank + 1) % 2], MPI_STATUS_IGNORE);
+    for (int i = 0; i < recv_data.size_msgs; i++)
+    {
+        ASSERT_EQ(std_recv_vals[i], persistent_recv_vals[i]);
+        ASSERT_EQ(std_recv_vals[i], second_recv_vals[i]);
+    }
+    MPIX_Request_free(&(order_requests[1]));
+
+    // Two locality-aware requests, started in different orders on
+    // neighboring ranks : on-node phases only poll flags in the
+    // request's own segments, so the thread never synchronizes the node
+    std::vector<int> loc_send_vals2(send_data.size_msgs);
+    for (int i = 0; i < send_data.size_msgs; i++)
+        loc_send_vals2[i] = 2*alltoallv_send_vals[i];
+    order_requests[0] = requests[1];
+    MPIX_Neighbor_locality_alltoallv_init(loc_send_vals2.data(), 
+            send_data.counts.data(),
+            send_data.indptr.data(), 
+            global_send_idx.data(),
+            MPI_INT,
+            second_recv_vals.data(), 
+            recv_data.counts.data(),
+            recv_data.indptr.data(), 
+            global_recv_idx.data(),
+            MPI_INT,
+            neighbor_comm, 
+            xinfo,
+            &(order_requests[1]));
+    for (int iter = 0; iter < 2; iter++)
+    {
+        for (int i = 0; i < recv_data.size_msgs; i++)
+        {
+            loc_recv_vals[i] = -1;
+            second_recv_vals[i] = -1;
+        }
+        MPIX_Start(order_requests[rank % 2]);
+        MPIX_Start(order_requests[(rank + 1) % 2]);
+        if (iter == 0)
+        {
+            MPIX_Wait(order_requests[rank % 2], MPI_STATUS_IGNORE);
+            MPIX_Wait(order_requests[(rank + 1) % 2], MPI_STATUS_IGNORE);
+        }
+        else
+        {
+            flag = 0;
+            while (!flag)
+                MPIX_Testall(2, order_requests, &flag, MPI_STATUSES_IGNORE);
+        }
+        for (int i = 0; i < recv_data.size_msgs; i++)
+        {
+            ASSERT_EQ(std_recv_vals[i], loc_recv_vals[i]);
+            ASSERT_EQ(2*std_recv_vals[i], second_recv_vals[i]);
+        }
+    }
+    MPIX_Request_free(&(order_requests[1]));
+
+    // Free while still in progress (waits for completion)
+    if (MPIX_Progress_available())
+    {
+        MPIX_Start(requests[0]);
+        MPIX_Start(requests[1]);
+    }
+    MPIX_Request_free(&(requests[0]));
+    MPIX_Request_free(&(requests[1]));
+
+    MPIX_Info_free(&xinfo);
+    MPIX_Comm_free(&neighbor_comm);
+    MPI_Comm_free(&std_comm);
+
+}
+
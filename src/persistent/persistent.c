@@ -1,4 +1,5 @@
 #include "persistent.h"
+#include "progress.h"
 
 void init_request(MPIX_Request** request_ptr)
 {   
@@ -6,19 +7,34 @@ void init_request(MPIX_Request** request_ptr)
     
     request->locality = NULL;
     
-    request->local_L_n_msgs = 0;
-    request->local_S_n_msgs = 0;
-    request->local_R_n_msgs = 0;
     request->global_n_msgs = 0;
-    
-    request->local_L_requests = NULL;
-    request->local_S_requests = NULL;
-    request->local_R_requests = NULL;
     request->global_requests = NULL;
     
     request->recv_size = 0;
+    request->sendtype = MPI_DATATYPE_NULL;
+    request->recvtype = MPI_DATATYPE_NULL;
+    request->packed_type = MPI_DATATYPE_NULL;
     request->block_size = 1;
 
+    request->start_function = NULL;
+    request->wait_function = NULL;
+    request->test_function = NULL;
+
+    request->n_steps = 0;
+    request->current_step = 0;
+    request->n_step_msgs = 0;
+    request->step_requests = NULL;
+    request->schedule = NULL;
+    request->step_function = NULL;
+    request->free_function = NULL;
+
+    request->phase = MPIX_PHASE_COMPLETE;
+
+    request->progress_thread = 0;
+    request->progress_posted = 0;
+    request->progress_done = 0;
+    request->progress_next = NULL;
+
 #ifdef GPU
     request->cpu_sendbuf = NULL;
     request->cpu_recvbuf = NULL;
@@ -46,6 +62,12 @@ int MPIX_Start(MPIX_Request* request)
     if (request == NULL)
         return 0;
 
+    request->phase = MPIX_PHASE_LOCAL_S;
+
+    // Return immediately : the progress thread starts and completes it
+    if (request->progress_thread && MPIX_Progress_available())
+        return MPIX_Progress_post(request);
+
     mpix_start_ftn start_function = (mpix_start_ftn)(request->start_function);
     return start_function(request);
 }
@@ -61,33 +83,143 @@ int MPIX_Wait(MPIX_Request* request, MPI_Status* status)
     if (request == NULL)
         return 0;
 
+    if (request->progress_posted)
+    {
+        int ierr = MPIX_Progress_wait(request);
+        request->phase = MPIX_PHASE_COMPLETE;
+        return ierr;
+    }
+
+    if (request->phase == MPIX_PHASE_COMPLETE)
+        return 0;
+
     mpix_wait_ftn wait_function = (mpix_wait_ftn)(request->wait_function);
-    return wait_function(request, status);
+    int ierr = wait_function(request, status);
+    request->phase = MPIX_PHASE_COMPLETE;
+    return ierr;
 }
 
 
-int MPIX_Request_free(MPIX_Request** request_ptr)
+// Poll request without blocking, flag is set once complete
+// Requests without a test_function complete through MPIX_Wait
+int MPIX_Test(MPIX_Request* request, int* flag, MPI_Status* status)
 {
-    MPIX_Request* request = *request_ptr;
+    *flag = 1;
+    if (request == NULL)
+        return 0;
 
-    if (request->local_L_n_msgs)
+    if (request->progress_posted)
     {
-        for (int i = 0; i < request->local_L_n_msgs; i++)
-            MPI_Request_free(&(request->local_L_requests[i]));
-        free(request->local_L_requests);
+        int ierr = MPIX_Progress_test(request, flag);
+        if (*flag)
+            request->phase = MPIX_PHASE_COMPLETE;
+        return ierr;
     }
-    if (request->local_S_n_msgs)
+
+    if (request->phase == MPIX_PHASE_COMPLETE)
+        return 0;
+
+    if (request->test_function == NULL)
+        return MPIX_Wait(request, status);
+
+    mpix_test_ftn test_function = (mpix_test_ftn)(request->test_function);
+    int ierr = test_function(request, flag, status);
+    if (*flag)
+        request->phase = MPIX_PHASE_COMPLETE;
+    return ierr;
+}
+
+
+// Wait for each request in turn
+int MPIX_Waitall(int count, MPIX_Request* requests[], MPI_Status statuses[])
+{
+    int ierr = 0;
+    for (int i = 0; i < count; i++)
+        ierr += MPIX_Wait(requests[i], statuses == MPI_STATUSES_IGNORE
+                ? MPI_STATUS_IGNORE : &(statuses[i]));
+    return ierr;
+}
+
+
+// Poll every request (each advances as far as it can without
+// blocking), flag is set once all are complete
+int MPIX_Testall(int count, MPIX_Request* requests[], int* flag,
+        MPI_Status statuses[])
+{
+    int ierr = 0;
+    int done;
+
+    *flag = 1;
+    for (int i = 0; i < count; i++)
     {
-        for (int i = 0; i < request->local_S_n_msgs; i++)
-            MPI_Request_free(&(request->local_S_requests[i]));
-        free(request->local_S_requests);
+        ierr += MPIX_Test(requests[i], &done, statuses == MPI_STATUSES_IGNORE
+                ? MPI_STATUS_IGNORE : &(statuses[i]));
+        if (!done)
+            *flag = 0;
     }
-    if (request->local_R_n_msgs)
+    return ierr;
+}
+
+
+// Advance nonblocking collective schedule
+// While messages of current step are complete (waiting for them if 
+// blocking), move to next step, which completes local work and
+// posts the next messages
+int schedule_progress(MPIX_Request* request, int blocking, int* flag)
+{
+    int ierr = 0;
+    int done;
+
+    mpix_step_ftn step_function = (mpix_step_ftn)(request->step_function);
+    while (request->current_step < request->n_steps)
     {
-        for (int i = 0; i < request->local_R_n_msgs; i++)
-            MPI_Request_free(&(request->local_R_requests[i]));
-        free(request->local_R_requests);
+        if (request->n_step_msgs)
+        {
+            if (blocking)
+                ierr += MPI_Waitall(request->n_step_msgs, request->step_requests,
+                        MPI_STATUSES_IGNORE);
+            else
+            {
+                ierr += MPI_Testall(request->n_step_msgs, request->step_requests,
+                        &done, MPI_STATUSES_IGNORE);
+                if (!done)
+                {
+                    *flag = 0;
+                    return ierr;
+                }
+            }
+        }
+
+        request->current_step++;
+        request->n_step_msgs = 0;
+        ierr += step_function(request);
     }
+
+    *flag = 1;
+    return ierr;
+}
+
+int schedule_wait(MPIX_Request* request, MPI_Status* status)
+{
+    (void)status;
+    int flag;
+    return schedule_progress(request, 1, &flag);
+}
+
+int schedule_test(MPIX_Request* request, int* flag, MPI_Status* status)
+{
+    (void)status;
+    return schedule_progress(request, 0, flag);
+}
+
+int MPIX_Request_free(MPIX_Request** request_ptr)
+{
+    MPIX_Request* request = *request_ptr;
+
+    // Progress thread may still be using the request
+    if (request->progress_posted)
+        MPIX_Progress_wait(request);
+
     if (request->global_n_msgs)
     {
         for (int i = 0; i < request->global_n_msgs; i++)
@@ -98,6 +230,17 @@ int MPIX_Request_free(MPIX_Request** request_ptr)
     // If Locality-Aware
     if (request->locality != NULL)
         destroy_locality_comm(request->locality);
+    if (request->packed_type != MPI_DATATYPE_NULL)
+        MPI_Type_free(&(request->packed_type));
+
+    // If nonblocking collective
+    if (request->schedule != NULL)
+    {
+        mpix_free_ftn free_function = (mpix_free_ftn)(request->free_function);
+        free_function(request->schedule);
+    }
+    if (request->step_requests != NULL)
+        free(request->step_requests);
 
 // TODO : for safety, may want to check if allocated with malloc?
 #ifdef GPU // Assuming cpu buffers allocated in pinned memory
@@ -11,18 +11,9 @@ extern "C"
 
 typedef struct _MPIX_Request
 {
-    // Message counts
-    // Will only use global unless locality-aware
-    int local_L_n_msgs;
-    int local_S_n_msgs;
-    int local_R_n_msgs;
+    // Inter-process messages (on-node phases of locality-aware
+    // requests go through node-shared memory, see LocalityShm)
     int global_n_msgs;
-
-    // MPI Request arrays
-    // Will only use global unless locality-aware
-    MPI_Request* local_L_requests;
-    MPI_Request* local_S_requests;
-    MPI_Request* local_R_requests;
     MPI_Request* global_requests;
 
     // Pointer to locality communication, only for locality-aware
@@ -35,6 +26,13 @@ typedef struct _MPIX_Request
     // Number of bytes per receive object (for locality-aware)
     int recv_size;
 
+    // Types of sendbuf and recvbuf, and of the packed values in
+    // internal buffers (for locality-aware, packed_type is owned
+    // by the request)
+    MPI_Datatype sendtype;
+    MPI_Datatype recvtype;
+    MPI_Datatype packed_type;
+
     // Block size : for strided/blocked communication
     int block_size;
 
@@ -50,10 +48,57 @@ typedef struct _MPIX_Request
     // Keep track of which start/wait functions to call for given request
     void* start_function;
     void* wait_function;   
+    void* test_function;
+
+    // Nonblocking collectives (e.g. MPIX_Ialltoall) : schedule of
+    // n_steps steps, each posting n_step_msgs step_requests
+    //  - step_function : completes local work of step current_step-1
+    //      and posts messages of current_step
+    //  - schedule : algorithm state, released by free_function
+    int n_steps;
+    int current_step;
+    int n_step_msgs;
+    MPI_Request* step_requests;
+    void* schedule;
+    void* step_function;
+    void* free_function;
+
+    // Phase cursor (MPIX_Phase) : current phase of a started request.
+    // MPIX_PHASE_COMPLETE when inactive or complete, so completed
+    // requests are never waited on twice
+    int phase;
+
+    // Background progress (see progress.h) : if progress_thread is
+    // set, MPIX_Start hands the request to the progress thread
+    //  - progress_posted : owned by the caller, set until the
+    //      request is waited on (or tested) once complete
+    //  - progress_done, progress_next : owned by the progress
+    //      thread (queue link)
+    int progress_thread;
+    int progress_posted;
+    int progress_done;
+    struct _MPIX_Request* progress_next;
 } MPIX_Request;
 
+// Phases of a started request, in order
+//  - Locality-aware neighbor requests move through each
+//      phase as its data arrives (see neighbor_shm_progress)
+//  - Standard neighbor requests stay in MPIX_PHASE_GLOBAL,
+//      and other requests in MPIX_PHASE_LOCAL_S, until complete
+enum MPIX_Phase
+{
+    MPIX_PHASE_LOCAL_S,
+    MPIX_PHASE_GLOBAL,
+    MPIX_PHASE_LOCAL_R,
+    MPIX_PHASE_LOCAL_L,
+    MPIX_PHASE_COMPLETE
+};
+
 typedef int (*mpix_start_ftn)(MPIX_Request* request);
 typedef int (*mpix_wait_ftn)(MPIX_Request* request, MPI_Status* status);
+typedef int (*mpix_test_ftn)(MPIX_Request* request, int* flag, MPI_Status* status);
+typedef int (*mpix_step_ftn)(MPIX_Request* request);
+typedef void (*mpix_free_ftn)(void* schedule);
 
 // Starting locality-aware requests
 // 1. Start Local_L
@@ -68,8 +113,28 @@ int MPIX_Start(MPIX_Request* request);
 // 3. Wait for local_L
 int MPIX_Wait(MPIX_Request* request, MPI_Status* status);
 
+// Poll request without blocking, flag is set once complete
+// Requests without a test_function complete through MPIX_Wait
+int MPIX_Test(MPIX_Request* request, int* flag, MPI_Status* status);
+
+// Wait for (or poll) each of count requests
+//  - statuses may be MPI_STATUSES_IGNORE
+//  - MPIX_Testall sets flag once all are complete.  Requests
+//      that complete in an earlier call stay complete, so
+//      polling may continue until flag is set
+int MPIX_Waitall(int count, MPIX_Request* requests[], MPI_Status statuses[]);
+int MPIX_Testall(int count, MPIX_Request* requests[], int* flag,
+        MPI_Status statuses[]);
+
 int MPIX_Request_free(MPIX_Request** request);
 
+// Nonblocking collective schedules
+// 1. Wait (or test) for requests of current step
+// 2. Advance current_step, calling step_function
+int schedule_progress(MPIX_Request* request, int blocking, int* flag);
+int schedule_wait(MPIX_Request* request, MPI_Status* status);
+int schedule_test(MPIX_Request* request, int* flag, MPI_Status* status);
+
 void init_request(MPIX_Request** request_ptr);
 void allocate_requests(int n_requests, MPI_Request** request_ptr);
 void destroy_request(MPIX_Request* request);
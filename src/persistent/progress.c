@@ -0,0 +1,187 @@
+#include "progress.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+// Queue of posted requests not yet started (linked through
+// progress_next), and whether the progress thread is running.
+// All guarded by progress_lock
+static pthread_mutex_t progress_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t progress_posted = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t progress_completed = PTHREAD_COND_INITIALIZER;
+static MPIX_Request* progress_head = NULL;
+static MPIX_Request* progress_tail = NULL;
+static int progress_running = 0;
+static pthread_t progress_thread;
+static pthread_once_t progress_once = PTHREAD_ONCE_INIT;
+
+// Mark request complete, waking waiting callers
+static void progress_complete(MPIX_Request* request)
+{
+    pthread_mutex_lock(&progress_lock);
+    request->progress_done = 1;
+    pthread_cond_broadcast(&progress_completed);
+    pthread_mutex_unlock(&progress_lock);
+}
+
+// Start every posted request (in post order) before completing any,
+// then poll all started requests (test_function) until the next are
+// posted, as MPI allows persistent requests to complete in any order.
+// Requests without a test_function complete with wait_function.
+// Runs until stopped, once every request is complete
+static void* progress_loop(void* arg)
+{
+    (void)arg;
+
+    MPIX_Request** active = NULL;
+    int n_active = 0;
+    int capacity = 0;
+    MPIX_Request* request;
+    MPIX_Request* next;
+    int flag;
+
+    while (1)
+    {
+        // Take posted requests (sleeping only if none are active)
+        pthread_mutex_lock(&progress_lock);
+        while (progress_running && progress_head == NULL && n_active == 0)
+            pthread_cond_wait(&progress_posted, &progress_lock);
+        if (progress_head == NULL && n_active == 0)
+        {
+            pthread_mutex_unlock(&progress_lock);
+            break;
+        }
+        request = progress_head;
+        progress_head = NULL;
+        progress_tail = NULL;
+        pthread_mutex_unlock(&progress_lock);
+
+        for (; request != NULL; request = next)
+        {
+            next = request->progress_next;
+
+            if (n_active == capacity)
+            {
+                capacity = capacity ? 2*capacity : 4;
+                active = (MPIX_Request**)realloc(active, capacity*sizeof(MPIX_Request*));
+            }
+            active[n_active++] = request;
+
+            mpix_start_ftn start_function = (mpix_start_ftn)(request->start_function);
+            start_function(request);
+        }
+
+        for (int i = 0; i < n_active; )
+        {
+            request = active[i];
+            if (request->test_function)
+            {
+                mpix_test_ftn test_function = (mpix_test_ftn)(request->test_function);
+                test_function(request, &flag, MPI_STATUS_IGNORE);
+            }
+            else
+            {
+                mpix_wait_ftn wait_function = (mpix_wait_ftn)(request->wait_function);
+                wait_function(request, MPI_STATUS_IGNORE);
+                flag = 1;
+            }
+
+            if (flag)
+            {
+                progress_complete(request);
+                active[i] = active[--n_active];
+            }
+            else i++;
+        }
+
+        if (n_active)
+            sched_yield();
+    }
+
+    free(active);
+
+    return NULL;
+}
+
+// Delete callback of the MPI_COMM_SELF attribute : stops the progress
+// thread at the start of MPI_Finalize, once queued requests complete
+static int progress_stop(MPI_Comm comm, int keyval, void* attribute_val,
+        void* extra_state)
+{
+    (void)comm;
+    (void)keyval;
+    (void)attribute_val;
+    (void)extra_state;
+
+    pthread_mutex_lock(&progress_lock);
+    progress_running = 0;
+    pthread_cond_signal(&progress_posted);
+    pthread_mutex_unlock(&progress_lock);
+
+    pthread_join(progress_thread, NULL);
+
+    return MPI_SUCCESS;
+}
+
+// Create the progress thread, and the attribute stopping it (once)
+static void progress_init(void)
+{
+    int keyval;
+
+    progress_running = 1;
+    pthread_create(&progress_thread, NULL, progress_loop, NULL);
+
+    MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, progress_stop, &keyval, NULL);
+    MPI_Comm_set_attr(MPI_COMM_SELF, keyval, NULL);
+}
+
+int MPIX_Progress_available()
+{
+    int provided;
+    MPI_Query_thread(&provided);
+    return provided == MPI_THREAD_MULTIPLE;
+}
+
+int MPIX_Progress_post(MPIX_Request* request)
+{
+    pthread_once(&progress_once, progress_init);
+
+    request->progress_posted = 1;
+
+    pthread_mutex_lock(&progress_lock);
+    request->progress_done = 0;
+    request->progress_next = NULL;
+    if (progress_tail == NULL)
+        progress_head = request;
+    else
+        progress_tail->progress_next = request;
+    progress_tail = request;
+    pthread_cond_signal(&progress_posted);
+    pthread_mutex_unlock(&progress_lock);
+
+    return MPI_SUCCESS;
+}
+
+int MPIX_Progress_wait(MPIX_Request* request)
+{
+    pthread_mutex_lock(&progress_lock);
+    while (!request->progress_done)
+        pthread_cond_wait(&progress_completed, &progress_lock);
+    pthread_mutex_unlock(&progress_lock);
+
+    request->progress_posted = 0;
+
+    return MPI_SUCCESS;
+}
+
+int MPIX_Progress_test(MPIX_Request* request, int* flag)
+{
+    pthread_mutex_lock(&progress_lock);
+    *flag = request->progress_done;
+    pthread_mutex_unlock(&progress_lock);
+
+    if (*flag)
+        request->progress_posted = 0;
+
+    return MPI_SUCCESS;
+}
@@ -0,0 +1,45 @@
+#ifndef MPI_ADVANCE_PROGRESS_H
+#define MPI_ADVANCE_PROGRESS_H
+
+#include "persistent.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**************************************************
+ * Progress Thread
+ *  - One helper thread per process, created when
+ *      the first request is posted, and joined in
+ *      MPI_Finalize
+ *  - Posted requests are started in post order, then
+ *      polled together (test_function) until complete,
+ *      so every phase (local_S, global, local_R,
+ *      local_L) advances while the application
+ *      computes, and requests may complete in any
+ *      order
+ *  - The thread makes no collective calls : on-node
+ *      phases of locality-aware requests poll flags
+ *      in their own node-shared segments, so the
+ *      application may use the same communicators
+ *      concurrently
+ *  - Needs MPI_THREAD_MULTIPLE (otherwise requests
+ *      are started and completed in the caller)
+ *************************************************/
+
+// Returns 1 if the progress thread can be used
+int MPIX_Progress_available();
+
+// Hand started request to the progress thread (MPIX_Start)
+int MPIX_Progress_post(MPIX_Request* request);
+
+// Wait for (or poll) a posted request
+int MPIX_Progress_wait(MPIX_Request* request);
+int MPIX_Progress_test(MPIX_Request* request, int* flag);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,367 @@
+#include "datatype.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+// Attribute holding each datatype's MPIX_Flat_type
+// Keyval creation and attribute lookup/caching are guarded by
+// flat_lock : threaded collectives and the progress thread
+// pack and unpack concurrently
+static int flat_keyval = MPI_KEYVAL_INVALID;
+static pthread_mutex_t flat_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int type_flatten(MPI_Datatype type, MPIX_Flat_type** flat_ptr);
+
+static int flat_delete(MPI_Datatype type, int keyval, void* attr, void* extra_state)
+{
+    (void)type;
+    (void)keyval;
+    (void)extra_state;
+
+    MPIX_Flat_type* flat = (MPIX_Flat_type*)attr;
+    free(flat->offsets);
+    free(flat->lengths);
+    free(flat);
+    return MPI_SUCCESS;
+}
+
+// Append a block, merging it with the previous block if adjacent
+static void add_block(MPIX_Flat_type* flat, int* capacity,
+        MPI_Aint offset, MPI_Aint length)
+{
+    if (length == 0)
+        return;
+
+    int n = flat->n_blocks;
+    if (n && flat->offsets[n-1] + flat->lengths[n-1] == offset)
+    {
+        flat->lengths[n-1] += length;
+        return;
+    }
+
+    if (n == *capacity)
+    {
+        *capacity *= 2;
+        flat->offsets = (MPI_Aint*)realloc(flat->offsets, *capacity*sizeof(MPI_Aint));
+        flat->lengths = (MPI_Aint*)realloc(flat->lengths, *capacity*sizeof(MPI_Aint));
+    }
+    flat->offsets[n] = offset;
+    flat->lengths[n] = length;
+    flat->n_blocks++;
+}
+
+// Append 'count' copies of child, copy i starting at base + i*stride
+// (one block if the copies are back to back)
+static void add_copies(MPIX_Flat_type* flat, int* capacity,
+        const MPIX_Flat_type* child, MPI_Aint base, int count, MPI_Aint stride)
+{
+    if (child->contiguous && stride == child->extent)
+    {
+        add_block(flat, capacity, base, (MPI_Aint)count * child->extent);
+        return;
+    }
+
+    for (int i = 0; i < count; i++)
+        for (int j = 0; j < child->n_blocks; j++)
+            add_block(flat, capacity, base + i*stride + child->offsets[j],
+                    child->lengths[j]);
+}
+
+// Flatten type map of 'type' (in type map order) from its combiner
+// and contents.  Returns 0 if combiner is not supported.
+static int flatten_contents(MPI_Datatype type, MPIX_Flat_type* flat, int* capacity)
+{
+    int n_ints, n_aints, n_types, combiner;
+    MPI_Type_get_envelope(type, &n_ints, &n_aints, &n_types, &combiner);
+
+    if (combiner == MPI_COMBINER_NAMED)
+    {
+        add_block(flat, capacity, 0, flat->size);
+        return 1;
+    }
+
+    int* ints = (int*)malloc((n_ints+1)*sizeof(int));
+    MPI_Aint* aints = (MPI_Aint*)malloc((n_aints+1)*sizeof(MPI_Aint));
+    MPI_Datatype* types = (MPI_Datatype*)malloc((n_types+1)*sizeof(MPI_Datatype));
+    MPIX_Flat_type** children = (MPIX_Flat_type**)malloc((n_types+1)*sizeof(MPIX_Flat_type*));
+    MPI_Type_get_contents(type, n_ints, n_aints, n_types, ints, aints, types);
+
+    int flattened = 1;
+    for (int i = 0; i < n_types; i++)
+    {
+        type_flatten(types[i], &(children[i]));
+        if (!children[i]->flattened)
+            flattened = 0;
+    }
+
+    MPIX_Flat_type* child = children[0];
+    if (flattened)
+    {
+        switch (combiner)
+        {
+            case MPI_COMBINER_DUP:
+            case MPI_COMBINER_RESIZED:
+                add_copies(flat, capacity, child, 0, 1, 0);
+                break;
+            case MPI_COMBINER_CONTIGUOUS:
+                add_copies(flat, capacity, child, 0, ints[0], child->extent);
+                break;
+            case MPI_COMBINER_VECTOR:
+                for (int i = 0; i < ints[0]; i++)
+                    add_copies(flat, capacity, child, (MPI_Aint)i * ints[2] * child->extent,
+                            ints[1], child->extent);
+                break;
+            case MPI_COMBINER_HVECTOR:
+                for (int i = 0; i < ints[0]; i++)
+                    add_copies(flat, capacity, child, i * aints[0],
+                            ints[1], child->extent);
+                break;
+            case MPI_COMBINER_INDEXED:
+                for (int i = 0; i < ints[0]; i++)
+                    add_copies(flat, capacity, child, ints[ints[0]+1+i] * child->extent,
+                            ints[1+i], child->extent);
+                break;
+            case MPI_COMBINER_HINDEXED:
+                for (int i = 0; i < ints[0]; i++)
+                    add_copies(flat, capacity, child, aints[i],
+                            ints[1+i], child->extent);
+                break;
+            case MPI_COMBINER_INDEXED_BLOCK:
+                for (int i = 0; i < ints[0]; i++)
+                    add_copies(flat, capacity, child, ints[2+i] * child->extent,
+                            ints[1], child->extent);
+                break;
+            case MPI_COMBINER_HINDEXED_BLOCK:
+                for (int i = 0; i < ints[0]; i++)
+                    add_copies(flat, capacity, child, aints[i],
+                            ints[1], child->extent);
+                break;
+            case MPI_COMBINER_STRUCT:
+                for (int i = 0; i < ints[0]; i++)
+                    add_copies(flat, capacity, children[i], aints[i],
+                            ints[1+i], children[i]->extent);
+                break;
+            default:
+                flattened = 0;
+        }
+    }
+
+    // Derived types returned by MPI_Type_get_contents must be freed
+    int child_ints, child_aints, child_types, child_combiner;
+    for (int i = 0; i < n_types; i++)
+    {
+        MPI_Type_get_envelope(types[i], &child_ints, &child_aints, 
+                &child_types, &child_combiner);
+        if (child_combiner != MPI_COMBINER_NAMED)
+            MPI_Type_free(&(types[i]));
+    }
+
+    free(ints);
+    free(aints);
+    free(types);
+    free(children);
+
+    return flattened;
+}
+
+int MPIX_Type_flatten(MPI_Datatype type, MPIX_Flat_type** flat_ptr)
+{
+    pthread_mutex_lock(&flat_lock);
+    if (flat_keyval == MPI_KEYVAL_INVALID)
+        MPI_Type_create_keyval(MPI_TYPE_NULL_COPY_FN, flat_delete, &flat_keyval, NULL);
+    int ierr = type_flatten(type, flat_ptr);
+    pthread_mutex_unlock(&flat_lock);
+
+    return ierr;
+}
+
+// Find (or form and cache) flattened type, with flat_lock held
+static int type_flatten(MPI_Datatype type, MPIX_Flat_type** flat_ptr)
+{
+    int found;
+    MPIX_Flat_type* flat;
+    MPI_Type_get_attr(type, flat_keyval, &flat, &found);
+    if (found)
+    {
+        *flat_ptr = flat;
+        return MPI_SUCCESS;
+    }
+
+    int capacity = 4;
+    flat = (MPIX_Flat_type*)malloc(sizeof(MPIX_Flat_type));
+    flat->n_blocks = 0;
+    flat->offsets = (MPI_Aint*)malloc(capacity*sizeof(MPI_Aint));
+    flat->lengths = (MPI_Aint*)malloc(capacity*sizeof(MPI_Aint));
+
+    MPI_Aint lb;
+    MPI_Type_get_extent(type, &lb, &(flat->extent));
+    MPI_Type_size_x(type, &(flat->size));
+
+    flat->flattened = flatten_contents(type, flat, &capacity);
+    flat->contiguous = flat->flattened && flat->size == flat->extent
+            && (flat->n_blocks == 0 
+                || (flat->n_blocks == 1 && flat->offsets[0] == 0));
+
+    MPI_Type_set_attr(type, flat_keyval, flat);
+
+    *flat_ptr = flat;
+    return MPI_SUCCESS;
+}
+
+int MPIX_Type_is_contiguous(MPI_Datatype type)
+{
+    MPIX_Flat_type* flat;
+    MPIX_Type_flatten(type, &flat);
+    return flat->contiguous;
+}
+
+MPI_Aint MPIX_Type_extent(MPI_Datatype type)
+{
+    MPIX_Flat_type* flat;
+    MPIX_Type_flatten(type, &flat);
+    return flat->extent;
+}
+
+int MPIX_Type_pack(const void* inbuf, int count, MPI_Datatype type,
+        void* outbuf)
+{
+    MPIX_Flat_type* flat;
+    MPIX_Type_flatten(type, &flat);
+
+    const char* in = (const char*)inbuf;
+    char* out = (char*)outbuf;
+
+    if (flat->contiguous)
+    {
+        memcpy(out, in, (size_t)count * flat->size);
+        return MPI_SUCCESS;
+    }
+
+    if (!flat->flattened)
+    {
+        int position = 0;
+        return MPI_Pack(inbuf, count, type, outbuf, (int)(count * flat->size),
+                &position, MPI_COMM_SELF);
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        const char* element = in + i * flat->extent;
+        for (int j = 0; j < flat->n_blocks; j++)
+        {
+            memcpy(out, element + flat->offsets[j], flat->lengths[j]);
+            out += flat->lengths[j];
+        }
+    }
+
+    return MPI_SUCCESS;
+}
+
+int MPIX_Type_unpack(const void* inbuf, void* outbuf, int count,
+        MPI_Datatype type)
+{
+    MPIX_Flat_type* flat;
+    MPIX_Type_flatten(type, &flat);
+
+    const char* in = (const char*)inbuf;
+    char* out = (char*)outbuf;
+
+    if (flat->contiguous)
+    {
+        memcpy(out, in, (size_t)count * flat->size);
+        return MPI_SUCCESS;
+    }
+
+    if (!flat->flattened)
+    {
+        int position = 0;
+        return MPI_Unpack(inbuf, (int)(count * flat->size), &position,
+                outbuf, count, type, MPI_COMM_SELF);
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        char* element = out + i * flat->extent;
+        for (int j = 0; j < flat->n_blocks; j++)
+        {
+            memcpy(element + flat->offsets[j], in, flat->lengths[j]);
+            in += flat->lengths[j];
+        }
+    }
+
+    return MPI_SUCCESS;
+}
+
+int MPIX_Type_pack_indexed(const void* inbuf, MPI_Datatype type,
+        int n, const int* indices, void* outbuf)
+{
+    MPIX_Flat_type* flat;
+    MPIX_Type_flatten(type, &flat);
+
+    const char* in = (const char*)inbuf;
+    char* out = (char*)outbuf;
+
+    if (flat->contiguous)
+    {
+        for (int i = 0; i < n; i++)
+            memcpy(out + (MPI_Aint)i * flat->size,
+                    in + indices[i] * flat->extent, flat->size);
+        return MPI_SUCCESS;
+    }
+
+    for (int i = 0; i < n; i++)
+        MPIX_Type_pack(in + indices[i] * flat->extent, 1, type,
+                out + (MPI_Aint)i * flat->size);
+
+    return MPI_SUCCESS;
+}
+
+int MPIX_Type_unpack_indexed(const void* inbuf, void* outbuf,
+        MPI_Datatype type, int n, const int* indices)
+{
+    MPIX_Flat_type* flat;
+    MPIX_Type_flatten(type, &flat);
+
+    const char* in = (const char*)inbuf;
+    char* out = (char*)outbuf;
+
+    if (flat->contiguous)
+    {
+        for (int i = 0; i < n; i++)
+            memcpy(out + indices[i] * flat->extent,
+                    in + (MPI_Aint)i * flat->size, flat->size);
+        return MPI_SUCCESS;
+    }
+
+    for (int i = 0; i < n; i++)
+        MPIX_Type_unpack(in + (MPI_Aint)i * flat->size,
+                out + indices[i] * flat->extent, 1, type);
+
+    return MPI_SUCCESS;
+}
+
+int MPIX_Type_copy(const void* src, int srccount, MPI_Datatype srctype,
+        void* dst, int dstcount, MPI_Datatype dsttype)
+{
+    MPIX_Flat_type* src_flat;
+    MPIX_Flat_type* dst_flat;
+    MPIX_Type_flatten(srctype, &src_flat);
+    MPIX_Type_flatten(dsttype, &dst_flat);
+
+    if (src_flat->contiguous && dst_flat->contiguous)
+    {
+        memcpy(dst, src, (size_t)srccount * src_flat->size);
+        return MPI_SUCCESS;
+    }
+    if (dst_flat->contiguous)
+        return MPIX_Type_pack(src, srccount, srctype, dst);
+    if (src_flat->contiguous)
+        return MPIX_Type_unpack(src, dst, dstcount, dsttype);
+
+    char* tmpbuf = (char*)malloc((size_t)srccount * src_flat->size);
+    MPIX_Type_pack(src, srccount, srctype, tmpbuf);
+    MPIX_Type_unpack(tmpbuf, dst, dstcount, dsttype);
+    free(tmpbuf);
+
+    return MPI_SUCCESS;
+}
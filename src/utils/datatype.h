@@ -0,0 +1,72 @@
+#ifndef MPI_ADVANCE_DATATYPE_H
+#define MPI_ADVANCE_DATATYPE_H
+
+#include <mpi.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**************************************************
+ * Datatype Engine
+ *  - Each datatype is flattened once into its type
+ *      map of (offset, length) byte blocks,
+ *      cached as an attribute of the handle (freed
+ *      with the datatype)
+ *  - Adjacent blocks are merged, so contiguous types
+ *      have a single block and are packed, unpacked
+ *      and copied with one memcpy
+ *  - Offsets are relative to the start of an element
+ *      (lower bound included), and element i of a
+ *      buffer starts at i * extent
+ *  - Types built from combiners that are not
+ *      flattened (subarray, darray, ...) fall back
+ *      to MPI_Pack / MPI_Unpack
+ *************************************************/
+typedef struct _MPIX_Flat_type
+{
+    int n_blocks;
+    MPI_Aint* offsets;
+    MPI_Aint* lengths;
+
+    // Bytes of one element (MPI_Type_size_x : may exceed INT_MAX)
+    MPI_Aint extent;
+    MPI_Count size;
+
+    // One block starting at 0 and filling the extent :
+    // 'count' elements are count*size contiguous bytes
+    int contiguous;
+
+    // Type map is known (otherwise use MPI_Pack)
+    int flattened;
+} MPIX_Flat_type;
+
+// Returns cached flattened type (owned by the datatype)
+int MPIX_Type_flatten(MPI_Datatype type, MPIX_Flat_type** flat_ptr);
+int MPIX_Type_is_contiguous(MPI_Datatype type);
+MPI_Aint MPIX_Type_extent(MPI_Datatype type);
+
+// Pack 'count' elements of type from inbuf into count*size bytes
+// of outbuf, or unpack them back
+int MPIX_Type_pack(const void* inbuf, int count, MPI_Datatype type,
+        void* outbuf);
+int MPIX_Type_unpack(const void* inbuf, void* outbuf, int count,
+        MPI_Datatype type);
+
+// Pack elements indices[0..n-1] of buffer (gather), or unpack
+// n packed elements into those indices (scatter)
+int MPIX_Type_pack_indexed(const void* inbuf, MPI_Datatype type,
+        int n, const int* indices, void* outbuf);
+int MPIX_Type_unpack_indexed(const void* inbuf, void* outbuf,
+        MPI_Datatype type, int n, const int* indices);
+
+// Copy typed data (equal type signatures) from src to dst
+int MPIX_Type_copy(const void* src, int srccount, MPI_Datatype srctype,
+        void* dst, int dstcount, MPI_Datatype dsttype);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
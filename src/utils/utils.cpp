@@ -1,6 +1,7 @@
 #include "utils.h"
 #include <algorithm>
 #include <cstring>
+#include <climits>
 #include "mpi.h"
 #include "stdio.h"
 
@@ -17,6 +18,17 @@ int MPIX_Info_init(MPIX_Info** info_ptr)
     xinfo->tag = 159 % xinfo->max_tag;
     xinfo->crs_num_initialized = 0;
     xinfo->crs_size_initialized = 0;
+    xinfo->leaders_per_node = 1;
+    xinfo->leader_by_socket = 0;
+    xinfo->pipeline_bytes = 65536;
+    xinfo->window_size = 32;
+    xinfo->nb_window = 5;
+    xinfo->adaptive_window = 0;
+    xinfo->aggregation_bytes = 4096;
+    xinfo->sparse_percent = 10;
+    xinfo->peer_schedule = 0; // rank + i / rank - i
+    xinfo->progress_thread = 0;
+    xinfo->tuning_file = NULL;
 
     *info_ptr = xinfo;
 
@@ -69,6 +81,31 @@ void reverse(void* recvbuf, int n_bytes, int var_bytes)
 }
 
 
+int big_type_contiguous(MPI_Count count, MPI_Datatype oldtype, 
+        MPI_Datatype* newtype)
+{
+    int n_chunks = count / INT_MAX;
+    int remainder = count % INT_MAX;
+
+    MPI_Datatype chunk_type, remainder_type;
+    MPI_Type_vector(n_chunks, INT_MAX, INT_MAX, oldtype, &chunk_type);
+    MPI_Type_contiguous(remainder, oldtype, &remainder_type);
+
+    MPI_Aint lb, extent;
+    MPI_Type_get_extent(oldtype, &lb, &extent);
+
+    int blocklens[2] = {1, 1};
+    MPI_Aint displs[2] = {0, (MPI_Aint)n_chunks * INT_MAX * extent};
+    MPI_Datatype types[2] = {chunk_type, remainder_type};
+    MPI_Type_create_struct(2, blocklens, displs, types, newtype);
+    MPI_Type_commit(newtype);
+
+    MPI_Type_free(&chunk_type);
+    MPI_Type_free(&remainder_type);
+
+    return MPI_SUCCESS;
+}
+
 
 // Repack Data on Device
 #ifdef GPU
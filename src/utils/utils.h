@@ -1,6 +1,9 @@
 #ifndef MPI_ADVANCE_UTILS_H
 #define MPI_ADVANCE_UTILS_H
 
+#include <mpi.h>
+#include "datatype.h"
+
 #ifdef HIP
 #include "utils_hip.h"
 #endif
@@ -23,6 +26,47 @@ typedef struct _MPIX_Info
     int max_tag;
     int crs_num_initialized;
     int crs_size_initialized;
+
+    // Multi-leader aggregation for locality-aware collectives
+    // (see MPIX_Comm_leader_init)
+    int leaders_per_node;
+    int leader_by_socket;
+
+    // Chunk size (bytes per process pair) for alltoall_pipelined_loc
+    int pipeline_bytes;
+
+    // Two separate in-flight windows :
+    //  - window_size : fixed window of the equal-block alltoalls
+    //      (alltoall_nonblocking_window, MPIX_Ialltoall(v) rounds),
+    //      default 32
+    //  - nb_window : window of alltoallv_pairwise_nonblocking and
+    //      alltoallv_waitany in MPIX_Alltoallv, default 5 (uneven
+    //      blocks favor fewer messages in flight), adapted from
+    //      measured completion rates if adaptive_window is set
+    //      (see MPIX_Window_update)
+    int window_size;
+    int nb_window;
+    int adaptive_window;
+
+    // Largest block (bytes) aggregated on-node by alltoallv_hybrid_loc
+    // (larger blocks are sent directly)
+    int aggregation_bytes;
+
+    // MPIX_Alltoallv uses alltoallv_sparse when fewer than
+    // sparse_percent % of all counts are non-zero (default 10,
+    // 0 : never)
+    int sparse_percent;
+
+    // Order of pairwise exchanges (PeerSchedule, locality/topology.h)
+    int peer_schedule;
+
+    // Persistent neighbor requests are driven by the progress
+    // thread, so MPIX_Start returns immediately (see progress.h)
+    int progress_thread;
+
+    // Path to algorithm tuning table (see collective/tuning.h)
+    // If NULL, MPIX_TUNING_FILE environment variable is used
+    const char* tuning_file;
 } MPIX_Info;
 
 int MPIX_Info_init(MPIX_Info** info);
@@ -51,6 +95,12 @@ void rotate(void* ref, int new_start_byte, int end_byte);
 void reverse(void* recvbuf, int n_bytes, int var_bytes);
 void repack(int size_i, int size_j, int size_k, char* sendbuf, char* recvbuf);
 
+// Contiguous datatype of 'count' elements, for counts beyond INT_MAX
+// (INT_MAX-element chunks, followed by the remainder).  Committed, 
+// and must be freed with MPI_Type_free
+int big_type_contiguous(MPI_Count count, MPI_Datatype oldtype, 
+        MPI_Datatype* newtype);
+
 #ifdef __cplusplus
 }
 #endif